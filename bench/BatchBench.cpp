@@ -0,0 +1,112 @@
+/**
+ * @file BatchBench.cpp
+ * @brief Benchmarks the throughput of verifying many proof graphs from json
+ * @details usage: BatchBench [graphs] [nodes per graph] [max threads]
+ * Builds the json of graphs (default 2000) of about nodes (default 200)
+ * each, conjunctions of assumptions and their eliminations with some wrong
+ * steps, as submissions of a few exercises. Verifies them one by one with
+ * newProofGraph and verifyProofGraph, then with verifyBatch on 1, 2, 4, ...
+ * up to max threads (default one per core), and last with a VerifyCache
+ * shared by the batch. Prints graphs per second for each.
+ */
+
+#include<chrono>
+#include<memory>
+#include<random>
+#include<string>
+#include<thread>
+#include<vector>
+#include<iostream>
+#include<string_view>
+
+#include"verify.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/** @return the json of a random proof graph, the same for the same seed */
+std::string randomProofGraph(size_t size, unsigned seed){
+    std::mt19937 rng(seed);
+    std::string nodes, links;
+    std::vector<std::string> formulas;
+    auto addNode = [&](const std::string& formula, const std::string& justification){
+        nodes += std::string(formulas.empty() ? "" : ",") + "{\"id\": " + std::to_string(formulas.size()) +
+                 ", \"formula\": \"" + formula + "\", \"justification\": \"" + justification + "\"}";
+        formulas.push_back(formula);
+        return formulas.size() - 1;
+    };
+    auto addLink = [&](size_t from, size_t to){
+        links += std::string(links.empty() ? "" : ",") + "{\"from\": " + std::to_string(from) +
+                 ", \"to\": " + std::to_string(to) + "}";
+    };
+    std::vector<size_t> atoms;
+    for(size_t i = 0; i < size / 4 + 2; i++){
+        atoms.push_back(addNode("P" + std::to_string(i), "Assumption"));
+    }
+    while(formulas.size() < size){
+        size_t left = atoms[rng() % atoms.size()];
+        size_t right = atoms[rng() % atoms.size()];
+        size_t conjunction = addNode("(and " + formulas[left] + " " + formulas[right] + ")", "AndIntro");
+        addLink(left, conjunction);
+        addLink(right, conjunction);
+        size_t elim = addNode(rng() % 8 == 0 ? "Q" : formulas[left], "AndElim");
+        addLink(conjunction, elim);
+        atoms.push_back(elim);
+    }
+    return "{\"nodes\": [" + nodes + "], \"links\": [" + links + "]}";
+}
+
+double millisecondsSince(Clock::time_point start){
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv){
+    size_t graphs = argc > 1 ? std::stoul(argv[1]) : 2000;
+    size_t nodes = argc > 2 ? std::stoul(argv[2]) : 200;
+    size_t maxThreads = argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+
+    //Submissions of 10 exercises
+    std::vector<std::string> jsons;
+    for(size_t i = 0; i < graphs; i++){
+        jsons.push_back(randomProofGraph(nodes, i % 10));
+    }
+    std::vector<std::string_view> views(jsons.begin(), jsons.end());
+
+    std::vector<std::string> expected;
+    auto start = Clock::now();
+    for(const std::string& json : jsons){
+        std::unique_ptr<ProofGraph> graph(newProofGraph(json));
+        expected.push_back(verifyProofGraph(*graph));
+    }
+    double loopTime = millisecondsSince(start);
+    std::cout << "loop: " << graphs << " graphs in " << loopTime << " ms, "
+              << graphs * 1000 / loopTime << " graphs/s\n";
+
+    auto run = [&](size_t threads, VerifyCache* cache){
+        auto start = Clock::now();
+        std::vector<BatchResult> results = verifyBatch(views, threads, cache);
+        double time = millisecondsSince(start);
+        for(size_t i = 0; i < graphs; i++){
+            if(!results[i].error.empty() || results[i].results != expected[i]){
+                std::cerr << "batch results differ for graph " << i << "\n";
+                return false;
+            }
+        }
+        std::cout << "batch" << (cache ? " with cache" : "") << ": " << graphs << " graphs, " << threads
+                  << " threads in " << time << " ms, " << graphs * 1000 / time << " graphs/s, speedup "
+                  << loopTime / time << "\n";
+        return true;
+    };
+    for(size_t threads = 1; threads <= maxThreads; threads *= 2){
+        if(!run(threads, nullptr)){
+            return 1;
+        }
+    }
+    VerifyCache cache;
+    if(!run(maxThreads, &cache)){
+        return 1;
+    }
+    VerifyCache::Stats stats = cache.stats();
+    std::cout << "cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+              << stats.evictions << " evictions\n";
+    return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file BinaryBench.cpp
+ * @brief Compares loading formulae from S-Expressions and from binary images
+ * @details usage: BinaryBench [formulae] [depth]
+ * Generates a corpus of random first order formulae, then times parsing
+ * their S-Expressions against decoding a binary image of them from memory
+ * and from a memory mapped file.
+ */
+
+#include<chrono>
+#include<cstdio>
+#include<random>
+#include<string>
+#include<vector>
+#include<iostream>
+
+#include"Binary.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+double time(const std::string& name, F f){
+    Clock::time_point start = Clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    std::cout<<name<<": "<<elapsed.count()<<" ms"<<std::endl;
+    return elapsed.count();
+}
+
+std::string randomTerm(int depth, std::mt19937& rng){
+    if(depth == 0 || rng() % 3 == 0){
+        return "c" + std::to_string(rng() % 16);
+    }
+    return "(f" + std::to_string(rng() % 4) + " " + randomTerm(depth - 1, rng) + " " +
+           randomTerm(depth - 1, rng) + ")";
+}
+
+std::string randomFormula(int depth, std::mt19937& rng){
+    static const char* connectives[] = {"and", "or", "if", "iff"};
+    if(depth == 0){
+        return "(P" + std::to_string(rng() % 8) + " " + randomTerm(2, rng) + ")";
+    }
+    switch(rng() % 6){
+        case 0:
+            return "(not " + randomFormula(depth - 1, rng) + ")";
+        case 1:
+            return "(forall x" + std::to_string(rng() % 4) + " " + randomFormula(depth - 1, rng) + ")";
+        default:
+            return "(" + std::string(connectives[rng() % 4]) + " " + randomFormula(depth - 1, rng) +
+                   " " + randomFormula(depth - 1, rng) + ")";
+    }
+}
+
+int main(int argc, char** argv){
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 10000;
+    int depth = argc > 2 ? std::stoi(argv[2]) : 8;
+    std::mt19937 rng(1);
+
+    std::vector<std::string> corpus;
+    size_t characters = 0;
+    for(size_t i = 0; i < count; i++){
+        corpus.push_back(randomFormula(depth, rng));
+        characters += corpus.back().size();
+    }
+
+    FormulaList formulae;
+    time("parse S-Expressions", [&](){
+        for(const std::string& expr : corpus){
+            formulae.push_back(fromSExpressionString(expr));
+        }
+    });
+    BinaryBuffer image;
+    time("serialize", [&](){ image = serialize(formulae); });
+    std::cout<<image.size() * 4<<" image bytes without sharing"<<std::endl;
+    time("serialize with sharing", [&](){ image = serialize(formulae, true); });
+    std::cout<<characters<<" characters, "<<image.size() * 4<<" image bytes"<<std::endl;
+
+    FormulaList loaded;
+    double ms = time("deserialize", [&](){ loaded = deserializeAll(image); });
+    std::cout<<image.size() * 4 / ms / 1e3<<" MB/s"<<std::endl;
+    for(Formula* formula : loaded){
+        delete formula;
+    }
+
+    std::string path = "BinaryBench.slb";
+    writeBinaryFile(path, image);
+    time("map and deserialize", [&](){
+        MappedBinaryFile file(path);
+        loaded = deserializeAll(file.words());
+    });
+    std::remove(path.c_str());
+    for(Formula* formula : loaded){
+        delete formula;
+    }
+    for(Formula* formula : formulae){
+        delete formula;
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * @file CongruenceBench.cpp
+ * @brief Benchmarks the congruence closure on random ground equations
+ * @details usage: CongruenceBench [constants] [seed]
+ * For problems of doubling size up to constants, asserts random equations
+ * between constants and between nested applications of a few unary and
+ * binary functions, then times queries between pairs of random terms of the
+ * same shape and the explanations of those that are entailed.
+ * Near linear scaling shows as a roughly constant time per equation.
+ */
+
+#include<chrono>
+#include<random>
+#include<string>
+#include<vector>
+#include<iostream>
+
+#include"Congruence.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/** @return a random term with up to depth nested applications over constants */
+Term* randomTerm(size_t constants, int depth, std::mt19937& rng){
+    if(depth == 0 || rng() % 3 == 0){
+        return Const("c" + std::to_string(rng() % constants));
+    }
+    switch(rng() % 3){
+        case 0: return Func("f", {randomTerm(constants, depth - 1, rng), randomTerm(constants, depth - 1, rng)});
+        case 1: return Func("g", {randomTerm(constants, depth - 1, rng)});
+        default: return Func("h", {randomTerm(constants, depth - 1, rng), randomTerm(constants, depth - 1, rng)});
+    }
+}
+
+/** @brief Renames every constant of a term to a random one, keeping its shape */
+void renameConstants(Term* term, size_t constants, std::mt19937& rng){
+    std::vector<Term*> stack = {term};
+    while(!stack.empty()){
+        Term* t = stack.back();
+        stack.pop_back();
+        if(t->args.size() == 0){
+            t->name = "c" + std::to_string(rng() % constants);
+        }
+        stack.insert(stack.end(), t->args.begin(), t->args.end());
+    }
+}
+
+double millisecondsSince(Clock::time_point start){
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv){
+    size_t maxConstants = argc > 1 ? std::stoul(argv[1]) : 1 << 16;
+    unsigned seed = argc > 2 ? std::stoul(argv[2]) : 1;
+    for(size_t n = 1 << 12; n <= maxConstants; n *= 2){
+        std::mt19937 rng(seed);
+        //n equations between n constants join most of them in one large class,
+        //n more between random terms add congruences over it
+        std::vector<pTerm> terms;
+        for(size_t i = 0; i < n; i++){
+            terms.emplace_back(Const("c" + std::to_string(rng() % n)));
+            terms.emplace_back(Const("c" + std::to_string(rng() % n)));
+        }
+        for(size_t i = 0; i < 2 * n; i++){
+            terms.emplace_back(randomTerm(n, 3, rng));
+        }
+        //Queries are pairs of terms of the same shape
+        for(size_t i = 0; i < n; i++){
+            terms.emplace_back(randomTerm(n, 3, rng));
+            terms.emplace_back(terms.back()->copy());
+            renameConstants(terms.back().get(), n, rng);
+        }
+
+        CongruenceClosure closure;
+        auto start = Clock::now();
+        for(size_t i = 0; i < 2 * n; i++){
+            closure.addEquation(terms[2 * i].get(), terms[2 * i + 1].get());
+        }
+        double assertTime = millisecondsSince(start);
+
+        start = Clock::now();
+        size_t equal = 0;
+        size_t explained = 0;
+        for(size_t i = 4 * n; i < 6 * n; i += 2){
+            if(closure.equal(terms[i].get(), terms[i + 1].get())){
+                equal++;
+                explained += closure.explain(terms[i].get(), terms[i + 1].get()).size();
+            }
+        }
+        double queryTime = millisecondsSince(start);
+        std::cout << 2 * n << " equations, " << closure.nodes.size() << " nodes, "
+                  << closure.congruences << " congruences: asserted in " << assertTime << " ms ("
+                  << assertTime * 1e6 / (2 * n) << " ns/equation), " << n << " queries in " << queryTime
+                  << " ms, " << equal << " equal with " << explained << " equations explained\n";
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file DeepFormulaBench.cpp
+ * @brief Benchmarks formula traversals on very deep and on many shallow formulae
+ * @details usage: DeepFormulaBench [depth] [shallowCount]
+ * The deep half builds conjunction chains, quantifier chains and Peano style
+ * terms `depth` levels deep and runs every traversal over them, this would
+ * overflow the stack with recursive traversals. The shallow half runs the same
+ * traversals over many small formulae to compare against recursive versions.
+ */
+
+#include<chrono>
+#include<string>
+#include<iostream>
+
+#include"Formula.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+void time(const std::string& name, F f){
+    Clock::time_point start = Clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    std::cout<<name<<": "<<elapsed.count()<<" ms"<<std::endl;
+}
+
+/** @return `(and P0 (and P1 ... (and Pn-1 Pn)))` */
+std::string conjunctionChain(size_t depth){
+    std::string rv;
+    for(size_t i = 0; i < depth; i++){
+        rv += "(and P" + std::to_string(i) + " ";
+    }
+    rv += "Q";
+    rv += std::string(depth, ')');
+    return rv;
+}
+
+/** @return `(forall x (forall x ... (P x (S (S ... (S 0))))))` */
+std::string quantifierChain(size_t depth){
+    std::string rv;
+    for(size_t i = 0; i < depth; i++){
+        rv += "(forall x ";
+    }
+    rv += "(P x ";
+    for(size_t i = 0; i < depth; i++){
+        rv += "(S ";
+    }
+    rv += "0" + std::string(depth, ')') + ")";
+    rv += std::string(depth, ')');
+    return rv;
+}
+
+void deepBench(const std::string& name, const std::string& expr){
+    std::cout<<"== "<<name<<" =="<<std::endl;
+    pFormula f, g;
+    time("parse", [&](){ f = pFormula(fromSExpressionString(expr)); });
+    time("depth", [&](){ f->depthWithTerms(); });
+    time("allPredicates", [&](){ f->allPredicates(); });
+    time("boundTermVariables", [&](){ f->boundTermVariables(); });
+    time("copy", [&](){ g = pFormula(f->copy()); });
+    time("operator==", [&](){ (void)(*f == *g); });
+    time("toSExpression", [&](){ toSExpression(f.get()); });
+    time("destroy", [&](){ f.reset(); g.reset(); });
+}
+
+void shallowBench(size_t count){
+    std::cout<<"== "<<count<<" shallow formulae =="<<std::endl;
+    const std::string expr = 
+        "(forall P (if (and (P 0) (forall n (if (P n) (P (add n 1))))) (forall n (P n))))";
+    size_t checksum = 0;
+    time("parse + traverse + copy + print + destroy", [&](){
+        for(size_t i = 0; i < count; i++){
+            pFormula f (fromSExpressionString(expr));
+            checksum += f->depthWithTerms();
+            checksum += f->allPredicates().size();
+            checksum += f->boundTermVariables().size();
+            pFormula g (f->copy());
+            checksum += *f == *g;
+            checksum += toSExpression(g.get()).size();
+        }
+    });
+    std::cout<<"checksum: "<<checksum<<std::endl;
+}
+
+int main(int argc, char** argv){
+    size_t depth = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t shallowCount = argc > 2 ? std::stoul(argv[2]) : 100000;
+    if(depth > 0){
+        deepBench("conjunction chain", conjunctionChain(depth));
+        deepBench("quantifier chain", quantifierChain(depth));
+    }
+    shallowBench(shallowCount);
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file EGraphBench.cpp
+ * @brief Benchmarks e-graph rebuilding and equality saturation
+ * @details usage: EGraphBench [terms] [unions] [seed]
+ * Adds random terms over a few function symbols, then merges random pairs
+ * of their e-classes, restoring the invariants once after all unions and
+ * after every union. Then saturates random Peano sums and products under
+ * PEANO_RULES and extracts their smallest forms.
+ */
+
+#include<chrono>
+#include<random>
+#include<string>
+#include<vector>
+#include<iostream>
+
+#include"EGraph.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/** @return a random term with up to depth nested applications over constants */
+Term* randomTerm(size_t constants, int depth, std::mt19937& rng){
+    if(depth == 0 || rng() % 4 == 0){
+        return Const("c" + std::to_string(rng() % constants));
+    }
+    if(rng() % 2 == 0){
+        return Func("f", {randomTerm(constants, depth - 1, rng)});
+    }
+    return Func("g", {randomTerm(constants, depth - 1, rng), randomTerm(constants, depth - 1, rng)});
+}
+
+/** @return a random Peano numeral below 4 */
+Term* randomNumeral(std::mt19937& rng){
+    Term* rv = Const("0");
+    for(size_t i = rng() % 4; i > 0; i--){
+        rv = Func("S", {rv});
+    }
+    return rv;
+}
+
+/** @return a random sum or product of numerals and variables */
+Term* randomPeano(int depth, std::mt19937& rng){
+    if(depth == 0){
+        return rng() % 3 == 0 ? Var("x" + std::to_string(rng() % 2)) : randomNumeral(rng);
+    }
+    return Func(rng() % 3 == 0 ? "mul" : "add", {randomPeano(depth - 1, rng), randomPeano(depth - 1, rng)});
+}
+
+double millisecondsSince(Clock::time_point start){
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv){
+    size_t termCount = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t unionCount = argc > 2 ? std::stoul(argv[2]) : 20000;
+    unsigned seed = argc > 3 ? std::stoul(argv[3]) : 1;
+    std::mt19937 rng(seed);
+
+    std::vector<pTerm> terms;
+    for(size_t i = 0; i < termCount; i++){
+        terms.emplace_back(randomTerm(termCount / 4, 6, rng));
+    }
+    std::vector<std::pair<size_t, size_t>> unions;
+    for(size_t i = 0; i < unionCount; i++){
+        unions.emplace_back(rng() % termCount, rng() % termCount);
+    }
+    for(bool batched : {true, false}){
+        EGraph graph;
+        std::vector<uint32_t> ids;
+        auto start = Clock::now();
+        for(const pTerm& term : terms){
+            ids.push_back(graph.add(term.get()));
+        }
+        double addTime = millisecondsSince(start);
+        start = Clock::now();
+        for(auto [left, right] : unions){
+            graph.merge(ids[left], ids[right]);
+            if(!batched){
+                graph.rebuild();
+            }
+        }
+        graph.rebuild();
+        double unionTime = millisecondsSince(start);
+        std::cout << (batched ? "batched rebuild: " : "rebuild per union: ") << termCount << " terms, "
+                  << graph.nodeCount() << " e-nodes in " << graph.classCount << " e-classes, added in "
+                  << addTime << " ms, " << graph.unions << " unions and " << graph.rebuilds
+                  << " repairs in " << unionTime << " ms\n";
+    }
+
+    size_t problems = 200;
+    size_t nodes = 0;
+    size_t extracted = 0;
+    size_t saturated = 0;
+    auto start = Clock::now();
+    for(size_t i = 0; i < problems; i++){
+        pTerm term (randomPeano(3, rng));
+        EGraph graph;
+        uint32_t id = graph.add(term.get());
+        graph.addRules(PEANO_RULES);
+        SaturationLimits limits;
+        limits.nodes = 20000;
+        saturated += graph.saturate(limits) == SaturationStop::SATURATED;
+        nodes += graph.nodeCount();
+        pTerm smallest (graph.extract(id));
+        extracted += toSExpression(smallest.get()).size();
+    }
+    double saturateTime = millisecondsSince(start);
+    std::cout << "peano: " << problems << " problems, " << saturated << " saturated, " << nodes
+              << " e-nodes and " << extracted << " extracted characters in " << saturateTime << " ms\n";
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file RewriteBench.cpp
+ * @brief Benchmarks simplify() on large generated formulae
+ * @details usage: RewriteBench [nodes] [atoms] [seed]
+ * Builds a random formula over atoms propositions and the constants true and
+ * false, then simplifies it with a fresh and with a warm Rewriter.
+ */
+
+#include<chrono>
+#include<random>
+#include<string>
+#include<vector>
+#include<iostream>
+
+#include"Rewrite.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/** @return a random formula with about nodes connectives as an S-Expression */
+std::string randomFormula(size_t nodes, int atoms, std::mt19937& rng){
+    std::vector<std::string> pool;
+    std::uniform_int_distribution<int> atom(-2, atoms - 1);
+    for(size_t i = 0; i <= nodes / 2; i++){
+        int a = atom(rng);
+        pool.push_back(a == -2 ? "true" : a == -1 ? "false" : "P" + std::to_string(a));
+    }
+    static const char* connectives[] = {"and", "or", "if", "iff"};
+    while(pool.size() > 1){
+        size_t i = rng() % pool.size();
+        std::string left = std::move(pool[i]);
+        pool[i] = std::move(pool.back());
+        pool.pop_back();
+        if(rng() % 4 == 0){
+            pool.push_back("(not " + left + ")");
+            continue;
+        }
+        size_t j = rng() % pool.size();
+        pool[j] = "(" + std::string(connectives[rng() % 4]) + " " + left + " " + pool[j] + ")";
+    }
+    return pool.back();
+}
+
+int main(int argc, char** argv){
+    size_t nodes = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    int atoms = argc > 2 ? std::stoi(argv[2]) : 64;
+    std::mt19937 rng(argc > 3 ? std::stoul(argv[3]) : 1);
+
+    pFormula formula (fromSExpressionString(randomFormula(nodes, atoms, rng)));
+    std::cout<<"depth "<<formula->depth()<<std::endl;
+
+    Rewriter rewriter;
+    rewriter.addRules(DOUBLE_NEGATION_RULES);
+    rewriter.addRules(IDEMPOTENCE_RULES);
+    rewriter.addRules(ABSORPTION_RULES);
+    rewriter.addRules(CONSTANT_FOLDING_RULES);
+    for(const char* pass : {"cold", "warm"}){
+        Clock::time_point start = Clock::now();
+        pFormula result (rewriter.rewrite(formula.get()));
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        std::cout<<pass<<": "<<elapsed.count() * 1000<<" ms, "
+                 <<nodes / elapsed.count()<<" nodes/s, "
+                 <<rewriter.rewrites<<" rewrites, "
+                 <<rewriter.nodes.size()<<" interned"<<std::endl;
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ * @file SatBench.cpp
+ * @brief Benchmarks the embedded SAT solver on generated instances
+ * @details usage: SatBench [maxHoles] [variables] [instances]
+ * Solves pigeonhole instances (n + 1 pigeons, n holes, always unsatisfiable
+ * and exponential for resolution) for n up to maxHoles, then random 3-SAT
+ * instances at the 4.26 clause to variable threshold.
+ */
+
+#include<chrono>
+#include<random>
+#include<string>
+#include<vector>
+#include<iostream>
+
+#include"Sat.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+void time(const std::string& name, F f){
+    Clock::time_point start = Clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    std::cout<<name<<": "<<elapsed.count()<<" ms"<<std::endl;
+}
+
+ClauseSet pigeonhole(int holes){
+    ClauseSet rv;
+    auto var = [holes](int pigeon, int hole){ return pigeon * holes + hole + 1; };
+    for(int p = 0; p <= holes; p++){
+        std::vector<int> clause;
+        for(int h = 0; h < holes; h++){
+            clause.push_back(var(p, h));
+        }
+        rv.addClause(clause);
+    }
+    for(int h = 0; h < holes; h++){
+        for(int p = 0; p <= holes; p++){
+            for(int q = p + 1; q <= holes; q++){
+                rv.addClause({-var(p, h), -var(q, h)});
+            }
+        }
+    }
+    return rv;
+}
+
+ClauseSet random3Sat(int variables, std::mt19937& rng){
+    ClauseSet rv;
+    std::uniform_int_distribution<int> variable(1, variables);
+    int clauses = variables * 426 / 100;
+    for(int c = 0; c < clauses; c++){
+        rv.addClause({variable(rng) * (rng() % 2 ? 1 : -1),
+                      variable(rng) * (rng() % 2 ? 1 : -1),
+                      variable(rng) * (rng() % 2 ? 1 : -1)});
+    }
+    return rv;
+}
+
+int main(int argc, char** argv){
+    int maxHoles = argc > 1 ? std::stoi(argv[1]) : 9;
+    int variables = argc > 2 ? std::stoi(argv[2]) : 200;
+    int instances = argc > 3 ? std::stoi(argv[3]) : 100;
+
+    std::cout<<"== pigeonhole =="<<std::endl;
+    for(int holes = 4; holes <= maxHoles; holes++){
+        SatSolver solver(pigeonhole(holes));
+        time("php " + std::to_string(holes + 1) + "/" + std::to_string(holes), [&](){ solver.solve(); });
+        std::cout<<"  conflicts: "<<solver.conflicts<<std::endl;
+    }
+
+    std::cout<<"== random 3-SAT, "<<variables<<" variables =="<<std::endl;
+    std::mt19937 rng(2024);
+    size_t satisfiable = 0, conflicts = 0;
+    time(std::to_string(instances) + " instances", [&](){
+        for(int i = 0; i < instances; i++){
+            SatSolver solver(random3Sat(variables, rng));
+            satisfiable += solver.solve() == SatResult::SAT;
+            conflicts += solver.conflicts;
+        }
+    });
+    std::cout<<"  satisfiable: "<<satisfiable<<", conflicts: "<<conflicts<<std::endl;
+}
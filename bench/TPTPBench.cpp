@@ -0,0 +1,82 @@
+/**
+ * @file TPTPBench.cpp
+ * @brief Measures the throughput of the streaming TPTP writer and reader
+ * @details usage: TPTPBench [megabytes] [path]
+ * Writes a problem of about the given size of random first order formulae
+ * with a TPTPWriter, then reads it back from a file stream. If a path is
+ * given that file is read instead.
+ */
+
+#include<chrono>
+#include<cstdio>
+#include<random>
+#include<string>
+#include<vector>
+#include<fstream>
+#include<iostream>
+
+#include"TPTP.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+Term* randomTerm(int depth, std::mt19937& rng){
+    if(depth == 0 || rng() % 3 == 0){
+        return rng() % 2 ? Var("x" + std::to_string(rng() % 3)) : Const("c" + std::to_string(rng() % 32));
+    }
+    return Func("f" + std::to_string(rng() % 8), {randomTerm(depth - 1, rng), randomTerm(depth - 1, rng)});
+}
+
+Formula* randomFormula(int depth, std::mt19937& rng){
+    if(depth == 0){
+        return Pred("p" + std::to_string(rng() % 16), {randomTerm(2, rng), randomTerm(2, rng)});
+    }
+    switch(rng() % 7){
+        case 0: return Not(randomFormula(depth - 1, rng));
+        case 1: return And(randomFormula(depth - 1, rng), randomFormula(depth - 1, rng));
+        case 2: return Or(randomFormula(depth - 1, rng), randomFormula(depth - 1, rng));
+        case 3: return If(randomFormula(depth - 1, rng), randomFormula(depth - 1, rng));
+        case 4: return Iff(randomFormula(depth - 1, rng), randomFormula(depth - 1, rng));
+        default: return Forall("x" + std::to_string(rng() % 3), randomFormula(depth - 1, rng));
+    }
+}
+
+int main(int argc, char** argv){
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 100;
+    std::string path = argc > 2 ? argv[2] : "TPTPBench.p";
+    bool generated = argc <= 2;
+
+    if(generated){
+        std::mt19937 rng(1);
+        std::vector<pFormula> formulae;
+        for(size_t i = 0; i < megabytes * 800; i++){
+            formulae.emplace_back(randomFormula(6, rng));
+        }
+        std::ofstream out(path, std::ios::binary);
+        Clock::time_point start = Clock::now();
+        {
+            TPTPWriter writer(out);
+            for(size_t i = 0; i < formulae.size(); i++){
+                writer.write("ax" + std::to_string(i), "axiom", formulae[i].get());
+            }
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        double written = out.tellp() / 1e6;
+        std::cout<<"wrote "<<formulae.size()<<" formulae, "<<written<<" MB in "<<elapsed.count() * 1000
+                 <<" ms, "<<written / elapsed.count()<<" MB/s"<<std::endl;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    TPTPReader reader(in);
+    TPTPInput input;
+    size_t formulae = 0;
+    Clock::time_point start = Clock::now();
+    while(reader.next(input)){
+        formulae++;
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    std::cout<<formulae<<" formulae, "<<reader.bytes / 1e6<<" MB in "<<elapsed.count() * 1000<<" ms, "
+             <<reader.bytes / 1e6 / elapsed.count()<<" MB/s"<<std::endl;
+    if(generated){
+        std::remove(path.c_str());
+    }
+}
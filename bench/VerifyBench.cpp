@@ -0,0 +1,200 @@
+/**
+ * @file VerifyBench.cpp
+ * @brief Benchmarks the scaling of proof graph verification with threads
+ * @details usage: VerifyBench [nodes] [max threads]
+ * Verifies a wide graph of many short independent derivations and a deep
+ * graph of a few long chains, each with 1, 2, 4, ... up to max threads
+ * (default one per core). A wide graph should scale with cores, a deep one
+ * is limited by the number of chains.
+ * Then verifies a linear proof where every step adds an assumption, so the
+ * assumption sets grow along the whole proof, and one where every step also
+ * looks up and discharges its newest assumption.
+ * Then breaks and repairs random nodes of wide graphs of doubling size up
+ * to nodes in a VerificationSession, the time from edit to results should
+ * not grow with the graph.
+ * Last verifies many submissions of the same proofs, about nodes in all,
+ * without and with a VerifyCache shared between them, and prints its counters.
+ */
+
+#include<chrono>
+#include<memory>
+#include<random>
+#include<string>
+#include<thread>
+#include<vector>
+#include<iostream>
+
+#include"verify.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/** @brief Adds a node to a graph below its parents */
+ProofNode* addNode(ProofGraph& graph, const std::string& formula, const std::string& justification,
+                   std::vector<ProofNode*> parents){
+    ProofNode* node = newProofNode(formula, justification, parents, graph.universe);
+    node->id = graph.nodes.size();
+    for(ProofNode* parent : parents){
+        parent->children.push_back(node);
+    }
+    if(parents.empty()){
+        graph.assumptions.insert(node);
+    }
+    graph.nodes[node->id] = pProofNode(node);
+    return node;
+}
+
+/**
+ * @brief Builds chains alternating between conjoining a proposition with
+ * itself and eliminating the conjunction
+*/
+void buildChains(ProofGraph& graph, size_t chains, size_t length){
+    for(size_t c = 0; c < chains; c++){
+        std::string atom = "P" + std::to_string(c);
+        ProofNode* last = addNode(graph, atom, "Assumption", {});
+        for(size_t i = 1; i < length; i += 2){
+            ProofNode* conjunction = addNode(graph, "(and " + atom + " " + atom + ")", "AndIntro", {last, last});
+            last = addNode(graph, atom, "AndElim", {conjunction});
+        }
+    }
+}
+
+/**
+ * @brief Builds a linear proof, each step conjoins the last result with a new
+ * assumption and eliminates the conjunction again
+*/
+void buildLinearProof(ProofGraph& graph, size_t length){
+    ProofNode* last = addNode(graph, "X", "Assumption", {});
+    while(graph.nodes.size() + 3 <= length){
+        ProofNode* assumption = addNode(graph, "X", "Assumption", {});
+        ProofNode* conjunction = addNode(graph, "(and X X)", "AndIntro", {last, assumption});
+        last = addNode(graph, "X", "AndElim", {conjunction});
+    }
+}
+
+/**
+ * @brief Builds a linear proof that carries a new distinct assumption Pi on
+ * every step, and beside every step discharges Pi again with an IfIntro
+*/
+void buildDischargingProof(ProofGraph& graph, size_t length){
+    ProofNode* last = addNode(graph, "X", "Assumption", {});
+    for(size_t i = 0; graph.nodes.size() + 4 <= length; i++){
+        std::string atom = "P" + std::to_string(i);
+        ProofNode* assumption = addNode(graph, atom, "Assumption", {});
+        ProofNode* conjunction = addNode(graph, "(and X " + atom + ")", "AndIntro", {last, assumption});
+        last = addNode(graph, "X", "AndElim", {conjunction});
+        addNode(graph, "(if " + atom + " X)", "IfIntro", {last});
+    }
+}
+
+double millisecondsSince(Clock::time_point start){
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv){
+    size_t nodes = argc > 1 ? std::stoul(argv[1]) : 300000;
+    size_t maxThreads = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    struct Shape{
+        const char* name;
+        size_t chains;
+    };
+    for(Shape shape : {Shape{"wide", nodes / 3}, Shape{"deep", 4}}){
+        ProofGraph graph;
+        buildChains(graph, shape.chains, nodes / shape.chains);
+        std::string sequential;
+        double sequentialTime = 0;
+        for(size_t threads = 1; threads <= maxThreads; threads *= 2){
+            auto start = Clock::now();
+            std::string results = verifyProofGraph(graph, threads);
+            double time = millisecondsSince(start);
+            if(threads == 1){
+                sequential = results;
+                sequentialTime = time;
+            }else if(results != sequential){
+                std::cerr << "results differ with " << threads << " threads\n";
+                return 1;
+            }
+            std::cout << shape.name << ": " << graph.nodes.size() << " nodes in " << shape.chains
+                      << " chains, " << threads << " threads in " << time << " ms, speedup "
+                      << sequentialTime / time << "\n";
+        }
+    }
+
+    for(bool discharging : {false, true}){
+        ProofGraph graph;
+        if(discharging){
+            buildDischargingProof(graph, nodes);
+        }else{
+            buildLinearProof(graph, nodes);
+        }
+        const char* name = discharging ? "discharge" : "linear";
+        //Results list every assumption of every node, so they would be quadratic in size
+        auto start = Clock::now();
+        for(size_t id = 0; id < graph.nodes.size(); id++){
+            if(verify(graph.nodes.at(id).get())){
+                std::cerr << name << " proof node " << id << " did not verify\n";
+                return 1;
+            }
+        }
+        double time = millisecondsSince(start);
+        std::cout << name << ": " << graph.nodes.size() << " nodes verified in " << time << " ms, "
+                  << graph.nodes.at(graph.nodes.size() - 1)->assumptions.size() << " assumptions at the end\n";
+    }
+
+    std::mt19937 rng(1);
+    size_t edits = 1000;
+    for(size_t size = std::max<size_t>(nodes / 16, 3); size <= nodes; size *= 2){
+        ProofGraph graph;
+        buildChains(graph, size / 3, 3);
+        auto start = Clock::now();
+        VerificationSession session(graph);
+        double startTime = millisecondsSince(start);
+        start = Clock::now();
+        for(size_t i = 0; i < edits; i++){
+            size_t id = rng() % graph.nodes.size();
+            std::string justification = graph.nodes.at(id)->justification == Justification::Assumption
+                                      ? "Assumption" : id % 3 == 1 ? "AndIntro" : "AndElim";
+            session.setJustification(id, "OrIntro");
+            session.update();
+            session.setJustification(id, justification);
+            session.update();
+        }
+        double editTime = millisecondsSince(start);
+        std::cout << "session: " << graph.nodes.size() << " nodes verified in " << startTime << " ms, "
+                  << 2 * edits << " edits in " << editTime << " ms, " << editTime * 1000 / (2 * edits)
+                  << " us per edit, " << session.reverified << " nodes re-verified\n";
+    }
+
+    //Every submission proves the same steps, as many students answering one exercise do
+    size_t submissions = 100;
+    std::vector<std::unique_ptr<ProofGraph>> graphs;
+    for(size_t i = 0; i < submissions; i++){
+        graphs.emplace_back(new ProofGraph());
+        buildDischargingProof(*graphs.back(), std::max<size_t>(nodes / submissions / 2, 5));
+        buildChains(*graphs.back(), 4, std::max<size_t>(nodes / submissions / 8, 2));
+    }
+    VerifyCache cache;
+    std::vector<std::string> uncached;
+    for(VerifyCache* memo : {(VerifyCache*)nullptr, &cache}){
+        auto start = Clock::now();
+        for(size_t i = 0; i < submissions; i++){
+            std::string results = verifyProofGraph(*graphs[i], 1, memo);
+            if(memo == nullptr){
+                uncached.push_back(std::move(results));
+            }else if(results != uncached[i]){
+                std::cerr << "cached results differ for submission " << i << "\n";
+                return 1;
+            }
+        }
+        double time = millisecondsSince(start);
+        std::cout << "submissions: " << submissions << " of " << graphs[0]->nodes.size() << " nodes "
+                  << (memo ? "with" : "without") << " cache in " << time << " ms";
+        if(memo){
+            VerifyCache::Stats stats = cache.stats();
+            std::cout << ", " << stats.hits << " hits, " << stats.misses << " misses, "
+                      << stats.evictions << " evictions, " << stats.entries << " entries";
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file AssumptionSet.hpp
+ * @brief Immutable sets of assumptions as persistent bitsets
+ * @details The nodes of a proof graph are numbered densely by an
+ * AssumptionUniverse, and an AssumptionSet is a bitset over those numbers.
+ * The bitset is a trie with 64 children per node and 64 bit words at the
+ * leaves, where empty subtrees are left out. Nodes are reference counted
+ * and never modified, so copies are O(1) and a union only rebuilds the
+ * nodes where its operands differ, sharing every other subtree. A node that
+ * inherits the assumptions of its parent shares the whole set.
+ *
+ * Empty subtrees are removed and the root is no higher than needed, so
+ * equal sets have equal tries and comparisons can stop at shared subtrees.
+ */
+
+#pragma once
+
+#include<bit>
+#include<mutex>
+#include<memory>
+#include<string>
+#include<vector>
+#include<cstdint>
+#include<unordered_set>
+#include<unordered_map>
+
+struct ProofNode;
+
+struct AssumptionUniverse;
+
+/** @brief An immutable set of assumption nodes */
+struct AssumptionSet{
+
+    /**
+     * @brief A node of a bitset trie, never modified after construction
+     * @details a leaf holds 64 members in its bits, an inner node has one
+     * child for each of its bits.
+     */
+    struct Node{
+        uint64_t bits;
+        std::vector<std::shared_ptr<const Node>> children;
+    };
+
+    std::shared_ptr<const Node> root;               ///< null iff the set is empty
+    uint32_t height = 0;                            ///< inner levels above the leaves
+    AssumptionUniverse* universe = nullptr;         ///< null iff the set is empty
+
+    /** @brief Creates an empty set */
+    AssumptionSet() = default;
+
+    /** @return the set of just one node */
+    static AssumptionSet of(const ProofNode* node);
+
+    /** @return the union of two sets over the same universe */
+    AssumptionSet unite(const AssumptionSet& other) const;
+
+    /**
+     * @return the members for which keep is true, sharing the subtrees where
+     * every member is kept
+     */
+    template<typename Keep>
+    AssumptionSet filter(Keep keep) const;
+
+    /** @return the members of both sets */
+    AssumptionSet intersect(const AssumptionSet& other) const;
+
+    /** @return the members not in other, sharing the subtrees other does not touch */
+    AssumptionSet minus(const AssumptionSet& other) const;
+
+    /**
+     * @return whether a member of both sets satisfies pred, only visiting
+     * the parts of the tries both sets share members in
+     */
+    template<typename Pred>
+    bool anyCommon(const AssumptionSet& other, Pred pred) const;
+
+    bool contains(const ProofNode* node) const;
+    bool empty() const;
+    size_t size() const;
+    void clear();
+
+    /** @brief true iff the sets have the same members */
+    bool operator==(const AssumptionSet& other) const;
+
+    /** @brief Iterates over the members in order of number */
+    struct Iterator{
+        struct Frame{
+            const Node* node;
+            uint64_t bits;          ///< children or members not visited yet
+            uint32_t base;          ///< number of the first member below the node
+        };
+        const AssumptionSet* set = nullptr;
+        Frame stack[7];
+        uint32_t depth = 0;         ///< frames on the stack, 0 at the end
+        uint32_t index = 0;         ///< the current member
+
+        ProofNode* operator*() const;
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const;
+        void advance();
+    };
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    /** @name Internal */
+    ///@{
+    template<typename Keep>
+    std::shared_ptr<const Node> filterNode(const std::shared_ptr<const Node>& node, uint32_t level,
+                                           uint64_t base, Keep& keep) const;
+    template<typename Pred>
+    bool anyCommonNode(const Node* x, const Node* y, uint32_t level, uint64_t base, Pred& pred) const;
+    void lift(uint32_t height);
+    void shrink();
+    ///@}
+};
+
+/**
+ * @brief Numbers the nodes of a proof graph densely
+ * @details Numbers are never reused, so a number in a stale set can not come
+ * to mean another node. The universe also indexes its nodes by the hash of
+ * their formulae and by the identifiers free in them, so the assumptions
+ * with a formula or mentioning a name are found by intersecting sets
+ * instead of walking every assumption. Identifiers are interned as dense
+ * numbers. Adding, removing and indexing nodes is thread safe, looking
+ * nodes up is safe while no nodes are being added or indexed.
+*/
+struct AssumptionUniverse{
+    std::vector<ProofNode*> nodes;      ///< node by number, null once freed
+    std::unordered_map<size_t, AssumptionSet> formulas;    ///< nodes by the hash of their formula
+    std::unordered_map<std::string, uint32_t> identifierNumbers;
+    std::vector<AssumptionSet> identifiers;     ///< nodes by the number of an identifier free in them
+    std::mutex mutex;
+
+    /** @return the number of a new node */
+    uint32_t add(ProofNode* node);
+
+    /** @brief Frees the number of a node */
+    void remove(uint32_t index);
+
+    /** @return the numbers of identifiers in increasing order, numbering new ones */
+    std::vector<uint32_t> intern(const std::unordered_set<std::string>& names);
+
+    /** @return the number of an identifier, or UINT32_MAX if no node has had it */
+    uint32_t identifierNumber(const std::string& name) const;
+
+    /** @brief Adds a node to the index under the hash of its formula and its identifiers */
+    void index(const ProofNode* node);
+
+    /** @brief Removes a node from the index */
+    void unindex(const ProofNode* node);
+
+    /** @return the nodes whose formulae have a hash */
+    const AssumptionSet& withFormulaHash(size_t hash) const;
+
+    /** @return the nodes an identifier is free in, by its number */
+    const AssumptionSet& withIdentifier(uint32_t number) const;
+};
+
+/** @return the universe of nodes created outside of a proof graph */
+std::shared_ptr<AssumptionUniverse> defaultUniverse();
+
+template<typename Keep>
+AssumptionSet AssumptionSet::filter(Keep keep) const{
+    AssumptionSet rv = *this;
+    if(!empty()){
+        rv.root = filterNode(root, height, 0, keep);
+        rv.shrink();
+    }
+    return rv;
+}
+
+template<typename Keep>
+std::shared_ptr<const AssumptionSet::Node> AssumptionSet::filterNode(
+    const std::shared_ptr<const Node>& node, uint32_t level, uint64_t base, Keep& keep
+) const{
+    uint64_t bits = 0;
+    std::vector<std::shared_ptr<const Node>> children;
+    bool same = true;
+    if(level == 0){
+        for(uint64_t rest = node->bits; rest != 0; rest &= rest - 1){
+            uint32_t bit = std::countr_zero(rest);
+            if(keep(universe->nodes[base + bit])){
+                bits |= (uint64_t)1 << bit;
+            }else{
+                same = false;
+            }
+        }
+    }else{
+        size_t k = 0;
+        for(uint64_t rest = node->bits; rest != 0; rest &= rest - 1, k++){
+            uint32_t bit = std::countr_zero(rest);
+            std::shared_ptr<const Node> child = filterNode(node->children[k], level - 1,
+                                                           base + ((uint64_t)bit << (6 * level)), keep);
+            same = same && child == node->children[k];
+            if(child){
+                bits |= (uint64_t)1 << bit;
+                children.push_back(std::move(child));
+            }
+        }
+    }
+    if(same){
+        return node;
+    }
+    if(bits == 0){
+        return nullptr;
+    }
+    return std::make_shared<const Node>(Node{bits, std::move(children)});
+}
+
+template<typename Pred>
+bool AssumptionSet::anyCommon(const AssumptionSet& other, Pred pred) const{
+    if(empty() || other.empty() || universe != other.universe){
+        return false;
+    }
+    //Only slot 0 of the higher trie holds numbers the lower one can have
+    const Node* x = root.get();
+    const Node* y = other.root.get();
+    for(uint32_t h = height; h > other.height; h--){
+        if(!(x->bits & 1)){
+            return false;
+        }
+        x = x->children[0].get();
+    }
+    for(uint32_t h = other.height; h > height; h--){
+        if(!(y->bits & 1)){
+            return false;
+        }
+        y = y->children[0].get();
+    }
+    return anyCommonNode(x, y, std::min(height, other.height), 0, pred);
+}
+
+template<typename Pred>
+bool AssumptionSet::anyCommonNode(const Node* x, const Node* y, uint32_t level, uint64_t base, Pred& pred) const{
+    uint64_t common = x->bits & y->bits;
+    for(uint64_t rest = common; rest != 0; rest &= rest - 1){
+        uint32_t bit = std::countr_zero(rest);
+        if(level == 0){
+            if(pred(universe->nodes[base + bit])){
+                return true;
+            }
+            continue;
+        }
+        uint64_t below = ((uint64_t)1 << bit) - 1;
+        const Node* childX = x->children[std::popcount(x->bits & below)].get();
+        const Node* childY = y->children[std::popcount(y->bits & below)].get();
+        if(anyCommonNode(childX, childY, level - 1, base + ((uint64_t)bit << (6 * level)), pred)){
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file Binary.hpp
+ * @brief Compact binary serialization of formulae and proof graphs
+ * @details A binary image is a sequence of native endian 32 bit words so it
+ * can be memory mapped and decoded in place:
+ *
+ *  1. A header of BINARY_HEADER_WORDS words, see BinaryHeader.
+ *  2. The symbol table, every distinct name once as a length word followed
+ *     by its characters padded to a whole word.
+ *  3. The records. A formula is written in pre-order, each node as a tag
+ *     word holding its kind in the low 4 bits, a shared flag in bit 4 and,
+ *     for quantifiers, the symbol of the variable in the remaining bits.
+ *     A predicate is followed by its name and then its terms in pre-order,
+ *     each name as one word holding the symbol in the high 24 bits and the
+ *     arity in the low 8, with arities of 255 and over in an extra word.
+ *
+ * When sharing is enabled a connective structurally equal to one already
+ * written is replaced by a REF record holding the offset of the earlier
+ * record, which is then flagged as shared so the reader only remembers the
+ * subformulae that are referenced again.
+ *
+ * A proof graph image holds its nodes in order of id, each as its id in two
+ * words, its justification as a symbol, its parent count, the indices of
+ * its parents in the image, and its formula.
+ */
+
+#pragma once
+
+#include<span>
+#include<string>
+#include<vector>
+#include<cstdint>
+
+#include"Formula.hpp"
+#include"ProofGraph.hpp"
+
+/** @brief The words of a binary image */
+using BinaryBuffer = std::vector<uint32_t>;
+
+constexpr uint32_t BINARY_MAGIC = 0x424C5453;   ///< "STLB" read as a little endian word
+constexpr uint32_t BINARY_VERSION = 1;
+constexpr size_t BINARY_HEADER_WORDS = 8;
+
+/** @brief The first words of a binary image */
+struct BinaryHeader{
+    /** @brief What the records of an image hold */
+    enum class Kind : uint32_t{
+        FORMULAE,       ///< count formulae one after the other
+        PROOF_GRAPH,    ///< count proof nodes
+    };
+
+    uint32_t magic = BINARY_MAGIC;
+    uint32_t version = BINARY_VERSION;
+    Kind kind = Kind::FORMULAE;
+    uint32_t count = 0;         ///< formulae or proof nodes in the image
+    uint32_t symbols = 0;       ///< entries in the symbol table
+    uint32_t symbolWords = 0;   ///< words of the symbol table
+    uint32_t recordWords = 0;   ///< words of the records
+    uint32_t reserved = 0;
+};
+static_assert(sizeof(BinaryHeader) == BINARY_HEADER_WORDS * sizeof(uint32_t));
+
+/**
+ * @brief Serializes a formula
+ * @param share replace repeated connectives by back-references, this costs
+ * a hash of every subformula when writing and pays off for formulae with
+ * repeated structure, such as those produced by rewriting.
+ */
+BinaryBuffer serialize(const Formula* formula, bool share = false);
+
+/** @brief Serializes several formulae into one image with a common symbol table */
+BinaryBuffer serialize(const FormulaList& formulae, bool share = false);
+
+/** @brief Serializes a proof graph, its nodes, links and formulae */
+BinaryBuffer serialize(const ProofGraph& graph, bool share = false);
+
+/**
+ * @brief Deserializes an image holding exactly one formula
+ * @return a newly allocated formula
+ * @throws std::runtime_error if the image is malformed, of another version
+ * or kind, or does not hold exactly one formula
+ */
+Formula* deserialize(std::span<const uint32_t> image);
+
+/**
+ * @brief Deserializes every formula of an image
+ * @return newly allocated formulae in the order they were written
+ * @throws std::runtime_error if the image is malformed, of another version
+ * or kind
+ */
+FormulaList deserializeAll(std::span<const uint32_t> image);
+
+/**
+ * @brief Deserializes a proof graph
+ * @return a newly allocated graph
+ * @throws std::runtime_error if the image is malformed, of another version
+ * or kind
+ */
+ProofGraph* deserializeProofGraph(std::span<const uint32_t> image);
+
+/**
+ * @brief Writes an image to a file
+ * @throws std::runtime_error if the file can not be written
+ */
+void writeBinaryFile(const std::string& path, const BinaryBuffer& image);
+
+/**
+ * @brief A read only memory mapping of a binary image file, the pages are
+ * only read as they are decoded.
+ */
+struct MappedBinaryFile{
+    /** @throws std::runtime_error if the file can not be opened or mapped */
+    explicit MappedBinaryFile(const std::string& path);
+    ~MappedBinaryFile();
+
+    MappedBinaryFile(const MappedBinaryFile&) = delete;
+    MappedBinaryFile& operator=(const MappedBinaryFile&) = delete;
+
+    /** @return the words of the image, valid for the lifetime of the mapping */
+    std::span<const uint32_t> words() const;
+
+    const void* data = nullptr;
+    size_t size = 0;    ///< size of the file in bytes
+};
@@ -0,0 +1,128 @@
+/**
+ * @file Congruence.hpp
+ * @brief Congruence closure for ground equational reasoning over Terms
+ * @details Terms are interned into a hash consed DAG of curried
+ * applications: `f(a, b)` is `apply(apply(f/2, a), b)` where the symbol
+ * `f/2` is distinct from `f` with any other arity. Equations are merged
+ * into a union-find with path compression and union by size, every class
+ * keeps a use-list of the applications over its members, and a signature
+ * table over the representatives of an application's operands detects new
+ * congruences as classes are merged. Asserting m equations over terms of
+ * total size n takes O((n + m) log n) time.
+ *
+ * Every merge is recorded as an edge of a proof forest, labelled with the
+ * equation or the congruence that caused it, so the equations an equality
+ * follows from can be recovered.
+ *
+ * Terms are treated as ground, variables are uninterpreted constants.
+ */
+
+#pragma once
+
+#include<string>
+#include<vector>
+#include<cstdint>
+#include<unordered_map>
+
+#include"Formula.hpp"
+
+/** @brief The name of the equality predicate, `eq(t1, t2)` */
+const std::string EQUALITY_PREDICATE = "eq";
+
+/** @brief An incremental congruence closure over ground terms */
+struct CongruenceClosure{
+
+    /** @name Interface */
+    ///@{
+
+    /**
+     * @brief Asserts that two terms are equal
+     * @return the index of the equation, used by explain()
+     */
+    size_t addEquation(const Term* left, const Term* right);
+
+    /**
+     * @brief Asserts an equality predicate
+     * @throws std::runtime_error if the formula is not `eq` over two terms
+     */
+    size_t addEquation(const Formula* equation);
+
+    /** @return true iff the equations asserted so far entail left = right */
+    bool equal(const Term* left, const Term* right);
+
+    /**
+     * @return true iff the equations asserted so far entail an equality predicate
+     * @throws std::runtime_error if the formula is not `eq` over two terms
+     */
+    bool entails(const Formula* equation);
+
+    /**
+     * @brief Explains why two terms are equal
+     * @return the sorted indices of asserted equations that entail left = right
+     * @throws std::runtime_error if the terms are not known to be equal
+     */
+    std::vector<size_t> explain(const Term* left, const Term* right);
+
+    size_t equations = 0;       ///< equations asserted so far
+    size_t congruences = 0;     ///< merges caused by congruence so far
+    ///@}
+
+    /** @name Internal State */
+    ///@{
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint32_t CONGRUENCE = UINT32_MAX - 1;   ///< proof label of congruence merges
+
+    /**
+     * @brief An interned node, a symbol has left == NONE and its symbol index
+     * as right, an application has the applied node as left and its
+     * argument as right.
+     */
+    struct Node{
+        uint32_t left;
+        uint32_t right;
+    };
+
+    /** @brief A merge waiting to be applied, with its proof label */
+    struct Merge{
+        uint32_t left;
+        uint32_t right;
+        uint32_t reason;
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, uint32_t> nodeIds;         ///< interning table
+    std::vector<std::string> symbols;
+    std::unordered_map<std::string, uint32_t> symbolIds;
+
+    std::vector<uint32_t> parents;                          ///< union-find parent, itself for representatives
+    std::vector<uint32_t> sizes;                            ///< class sizes of representatives
+    std::vector<std::vector<uint32_t>> useLists;            ///< applications over each class, by representative
+    std::unordered_map<uint64_t, uint32_t> signatures;      ///< applications by operand representatives
+    std::vector<Merge> pending;
+
+    std::vector<uint32_t> proofParents;                     ///< proof forest edges, NONE at the roots
+    std::vector<uint32_t> proofReasons;                     ///< equation index or CONGRUENCE of each edge
+
+    std::vector<uint32_t> ancestors;                        ///< proof path marks, by pair explained
+    std::vector<uint32_t> explained;                        ///< explained proof edges, by call to explain()
+    uint32_t pairs = 0;
+    uint32_t explanations = 0;
+
+    uint32_t find(uint32_t id);
+    uint32_t internSymbol(const std::string& name, size_t arity);
+    uint32_t internApply(uint32_t left, uint32_t right);
+    uint32_t internTerm(const Term* term);
+    uint32_t newNode(Node node);
+    void merge(uint32_t left, uint32_t right, uint32_t reason);
+    void propagate();
+    void reroot(uint32_t id);
+    ///@}
+};
+
+/**
+ * @brief Decides whether a set of ground equations entails an equation
+ * @param equations `eq` predicates over two terms
+ * @param query an `eq` predicate over two terms
+ * @throws std::runtime_error if any formula is not `eq` over two terms
+ */
+bool entailsEquality(const FormulaList& equations, const Formula* query);
@@ -0,0 +1,183 @@
+/**
+ * @file EGraph.hpp
+ * @brief E-graph over Terms with equality saturation and extraction
+ * @details An e-graph compactly represents a set of terms and equalities
+ * between them. Every e-class is a set of equivalent e-nodes, and an e-node
+ * is a function symbol applied to e-classes. E-nodes are hash consed, so
+ * structurally equal terms share their e-classes.
+ *
+ * Unions only record that two e-classes are equal. The invariants, that
+ * e-nodes refer to canonical e-classes and that congruent e-nodes are in the
+ * same e-class, are restored in one batch by rebuild(), so the cost of
+ * restoring them is shared by every union since the last rebuild.
+ *
+ * Rules are written as S-Expression terms where constants starting with `?`
+ * are pattern variables, e.g. `(add ?x 0)` => `?x`. A pattern variable used
+ * twice only matches one e-class. Saturation searches every rule against
+ * the e-graph, then applies every match, then rebuilds, until nothing
+ * changes or a budget runs out.
+ */
+
+#pragma once
+
+#include<string>
+#include<vector>
+#include<chrono>
+#include<cstdint>
+#include<unordered_map>
+
+#include"Formula.hpp"
+#include"Rewrite.hpp"
+
+/** @brief Peano arithmetic over 0, S, add and mul */
+const std::vector<RewriteRuleSpec> PEANO_RULES = {
+    {"AddZero", "(add ?x 0)", "?x"},
+    {"AddSuccessor", "(add ?x (S ?y))", "(S (add ?x ?y))"},
+    {"AddCommutativity", "(add ?x ?y)", "(add ?y ?x)"},
+    {"AddAssociativity", "(add (add ?x ?y) ?z)", "(add ?x (add ?y ?z))"},
+    {"MulZero", "(mul ?x 0)", "0"},
+    {"MulSuccessor", "(mul ?x (S ?y))", "(add (mul ?x ?y) ?x)"},
+    {"MulCommutativity", "(mul ?x ?y)", "(mul ?y ?x)"},
+};
+
+/** @brief Budgets for equality saturation, the first one reached stops it */
+struct SaturationLimits{
+    size_t iterations = 30;
+    size_t nodes = 100000;                              ///< e-nodes in the e-graph
+    std::chrono::milliseconds time{5000};
+};
+
+/** @brief Why equality saturation stopped */
+enum class SaturationStop{
+    SATURATED,          ///< no rule adds anything new
+    ITERATION_LIMIT,
+    NODE_LIMIT,
+    TIME_LIMIT,
+};
+
+/** @brief An e-graph over Terms */
+struct EGraph{
+
+    /** @name Interface */
+    ///@{
+
+    /** @return the e-class of a term, adding its e-nodes as needed */
+    uint32_t add(const Term* term);
+
+    /**
+     * @brief Records that two e-classes are equal
+     * @details The e-graph invariants are not restored until rebuild(), find()
+     * is exact but add() and the e-nodes of a class may miss congruences.
+     * @return the e-class of the union
+     */
+    uint32_t merge(uint32_t left, uint32_t right);
+
+    /** @brief Restores the e-graph invariants after a batch of unions */
+    void rebuild();
+
+    /** @return the canonical id of an e-class */
+    uint32_t find(uint32_t id);
+
+    /**
+     * @brief Adds a rule, rules are searched in the order they are added
+     * @throws std::runtime_error if the pattern is a lone pattern variable or
+     * the replacement uses a pattern variable not bound by the pattern.
+     */
+    void addRule(const RewriteRuleSpec& rule);
+
+    /** @brief Adds every rule of a rule set */
+    void addRules(const std::vector<RewriteRuleSpec>& rules);
+
+    /** @brief Applies the rules until saturation or a budget runs out */
+    SaturationStop saturate(const SaturationLimits& limits = {});
+
+    /**
+     * @brief Extracts the cheapest term of an e-class, an e-node costs the cost
+     * of its symbol plus the costs of its children.
+     * @param costs cost of each symbol by name, 1 if missing, costs must be
+     * at least 1
+     * @return a newly allocated term
+     */
+    Term* extract(uint32_t id, const std::unordered_map<std::string, uint64_t>& costs = {});
+
+    /** @return the number of e-nodes */
+    size_t nodeCount() const;
+
+    size_t classCount = 0;      ///< live e-classes
+    size_t unions = 0;          ///< unions over the lifetime of the e-graph
+    size_t rebuilds = 0;        ///< e-classes repaired by rebuild()
+    size_t iterations = 0;      ///< saturation iterations over all calls to saturate()
+    ///@}
+
+    /** @name Internal State */
+    ///@{
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /** @brief A symbol applied to e-classes */
+    struct ENode{
+        uint32_t symbol;
+        std::vector<uint32_t> args;
+
+        bool operator==(const ENode& other) const = default;
+        auto operator<=>(const ENode& other) const = default;
+    };
+
+    struct ENodeHash{
+        size_t operator()(const ENode& node) const;
+    };
+
+    /** @brief The e-nodes of an e-class and the e-nodes using it, valid for canonical ids */
+    struct EClass{
+        std::vector<ENode> nodes;
+        std::vector<std::pair<ENode, uint32_t>> parents;
+    };
+
+    /**
+     * @brief A pattern node, a variable has variable set and its index as
+     * symbol. Nodes are stored in post-order so the root is the last one.
+     */
+    struct PatternNode{
+        uint32_t symbol;
+        bool variable;
+        std::vector<uint32_t> children;
+    };
+
+    /** @brief An e-class matched by a pattern and the e-classes bound to its variables */
+    struct Match{
+        uint32_t id;
+        std::vector<uint32_t> bindings;
+    };
+
+    struct Rule{
+        std::string name;
+        std::vector<PatternNode> pattern;
+        std::vector<PatternNode> replacement;
+        size_t variables;
+    };
+
+    std::vector<std::string> symbols;
+    std::unordered_map<std::string, uint32_t> symbolIds;
+    std::unordered_map<ENode, uint32_t, ENodeHash> memo;    ///< e-class of each e-node
+    std::vector<uint32_t> parents;                          ///< union-find parent, itself for canonical ids
+    std::vector<EClass> classes;
+    std::vector<uint32_t> pending;                          ///< e-classes to repair on rebuild()
+    std::vector<Rule> rules;
+    size_t enodes = 0;
+
+    uint32_t internSymbol(const std::string& name);
+    uint32_t addNode(ENode node);
+    void canonicalize(ENode& node);
+    void repair(uint32_t id, std::vector<uint32_t>& dirty);
+    std::vector<PatternNode> compilePattern(const std::string& pattern, std::unordered_map<std::string, uint32_t>& variables);
+    void search(const std::vector<PatternNode>& pattern, size_t variables, uint32_t id,
+                std::vector<Match>& matches) const;
+    uint32_t instantiate(const std::vector<PatternNode>& replacement, const std::vector<uint32_t>& bindings);
+    ///@}
+};
+
+/**
+ * @brief Finds the smallest term equal to a term under a set of rules
+ * @return a newly allocated term
+ */
+Term* smallestEquivalent(const Term* term, const std::vector<RewriteRuleSpec>& rules,
+                         const SaturationLimits& limits = {});
@@ -9,7 +9,7 @@
 
 #include<string>
 #include<list>
-#include<functional>
+#include<memory>
 
 #include"Term.hpp"
 #include"SExpression.hpp"
@@ -22,6 +22,12 @@ struct Formula;
 */
 using FormulaList = std::list<Formula*>;
 
+/**
+ * @brief An owning handle to a formula, frees the formula tree when it goes
+ * out of scope.
+*/
+using pFormula = std::unique_ptr<Formula>;
+
 /** 
  * @brief Represents a formulae with a truth value.
  * @details The formula is represented as tree. 
@@ -84,11 +90,22 @@ struct Formula{
          * is interpreted as a term. This is useful as it allows us to 
          * take advantage of the shared structure underlying predicates
          * and terms. 
+         * @tparam TermContext any callable taking a Term*, resolved at compile
+         * time so the call can be inlined.
          * @param termContext a function which takes the predicate interpreted
          * as a term and does something with it. Output can be obtained via 
          * binding outside vars by reference.  
         */
-        void applyToAsTerm(std::function<void(Term*)> termContext) const;
+        template<typename TermContext>
+        void applyToAsTerm(TermContext&& termContext) const{
+            Term dummy;
+            dummy.name = this->name;
+            dummy.args = this->args;
+            termContext(&dummy);
+            //The args are still owned by the predicate, detach them so the dummy's
+            //destructor only frees its own name and list
+            dummy.args.clear();
+        }
     };
 
     /** @brief Unary Connective formula representation */
@@ -107,16 +124,24 @@ struct Formula{
         std::string var;  ///< The identifier(var name) this quantifier binds to
         Formula* arg;     ///< The formula being quantified over
     };
+
+    /** @brief The logic orders a formula belongs to, see classify() */
+    struct Classification{
+        bool propositional;  ///< see isPropositional()
+        bool zerothOrder;    ///< see isZerothOrder()
+        bool firstOrder;     ///< see isFirstOrder()
+        bool secondOrder;    ///< see isSecondOrder()
+    };
     ///@}
     // Internal Representation =================================================
     /** @name Internal Representation */
     ///@{
 
     //Formula is a tagged union
-    Type type;                      ///< The type of the formula
-    ConnectiveType connectiveType;  ///< The connective class of the formula
+    Type type = Type::PRED;         ///< The type of the formula
+    ConnectiveType connectiveType = ConnectiveType::PRED; ///< The connective class of the formula
     union{
-        Pred* pred;                 ///< Valid iff type == PRED
+        Pred* pred = nullptr;       ///< Valid iff type == PRED
         UnaryConnective* unary;     ///< Valid iff type == NOT
         BinaryConnective* binary;   ///< Valid iff type == AND, OR, IF, IFF
         Quantifier* quantifier;     ///< Valid iff type == FORALL, EXISTS
@@ -127,9 +152,23 @@ struct Formula{
     /** @name Constructors, Destructors, operators */
     ///@{
     
-    /** @brief Default constructor, leaves everything uninitialized */
+    /** 
+     * @brief Default constructor, creates an empty formula that owns nothing.
+     * @details The construction helpers (Prop, And, Forall, ...) should be
+     * used to build actual formulae. 
+     */
     Formula() = default;
 
+    /** @brief Formulae own their subformulae, use copy() for deep copies */
+    Formula(const Formula&) = delete;
+    Formula& operator=(const Formula&) = delete;
+
+    /** @brief Steals the subformulae of other, leaving other empty */
+    Formula(Formula&& other) noexcept;
+
+    /** @brief Frees the current subformulae and steals those of other */
+    Formula& operator=(Formula&& other) noexcept;
+
     /** @brief Destructor, frees all subformulae */
     ~Formula();
 
@@ -222,29 +261,31 @@ struct Formula{
     /**
      * @brief Gets a list of pairs of pointers to term variables and the
      * quantifier formula they are bound to.
-     * @example if formula is `Ex: P(x) /\ Ay: Q(x, y)` then 
+     * @example if formula is `Ex: (P(x) /\ Ay: Q(x, y))` then 
      * `.boundTermVariables()` returns 
      * `[(pointer to x term in P(x), pointer to quantifier Ex formula), 
      *   (pointer to x term in Q(x,y), pointer to quantifier Ex formula), 
      *   (pointer to y term in Q(x,y), pointer to quantifier Ay formula)]`
-     * @example edge case, inner quantifier binds more strongly if shared 
-     * variable names if formula is `Ex: P(x) /\ Ax: Q(x, x)` then 
+     * @example edge case, the innermost quantifier binds a shared variable
+     * name, if formula is `Ex: (P(x) /\ Ax: Q(x, x))` then 
      * `.boundTermVariables()` returns 
      * `[(pointer to x term in P(x), pointer to quantifier Ex formula), 
-     *   (pointer to 1st x term in Q(x,x), pointer to quantifier Ex formula), 
+     *   (pointer to 1st x term in Q(x,x), pointer to quantifier Ax formula), 
      *   (pointer to 2nd x term in Q(x,x), pointer to quantifier Ax formula)]`
+     * @details Each occurrence is resolved to a single binder with a scoped 
+     * symbol table, linear in the size of the formula.
     */
     std::list<std::pair<Term*, Formula*>> boundTermVariables() const;
 
     /**
      * @brief Gets a list of pairs of pointers to function variables and 
-     * the quantifier formula they are bound to.
+     * the innermost quantifier formula they are bound to.
     */
     std::list<std::pair<Term*, Formula*>> boundFunctionVariables() const;
 
     /**
      * @brief Gets a list of pairs of pointers to predicate variables and
-     * the quantifier formula they are bound to.
+     * the innermost quantifier formula they are bound to.
     */
     std::list<std::pair<Formula*, Formula*>> boundPredicateVariables() const;
 
@@ -258,6 +299,15 @@ struct Formula{
     */
     std::unordered_set<std::string> identifiers() const;
 
+    /**
+     * @brief gets the set of identifiers occurring free in the formula
+     * @details the predicate, function and term names that are not bound by
+     * an enclosing quantifier, the names quantifiers bind are left out.
+     * @example `Ax: P(x, a) /\ Q(x)` returns `{P, a, Q, x}`, the x in Q(x) is
+     * free.
+    */
+    std::unordered_set<std::string> freeIdentifiers() const;
+
     //@}
     /** @name Formula Metrics and Testers */
     ///@{
@@ -279,6 +329,16 @@ struct Formula{
     */
     bool isProposition() const;
 
+    /**
+     * @brief Classifies the formula into all logic orders at once
+     * @details A single traversal tracks the set of connectives used, 
+     * whether all predicates are propositions, and which quantifiers bind
+     * predicates or functions. Prefer this over calling several of the
+     * testers below.
+     * @return the logic orders the formula belongs to
+    */
+    Classification classify() const;
+
     /**
      * @brief test if the formula is propositional logic
      * @details if the formula is a propositional calculus formula.
@@ -318,6 +378,8 @@ struct Formula{
 };
 
 // Construction Helpers ========================================================
+// All helpers take ownership of the subformulae and terms passed to them, 
+// names and argument lists are moved into the new formula.
 
 Formula* Prop(std::string name);
 Formula* Pred(std::string name, TermList args);
@@ -343,11 +405,56 @@ Formula* fromSExpression(const sExpression& expr);
  */
 Formula* fromSExpressionString(std::string sExpressionString);
 
+/**
+ * Converts an SExpression string into a term, an atom is a constant and a
+ * list is a function applied to the terms that follow it
+ * @param sExpressionString An SExpression String
+ */
+Term* termFromSExpressionString(std::string sExpressionString);
+
 
 std::string toSExpression(const Term* formula);
 std::string toSExpression(const Formula* formula);
 
-std::string toFirstOrderTPTP(std::string name, std::string type, Formula* formula);
+/**
+ * Converts a first order formula to a TPTP fof annotated formula, see
+ * TPTPFormatter in TPTP.hpp for how identifiers are made legal.
+ * @throws std::runtime_error if the formula is not first order
+ */
+std::string toFirstOrderTPTP(std::string name, std::string type, const Formula* formula);
+
+/**
+ * Same as toFirstOrderTPTP but consumes the formula, which is freed once it
+ * has been converted.
+ */
+std::string toFirstOrderTPTP(std::string name, std::string type, pFormula formula);
 
 
 
+
+//Formula hashing, structurally equal formulae (operator==) hash equally
+namespace std{
+    template <>
+    struct hash<Formula>{
+        std::size_t operator()(const Formula& k) const;
+    };
+}
+
+/** @brief Mixes value into seed, for hashes built from several fields */
+inline void hashCombine(std::size_t& seed, std::size_t value){
+    seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+/** @brief Hashes formula pointers by structure, for containers keyed by formulae */
+struct FormulaPtrHash{
+    std::size_t operator()(const Formula* formula) const{
+        return std::hash<Formula>()(*formula);
+    }
+};
+
+/** @brief Compares formula pointers by structure, for containers keyed by formulae */
+struct FormulaPtrEqual{
+    bool operator()(const Formula* a, const Formula* b) const{
+        return *a == *b;
+    }
+};
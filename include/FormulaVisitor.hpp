@@ -0,0 +1,144 @@
+/**
+ * @file FormulaVisitor.hpp
+ * @brief Statically dispatched traversals of formula trees
+ * @details A visitor is any object that defines some of the hooks below,
+ * hooks are resolved at compile time so traversals can be fully inlined.
+ * Every hook is optional and takes a pointer to the formula being visited.
+ *
+ * Main hooks, called before the subformulae by visit() and after them by
+ * visitPostOrder():
+ *  - onPred(f)   f is a predicate
+ *  - onUnary(f)  f is a unary connective
+ *  - onBinary(f) f is a binary connective
+ *  - onQuant(f)  f is a quantifier
+ *
+ * Auxiliary hooks, for opening and closing scopes (quantifier bindings,
+ * parenthesis, depth counters, ...):
+ *  - leaveUnary(f), leaveBinary(f), leaveQuant(f) called after the
+ *    subformulae of f by visit()
+ *  - enterUnary(f), enterBinary(f), enterQuant(f) called before the
+ *    subformulae of f by visitPostOrder()
+ *  - betweenBinary(f) called between the left and right subformulae of f
+ *
+ * A hook may return bool instead of void, returning false stops the whole
+ * traversal. Traversals use an explicit stack and are safe on arbitrarily
+ * deep formulae.
+ */
+
+#pragma once
+
+#include<vector>
+#include<type_traits>
+
+#include"Formula.hpp"
+
+/**
+ * Calls HOOK on the visitor if it is defined, stopping the traversal if the
+ * hook returns false.
+ */
+#define VISIT_HOOK(HOOK, FORMULA)\
+if constexpr(requires{visitor.HOOK(FORMULA);}){\
+    if constexpr(std::is_same_v<decltype(visitor.HOOK(FORMULA)), bool>){\
+        if(!visitor.HOOK(FORMULA)){\
+            return false;\
+        }\
+    }else{\
+        visitor.HOOK(FORMULA);\
+    }\
+}
+
+/**
+ * The traversal shared by visit() and visitPostOrder().
+ * @tparam PostOrder if true the main hooks are called after the subformulae
+ * @return false iff a hook stopped the traversal
+*/
+template<bool PostOrder, typename F, typename Visitor>
+bool traverseFormula(F* formula, Visitor& visitor){
+    //Each frame holds a formula and the number of subformulae already visited
+    struct Frame{
+        F* formula;
+        unsigned char visited;
+    };
+    std::vector<Frame> stack = {{formula, 0}};
+    stack.reserve(16);
+    while(!stack.empty()){
+        Frame& frame = stack.back();
+        F* f = frame.formula;
+        switch(f->connectiveType){
+            case Formula::ConnectiveType::PRED:
+                VISIT_HOOK(onPred, f);
+                stack.pop_back();
+                break;
+            case Formula::ConnectiveType::UNARY:
+                if(frame.visited == 0){
+                    frame.visited = 1;
+                    if constexpr(PostOrder){ VISIT_HOOK(enterUnary, f); }
+                    else{ VISIT_HOOK(onUnary, f); }
+                    stack.push_back({f->unary->arg, 0});
+                }else{
+                    if constexpr(PostOrder){ VISIT_HOOK(onUnary, f); }
+                    else{ VISIT_HOOK(leaveUnary, f); }
+                    stack.pop_back();
+                }
+                break;
+            case Formula::ConnectiveType::BINARY:
+                if(frame.visited == 0){
+                    frame.visited = 1;
+                    if constexpr(PostOrder){ VISIT_HOOK(enterBinary, f); }
+                    else{ VISIT_HOOK(onBinary, f); }
+                    stack.push_back({f->binary->left, 0});
+                }else if(frame.visited == 1){
+                    frame.visited = 2;
+                    VISIT_HOOK(betweenBinary, f);
+                    stack.push_back({f->binary->right, 0});
+                }else{
+                    if constexpr(PostOrder){ VISIT_HOOK(onBinary, f); }
+                    else{ VISIT_HOOK(leaveBinary, f); }
+                    stack.pop_back();
+                }
+                break;
+            case Formula::ConnectiveType::QUANT:
+                if(frame.visited == 0){
+                    frame.visited = 1;
+                    if constexpr(PostOrder){ VISIT_HOOK(enterQuant, f); }
+                    else{ VISIT_HOOK(onQuant, f); }
+                    stack.push_back({f->quantifier->arg, 0});
+                }else{
+                    if constexpr(PostOrder){ VISIT_HOOK(onQuant, f); }
+                    else{ VISIT_HOOK(leaveQuant, f); }
+                    stack.pop_back();
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+#undef VISIT_HOOK
+
+/**
+ * @brief Pre-order traversal of a formula tree, subformulae are visited
+ * left to right.
+ * @param formula the root of the traversal, may be const or mutable, hooks
+ * receive pointers of the same constness
+ * @param visitor an object defining any of the hooks in FormulaVisitor.hpp
+ * @return false iff a hook stopped the traversal early
+*/
+template<typename F, typename Visitor>
+requires std::is_same_v<std::remove_const_t<F>, Formula>
+inline bool visit(F* formula, Visitor&& visitor){
+    return traverseFormula<false>(formula, visitor);
+}
+
+/**
+ * @brief Post-order traversal of a formula tree, subformulae are visited
+ * left to right before their parent.
+ * @param formula the root of the traversal
+ * @param visitor an object defining any of the hooks in FormulaVisitor.hpp
+ * @return false iff a hook stopped the traversal early
+*/
+template<typename F, typename Visitor>
+requires std::is_same_v<std::remove_const_t<F>, Formula>
+inline bool visitPostOrder(F* formula, Visitor&& visitor){
+    return traverseFormula<true>(formula, visitor);
+}
@@ -0,0 +1,138 @@
+/**
+ * @file NormalForm.hpp
+ * @brief Normal form transformations of formulae
+ * @details Negation normal form and prenex form are returned as new formula
+ * trees. Conjunctive and disjunctive normal forms are returned as flat
+ * ClauseSets of integer literals ready to be handed to a SAT solver.
+ *
+ * CNF and DNF are propositional, quantified subformulae are treated as
+ * opaque atoms.
+ */
+
+#pragma once
+
+#include<span>
+#include<vector>
+#include<utility>
+#include<unordered_map>
+#include<initializer_list>
+
+#include"Formula.hpp"
+
+/**
+ * @brief Converts a formula to negation normal form.
+ * @details Conditionals and biconditionals are expanded and negations are
+ * pushed inward until they only apply to predicates. The result only
+ * contains and, or, not, forall and exists. Each biconditional duplicates
+ * its operands.
+ * @param formula the formula to convert, it is not modified.
+ * @return a newly allocated formula in negation normal form.
+ */
+Formula* toNNF(const Formula* formula);
+
+/**
+ * @brief Converts a formula to prenex normal form.
+ * @details The formula is put in negation normal form, quantifiers that
+ * share a variable name with another quantifier or a free identifier are
+ * renamed, and all quantifiers are pulled to the front in the order they
+ * appear. The quantifier free matrix is in negation normal form.
+ * @param formula the formula to convert, it is not modified.
+ * @return a newly allocated formula in prenex normal form.
+ */
+Formula* toPrenex(const Formula* formula);
+
+/**
+ * @brief A set of clauses stored as flat arrays of literals.
+ * @details Variables are numbered from 1, a positive literal v is the
+ * variable v and a negative literal -v its negation (DIMACS convention).
+ * Read as CNF the clauses are disjunctions in a conjunction, read as DNF
+ * they are conjunctions (cubes) in a disjunction.
+ */
+struct ClauseSet{
+    std::vector<int> literals;          ///< the literals of all clauses back to back
+    std::vector<size_t> offsets = {0};  ///< clause i is literals[offsets[i]] to literals[offsets[i+1]]
+    /**
+     * atoms[v - 1] is a copy of the predicate or quantified formula
+     * variable v stands for, null for variables introduced by definitions.
+     */
+    std::vector<pFormula> atoms;
+
+    /** @return the number of clauses */
+    size_t size() const;
+
+    /** @return the number of variables */
+    size_t variables() const;
+
+    /** @return the literals of the ith clause */
+    std::span<const int> clause(size_t i) const;
+
+    /** @brief appends a clause */
+    void addClause(std::span<const int> clause);
+    void addClause(std::initializer_list<int> clause);
+
+    /**
+     * @brief allocates a new variable
+     * @param atom the atom the variable stands for, null for definitions
+     * @return the new variable
+     */
+    int newVariable(pFormula atom = nullptr);
+};
+
+/**
+ * @brief Incremental Tseitin clausifier.
+ * @details Each subformula is given a literal equivalent to it and defined
+ * by a constant number of clauses, so the output is linear in the size of
+ * the input. Structurally equal atoms and subformulae are given the same
+ * literal, across every formula defined with the same clausifier, so shared
+ * subformulae are only defined once.
+ */
+struct Tseitin{
+    ClauseSet clauses; ///< atoms and definitions produced so far
+
+    /**
+     * @brief Defines a formula, adding the clauses for any subformula not
+     * already defined.
+     * @return a literal that is true iff the formula is true.
+     */
+    int define(const Formula* formula);
+
+    /**
+     * @return the variable of an atom (predicate or quantified formula)
+     * allocating it if needed
+     */
+    int atom(const Formula* formula);
+
+    /**
+     * @brief Defines a binary connective over the literals of its operands
+     * @details Conditionals and disjunctions are rewritten to conjunctions
+     * and operands are put in a canonical order, so equivalent definitions
+     * share a variable.
+     * @return a literal that is true iff the connective holds
+     */
+    int connective(Formula::Type type, int left, int right);
+
+    /** @brief Hashes (connective, literal, literal) definition keys */
+    struct DefinitionHash{
+        size_t operator()(const std::pair<int, std::pair<int, int>>& key) const;
+    };
+
+    /** Atom keys point at the copies held in clauses.atoms */
+    std::unordered_map<const Formula*, int, FormulaPtrHash, FormulaPtrEqual> atomVariables;
+    std::unordered_map<std::pair<int, std::pair<int, int>>, int, DefinitionHash> definitions;
+};
+
+/**
+ * @brief Converts a formula to an equisatisfiable CNF via Tseitin's
+ * transformation.
+ * @return the definitional clauses and a unit clause asserting the formula
+ */
+ClauseSet toCNF(const Formula* formula);
+
+/**
+ * @brief Converts a formula to an equivalent DNF by distributing its
+ * negation normal form. Contradictory cubes are dropped.
+ * @param maxCubes the DNF can be exponentially larger than the formula,
+ * conversion stops once an intermediate result exceeds this many cubes.
+ * @throws std::runtime_error if the cube limit is exceeded.
+ */
+ClauseSet toDNF(const Formula* formula, size_t maxCubes = 1 << 16);
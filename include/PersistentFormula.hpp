@@ -0,0 +1,99 @@
+/**
+ * @file PersistentFormula.hpp
+ * @brief Immutable formulae with structural sharing
+ * @details A PersistentFormula is a snapshot of a formula that can never be
+ * modified. Subtrees are reference counted and shared between snapshots, so
+ * copies are O(1) and an edit only rebuilds the nodes on the path from the
+ * root to the edited position. Reference counts are atomic, snapshots may be
+ * read from many threads at once.
+ */
+
+#pragma once
+
+#include<queue>
+#include<memory>
+#include<string>
+#include<vector>
+
+#include"Formula.hpp"
+
+struct PersistentFormula{
+
+    /**
+     * @brief A node of a persistent formula tree,
+     * never modified after construction
+     */
+    struct Node{
+        Formula::Type type;                     ///< The type of the node
+        Formula::ConnectiveType connectiveType; ///< The connective class of the node
+        std::string var;    ///< The bound variable name, valid iff QUANT
+        pFormula pred;      ///< The predicate formula, valid iff PRED
+        std::vector<std::shared_ptr<const Node>> args; ///< Immediate subformulae
+
+        /** @brief Frees unshared subtrees without recursing */
+        ~Node();
+    };
+
+    std::shared_ptr<const Node> root; ///< null iff the formula is empty
+
+    /** @brief Creates an empty formula */
+    PersistentFormula() = default;
+
+    /** @brief Creates a persistent snapshot of formula, deep copying it once */
+    explicit PersistentFormula(const Formula* formula);
+
+    /** @brief Creates a persistent formula sharing an existing root node */
+    explicit PersistentFormula(std::shared_ptr<const Node> root);
+
+    /** @return a copy of this formula in O(1), sharing all nodes */
+    PersistentFormula copy() const;
+
+    /** @return a newly allocated mutable deep copy of this formula */
+    Formula* toFormula() const;
+
+    /** @brief true iff the formulae are syntactically equivalent */
+    bool operator==(const PersistentFormula& other) const;
+
+    /** @return true iff the formula has no root */
+    bool empty() const;
+
+    Formula::Type type() const;
+    Formula::ConnectiveType connectiveType() const;
+
+    /** @return the variable bound by a quantifier, only valid if QUANT */
+    const std::string& var() const;
+
+    /** @return the predicate at the root, only valid if PRED */
+    const Formula* predicate() const;
+
+    /** @return the number of immediate subformulae */
+    size_t arity() const;
+
+    /**
+     * @return the ith immediate subformula in left to right order,
+     * the body of a quantifier is subformula 0.
+     */
+    PersistentFormula subformula(size_t i) const;
+
+    /**
+     * @brief gets the subformula at a position
+     * @param pos the path from the root, each index selects an immediate
+     * subformula. An empty position is the whole formula.
+     * @throws std::out_of_range if the position does not exist.
+     */
+    PersistentFormula atPosition(std::queue<size_t> pos) const;
+
+    /**
+     * @brief Edits the formula at a position without modifying this formula.
+     * @details Only the nodes from the root to the position are rebuilt,
+     * every other subtree is shared with this formula.
+     * @param pos the path from the root to the subformula to replace
+     * @param replacement the new subformula to place at pos
+     * @return the edited formula
+     * @throws std::out_of_range if the position does not exist.
+     */
+    PersistentFormula replaceAt(std::queue<size_t> pos,
+                                const PersistentFormula& replacement) const;
+};
+
+std::string toSExpression(const PersistentFormula& formula);
@@ -3,12 +3,15 @@
 
 #include<set>
 #include<list>
+#include<memory>
 #include<string>
+#include<string_view>
 #include<vector>
 #include<optional>
 #include<unordered_map>
 
 #include "Formula.hpp"
+#include "AssumptionSet.hpp"
 
 /**
  * A Justification is an inference rule or Unknown
@@ -25,6 +28,10 @@ enum class Justification {
     IfElim,
     IffIntro,
     IffElim,
+    ForallIntro,
+    ForallElim,
+    ExistsIntro,
+    ExistsElim,
 };
 
 /**
@@ -32,29 +39,77 @@ enum class Justification {
  * assumptions. 
 */
 struct ProofNode {
-    size_t id;                            ///< Id of the node
-    Formula* formula;                   ///< Formulae on the node 
+    size_t id = 0;                        ///< Id of the node
+    pFormula formula;                   ///< Formulae on the node, owned by the node
     Justification justification;        ///< Justification for the node
     std::vector<ProofNode*> parents;    ///< Parents of the node
     std::list<ProofNode*> children;    ///< Children of the node
-    std::set<ProofNode*> assumptions;   ///< assumptions of the node
+    AssumptionSet assumptions;          ///< assumptions of the node
+    std::shared_ptr<AssumptionUniverse> universe;  ///< numbers the nodes of the node's graph
+    uint32_t index;                     ///< number of the node in its universe
+    size_t formulaHash = 0;             ///< structural hash of the formula, indexed by the universe
+    std::vector<uint32_t> identifiers;  ///< numbers of the identifiers free in the formula, increasing
+
+    /** @brief Creates a node numbered in a universe */
+    explicit ProofNode(std::shared_ptr<AssumptionUniverse> universe = defaultUniverse());
+
+    /** @brief Frees the number of the node and removes it from the formula index */
+    ~ProofNode();
+
+    /** @brief Replaces the formula of the node and re-indexes the node under its hash and identifiers */
+    void setFormula(pFormula formula);
 };
 
+/**
+ * @brief An owning handle to a proof node, frees the node and its formula
+ * when it goes out of scope.
+*/
+using pProofNode = std::unique_ptr<ProofNode>;
+
 /**
  * Construct a new proof node from string inputs
- * 
+ * @details the parents are not owned by the new node, the caller remains
+ * responsible for them.
+ * @param universe numbers the nodes of the graph the node is for, nodes
+ * outside of graphs share the default universe
 */
 ProofNode* newProofNode(
     std::string formulaExpr, std::string justification, 
-    std::vector<ProofNode*> parents
+    std::vector<ProofNode*> parents,
+    std::shared_ptr<AssumptionUniverse> universe = defaultUniverse()
 );
 
+/**
+ * A proof graph owns all of its nodes, they are freed along with the graph.
+*/
 struct ProofGraph{
-    std::unordered_map<size_t, ProofNode*> nodes;
-    std::set<ProofNode*> assumptions;
+    std::unordered_map<size_t, pProofNode> nodes; ///< all nodes by id
+    std::set<ProofNode*> assumptions;  ///< nodes with no parents
+    std::shared_ptr<AssumptionUniverse> universe = std::make_shared<AssumptionUniverse>(); ///< numbers the nodes
 };
 
 /**
  * Construct a proof graph based on a json string
+ * @throws std::runtime_error if the json is malformed or does not conform
+ * to res/ProofGraphSchema.json
 */
 ProofGraph* newProofGraph(std::string jsonProofGraph);
+
+/**
+ * @brief Reads proof graphs from json, keeping its schema validator and json
+ * memory from one graph to the next
+ * @details the json of a graph is parsed into an arena that is cleared
+ * rather than freed before the next, so reading many small graphs does not
+ * allocate for their json. A parser is not thread safe, give each thread
+ * its own.
+*/
+struct ProofGraphParser{
+    ProofGraphParser();
+    ~ProofGraphParser();
+
+    /** @see newProofGraph */
+    ProofGraph* parse(std::string_view jsonProofGraph);
+
+    struct State;                   ///< the json documents and validator
+    std::unique_ptr<State> state;
+};
@@ -0,0 +1,155 @@
+/**
+ * @file Rewrite.hpp
+ * @brief Pattern based formula rewriting to a fixpoint
+ * @details Rules are written as S-Expressions where propositions starting
+ * with `?` are metavariables matching any subformula, e.g.
+ * `(not (not ?x))` => `?x`. A metavariable used twice in a pattern only
+ * matches equal subformulae. `and`, `or` and `iff` patterns also match
+ * with their operands swapped. The propositions `true` and `false` are
+ * ordinary predicates, so constants are matched like any other predicate.
+ *
+ * Formulae are interned into a hash consed DAG where structurally equal
+ * subformulae share an id. Rules are applied innermost first until no rule
+ * applies, and the normal form of every id is memoized for the lifetime of
+ * the Rewriter, so shared subformulae are only rewritten once.
+ */
+
+#pragma once
+
+#include<string>
+#include<vector>
+#include<cstdint>
+#include<unordered_map>
+
+#include"Formula.hpp"
+
+/** @brief A named rewrite rule as pattern and replacement S-Expressions */
+struct RewriteRuleSpec{
+    std::string name;
+    std::string pattern;
+    std::string replacement;
+};
+
+/** @brief Removes double negations */
+const std::vector<RewriteRuleSpec> DOUBLE_NEGATION_RULES = {
+    {"DoubleNegation", "(not (not ?x))", "?x"},
+};
+
+/** @brief Removes repeated operands */
+const std::vector<RewriteRuleSpec> IDEMPOTENCE_RULES = {
+    {"AndIdempotence", "(and ?x ?x)", "?x"},
+    {"OrIdempotence", "(or ?x ?x)", "?x"},
+};
+
+/** @brief Absorbs operands implied by their siblings */
+const std::vector<RewriteRuleSpec> ABSORPTION_RULES = {
+    {"AndAbsorption", "(and ?x (or ?x ?y))", "?x"},
+    {"OrAbsorption", "(or ?x (and ?x ?y))", "?x"},
+};
+
+/** @brief Evaluates connectives applied to true, false or complementary operands */
+const std::vector<RewriteRuleSpec> CONSTANT_FOLDING_RULES = {
+    {"NotTrue", "(not true)", "false"},
+    {"NotFalse", "(not false)", "true"},
+    {"AndTrue", "(and ?x true)", "?x"},
+    {"AndFalse", "(and ?x false)", "false"},
+    {"OrTrue", "(or ?x true)", "true"},
+    {"OrFalse", "(or ?x false)", "?x"},
+    {"IfTrueAntecedent", "(if true ?x)", "?x"},
+    {"IfFalseAntecedent", "(if false ?x)", "true"},
+    {"IfTrueConsequent", "(if ?x true)", "true"},
+    {"IfFalseConsequent", "(if ?x false)", "(not ?x)"},
+    {"IffTrue", "(iff ?x true)", "?x"},
+    {"IffFalse", "(iff ?x false)", "(not ?x)"},
+    {"AndComplement", "(and ?x (not ?x))", "false"},
+    {"OrComplement", "(or ?x (not ?x))", "true"},
+    {"IfReflexive", "(if ?x ?x)", "true"},
+    {"IffReflexive", "(iff ?x ?x)", "true"},
+};
+
+/** @brief Rewrites conditionals and biconditionals with and, or and not */
+const std::vector<RewriteRuleSpec> CONDITIONAL_ELIMINATION_RULES = {
+    {"IfElimination", "(if ?x ?y)", "(or (not ?x) ?y)"},
+    {"IffElimination", "(iff ?x ?y)", "(and (or (not ?x) ?y) (or ?x (not ?y)))"},
+};
+
+/**
+ * @brief Rewrites formulae with a set of rules to a fixpoint.
+ * @details The rule set must terminate, a rule that rewrites a formula back
+ * to itself is reported as an error.
+ */
+struct Rewriter{
+
+    /** @name Interface */
+    ///@{
+
+    /**
+     * @brief Adds a rule, rules are tried in the order they are added.
+     * @throws std::runtime_error if the pattern is a lone metavariable or the
+     * replacement uses a metavariable not bound by the pattern.
+     */
+    void addRule(const RewriteRuleSpec& rule);
+
+    /** @brief Adds every rule of a rule set */
+    void addRules(const std::vector<RewriteRuleSpec>& rules);
+
+    /**
+     * @brief Rewrites a formula to its normal form under the rules.
+     * @return a newly allocated formula, the input is not modified.
+     * @throws std::runtime_error if the rules cycle or exceed stepLimit
+     */
+    Formula* rewrite(const Formula* formula);
+
+    size_t rewrites = 0;            ///< rule applications over all calls to rewrite()
+    size_t stepLimit = 1 << 26;     ///< rule applications allowed per call to rewrite()
+    ///@}
+
+    /** @name Internal State */
+    ///@{
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /**
+     * @brief A hash consed formula node. PRED nodes have an atom index as
+     * left, QUANT nodes have the body as left and a variable index as right.
+     */
+    struct Node{
+        Formula::Type type;
+        uint32_t left;
+        uint32_t right;
+    };
+
+    /** @brief A compiled rule, pattern and replacement are interned ids */
+    struct Rule{
+        std::string name;
+        uint32_t pattern;
+        uint32_t replacement;
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, uint32_t> nodeIds;     ///< interning table
+    std::vector<pFormula> atoms;                        ///< distinct predicates
+    std::vector<uint8_t> metavariables;                 ///< if each atom is a metavariable
+    std::unordered_map<const Formula*, uint32_t, FormulaPtrHash, FormulaPtrEqual> atomIds;
+    std::vector<std::string> variables;                 ///< quantified variable names
+    std::unordered_map<std::string, uint32_t> variableIds;
+    std::vector<uint32_t> normalForms;                  ///< memoized normal form of each node
+    std::vector<Rule> rules;
+    std::vector<uint32_t> rulesByType[8];               ///< rule indices by pattern root type
+
+    uint32_t intern(Formula::Type type, uint32_t left, uint32_t right);
+    uint32_t internAtom(const Formula* predicate);
+    uint32_t internFormula(const Formula* formula);
+    Formula* toFormula(uint32_t id) const;
+    bool match(uint32_t pattern, uint32_t id, std::vector<std::pair<uint32_t, uint32_t>>& bindings) const;
+    uint32_t instantiate(uint32_t replacement, const std::vector<std::pair<uint32_t, uint32_t>>& bindings);
+    uint32_t applyRules(uint32_t id);
+    uint32_t normalize(uint32_t id);
+    ///@}
+};
+
+/**
+ * @brief Simplifies a formula with the double negation, idempotence,
+ * absorption and constant folding rules.
+ * @return a newly allocated formula
+ */
+Formula* simplify(const Formula* formula);
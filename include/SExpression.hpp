@@ -40,16 +40,16 @@ struct sExpression{
     /** Default Constructor, creates an empty S-Expression */
     sExpression();
     /** Parses an S-Expresion string into an S-Expression Object */                 
-    sExpression(const std::string sExpressionString);  
+    sExpression(const std::string& sExpressionString);  
     /** Deep Copies a existing S-Expresion */       
     sExpression(const sExpression& toCopy);
     /** Moves an existing S-Expresion */
-    sExpression(const sExpression&& toMove);
+    sExpression(sExpression&& toMove) noexcept;
     /** Cleans up an S-Expression */
     ~sExpression(); 
     
     /** Move assignment, moves an existing S-Expression */
-    sExpression& operator=(const sExpression&& toMove); 
+    sExpression& operator=(sExpression&& toMove) noexcept; 
     /** Copy assignment, copies an existing S-Expression */
     sExpression& operator=(const sExpression& toCopy);
     
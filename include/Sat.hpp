@@ -0,0 +1,153 @@
+/**
+ * @file Sat.hpp
+ * @brief Embedded CDCL SAT solver and propositional validity checks
+ * @details The solver uses two watched literals for unit propagation,
+ * VSIDS branching with phase saving, first UIP clause learning with clause
+ * minimization, Luby restarts and activity based learnt clause deletion.
+ *
+ * The formula level checks clausify with the Tseitin clausifier from
+ * NormalForm.hpp. Quantified subformulae are opaque atoms, so the checks
+ * are complete for propositional and zeroth order formulae and sound, but
+ * incomplete, for quantified ones.
+ */
+
+#pragma once
+
+#include<span>
+#include<vector>
+#include<cstdint>
+
+#include"Formula.hpp"
+#include"NormalForm.hpp"
+
+/** @brief The outcome of a satisfiability check */
+enum class SatResult{
+    SAT,        ///< a model was found
+    UNSAT,      ///< no model exists
+    UNKNOWN,    ///< the conflict limit was reached first
+};
+
+/**
+ * @brief An incremental CDCL SAT solver over DIMACS style literals.
+ * @details Clauses may be added between calls to solve(), learnt clauses
+ * are kept.
+ */
+struct SatSolver{
+
+    /** @name Interface */
+    ///@{
+
+    SatSolver() = default;
+
+    /** @brief Creates a solver for the clauses of a ClauseSet */
+    explicit SatSolver(const ClauseSet& clauses);
+
+    /** @brief Adds every clause of a ClauseSet */
+    void addClauses(const ClauseSet& clauses);
+
+    /**
+     * @brief Adds a clause, variables are allocated as they are seen.
+     * @return false iff the clauses are now trivially unsatisfiable
+     */
+    bool addClause(std::span<const int> clause);
+
+    /**
+     * @brief Searches for a model of the clauses added so far.
+     * @param conflictLimit give up with UNKNOWN after this many conflicts,
+     * 0 for no limit.
+     */
+    SatResult solve(size_t conflictLimit = 0);
+
+    /** @return the value of a variable in the last model found */
+    bool value(int variable) const;
+
+    /** @return the number of variables seen so far */
+    size_t variables() const;
+
+    size_t conflicts = 0;       ///< conflicts over all calls to solve()
+    size_t decisions = 0;       ///< decisions over all calls to solve()
+    size_t propagations = 0;    ///< propagated literals over all calls to solve()
+    ///@}
+
+    /** @name Internal State */
+    ///@{
+
+    /// Literals are 2 * variable + sign with 0 based variables
+    using Lit = uint32_t;
+    static constexpr uint32_t NO_CLAUSE = UINT32_MAX;
+
+    /** @brief A problem or learnt clause, the first two literals are watched */
+    struct Clause{
+        std::vector<Lit> literals;
+        bool learnt = false;
+        bool deleted = false;
+        double activity = 0;
+    };
+
+    /** @brief A clause watching a literal and a literal that satisfies it, if true */
+    struct Watcher{
+        uint32_t clause;
+        Lit blocker;
+    };
+
+    bool inconsistent = false;                  ///< an empty clause was derived
+    std::vector<Clause> clauses;
+    std::vector<uint32_t> learnts;              ///< indices of learnt clauses
+    std::vector<std::vector<Watcher>> watches;  ///< clauses watching each literal
+    std::vector<uint8_t> values;                ///< value of each literal
+    std::vector<uint32_t> levels;               ///< decision level of each variable
+    std::vector<uint32_t> reasons;              ///< implying clause of each variable
+    std::vector<Lit> trail;                     ///< assigned literals in order
+    std::vector<size_t> trailLimits;            ///< trail size at each decision
+    size_t propagated = 0;                      ///< trail entries already propagated
+    std::vector<double> activity;               ///< VSIDS score of each variable
+    double variableIncrement = 1;
+    double clauseIncrement = 1;
+    std::vector<uint32_t> heap;                 ///< variables ordered by activity
+    std::vector<uint32_t> heapIndex;            ///< heap position of each variable
+    std::vector<uint8_t> phases;                ///< saved sign of each variable
+    std::vector<uint8_t> seen;                  ///< variables marked during conflict analysis
+    std::vector<Lit> analyzeClear;              ///< literals whose marks analysis must clear
+    std::vector<uint8_t> model;                 ///< value of each variable in the last model
+    double maxLearnts = 0;                      ///< learnt clauses kept before reducing
+    double learntAdjustConflicts = 100;         ///< conflicts between growths of maxLearnts
+    size_t learntAdjustCountdown = 100;
+
+    void ensureVariables(size_t count);
+    void attach(uint32_t clause);
+    void enqueue(Lit literal, uint32_t reason);
+    uint32_t propagate();
+    void analyze(uint32_t conflict, std::vector<Lit>& learnt, uint32_t& backtrackLevel);
+    void backtrack(uint32_t level);
+    void bumpVariable(uint32_t variable);
+    void bumpClause(Clause& clause);
+    void reduceLearnts();
+    bool locked(uint32_t clause) const;
+    void heapInsert(uint32_t variable);
+    void heapUp(size_t i);
+    void heapDown(size_t i);
+    uint32_t heapPop();
+    uint32_t decisionLevel() const;
+    SatResult search(size_t restartConflicts, size_t conflictLimit);
+    ///@}
+};
+
+/**
+ * @brief Checks if a formula is true under every assignment of its atoms
+ */
+bool isTautology(const Formula* formula);
+
+/**
+ * @brief Checks if a set of premises propositionally entails a conclusion
+ */
+bool entails(const FormulaList& premises, const Formula* conclusion);
+
+/**
+ * @brief Checks if a premise propositionally entails a conclusion
+ */
+bool entails(const Formula* premise, const Formula* conclusion);
+
+/**
+ * @brief Checks if two formulae are propositionally equivalent
+ */
+bool equivalent(const Formula* a, const Formula* b);
@@ -0,0 +1,179 @@
+/**
+ * @file TPTP.hpp
+ * @brief Streaming reader and writer for TPTP fof and cnf problems
+ * @details Annotated formulae are read one at a time from a stream, which is
+ * consumed in fixed size chunks so files of any size are read in bounded
+ * memory. Parsing uses explicit stacks, deeply nested formulae and terms do
+ * not recurse.
+ *
+ * The identifier mapping of toFirstOrderTPTP is reversed where it can be:
+ * quotes are stripped from distinct objects ("a" reads as a) and single
+ * quoted names. Variables keep their upper case names. Other mappings:
+ *  - `t1 = t2` is the predicate `eq(t1, t2)`, `t1 != t2` its negation
+ *  - `$true` and `$false` are the propositions `true` and `false`
+ *  - `a <= b` is `b => a`, `<~>`, `~|` and `~&` are negated `<=>`, `|`, `&`
+ *  - quantifiers over several variables are nested, outermost first
+ *  - `&` and `|` chains associate to the left
+ *  - cnf clauses are universally closed over their variables in order of
+ *    first appearance
+ */
+
+#pragma once
+
+#include<string>
+#include<vector>
+#include<istream>
+#include<ostream>
+#include<string_view>
+#include<unordered_map>
+
+#include"Formula.hpp"
+
+/** @brief An annotated formula read from a TPTP problem */
+struct TPTPInput{
+    std::string language;   ///< fof or cnf
+    std::string name;
+    std::string role;       ///< axiom, conjecture, ...
+    pFormula formula;
+};
+
+/**
+ * @brief Reads annotated formulae from a TPTP stream
+ * @details include directives and languages other than fof and cnf are
+ * reported as errors. Annotations after the formula are skipped.
+ */
+struct TPTPReader{
+
+    /** @name Interface */
+    ///@{
+
+    /**
+     * @param input the stream to read, it must outlive the reader
+     * @param chunkSize bytes read from the stream at a time
+     */
+    explicit TPTPReader(std::istream& input, size_t chunkSize = 1 << 16);
+
+    /**
+     * @brief Reads the next annotated formula
+     * @return false at the end of the input
+     * @throws std::runtime_error with the line number on a syntax error
+     */
+    bool next(TPTPInput& input);
+
+    size_t line = 1;        ///< line of the next unread character
+    size_t bytes = 0;       ///< bytes consumed so far
+    ///@}
+
+    /** @name Internal State */
+    ///@{
+
+    /** @brief The kinds of TPTP tokens */
+    enum class Token{
+        END,
+        LOWER_WORD,     ///< functors, predicates, names and roles
+        UPPER_WORD,     ///< variables
+        DOLLAR_WORD,    ///< defined names such as $true
+        QUOTED,         ///< a single quoted name, quotes removed
+        DISTINCT,       ///< a double quoted distinct object, quotes removed
+        NUMBER,
+        LEFT_PAREN, RIGHT_PAREN, LEFT_BRACKET, RIGHT_BRACKET,
+        COMMA, COLON, PERIOD,
+        NOT, AND, OR, IF, IF_REVERSED, IFF, XOR, NOR, NAND,
+        FORALL, EXISTS, EQUALS, NOT_EQUALS,
+    };
+
+    std::istream& input;
+    size_t chunkSize;
+    std::string buffer;         ///< unconsumed input
+    size_t position = 0;        ///< next character of buffer
+    Token token = Token::END;   ///< the current token
+    std::string text;           ///< the text of the current token
+    size_t tokenLine = 1;       ///< the line the current token starts on
+    bool collectVariables = false;              ///< if variables are collected, only for cnf
+    std::vector<std::string> freeVariables;     ///< cnf variables by first appearance
+
+    int peek(size_t ahead = 0);
+    int refill(size_t ahead);
+    void advance(size_t count = 1);
+    void lex();
+    void expect(Token expected, const char* description);
+    [[noreturn]] void error(const std::string& message) const;
+    Term* parseTerm();
+    Formula* parseAtom();
+    Formula* parseFormula();
+    void skipAnnotations();
+    ///@}
+};
+
+/** @brief Reads every annotated formula of a TPTP problem held in memory */
+std::vector<TPTPInput> parseTPTP(const std::string& problem);
+
+/**
+ * @brief Formats first order formulae as TPTP fof annotated formulae
+ * @details Identifiers are made legal while the formula is printed, in one
+ * pass and without copying it:
+ *  - predicates and functions are lower cased words
+ *  - quantified variables and the constants they bind are upper cased words
+ *  - free constants are written as distinct objects, in double quotes
+ *
+ * Whether a constant is bound is decided by the quantifiers open at that
+ * point of the traversal. Legalized identifiers are cached for the lifetime
+ * of the formatter, identifiers that are already legal are not copied.
+ */
+struct TPTPFormatter{
+    /**
+     * @brief Appends `fof(name,role,formula).` to out
+     * @throws std::runtime_error if the formula is not first order, out is
+     * left as it was
+     */
+    void append(std::string& out, const std::string& name, const std::string& role, const Formula* formula);
+
+    /** @name Internal State */
+    ///@{
+    std::unordered_map<std::string, std::string> lowerIdentifiers;  ///< legal predicate and function names
+    std::unordered_map<std::string, std::string> upperIdentifiers;  ///< legal variable names
+    std::unordered_map<std::string_view, size_t> binders;           ///< open quantifiers of each bound variable
+    std::vector<const Term*> terms;
+
+    /** @return the legal TPTP form of an identifier */
+    const std::string& identifier(const std::string& name, bool upper);
+
+    /** @return true iff a quantifier binding name is open */
+    bool isBound(const std::string& name) const;
+    ///@}
+};
+
+/**
+ * @brief Writes fof annotated formulae to a stream, one per line
+ * @details Output is collected in a buffer and written to the stream in
+ * large blocks, the buffer is flushed when the writer is destroyed.
+ */
+struct TPTPWriter{
+
+    /**
+     * @param output the stream to write, it must outlive the writer
+     * @param bufferSize bytes collected before they are written to output
+     */
+    explicit TPTPWriter(std::ostream& output, size_t bufferSize = 1 << 16);
+    ~TPTPWriter();
+
+    TPTPWriter(const TPTPWriter&) = delete;
+    TPTPWriter& operator=(const TPTPWriter&) = delete;
+
+    /**
+     * @brief Writes a formula as `fof(name,role,formula).`
+     * @throws std::runtime_error if the formula is not first order, nothing
+     * is written for it
+     */
+    void write(const std::string& name, const std::string& role, const Formula* formula);
+
+    /** @brief Writes the buffered output to the stream */
+    void flush();
+
+    size_t formulae = 0;    ///< formulae written so far
+
+    std::ostream& output;
+    size_t bufferSize;
+    std::string buffer;
+    TPTPFormatter formatter;
+};
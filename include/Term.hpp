@@ -3,6 +3,7 @@
 
 #include<string>
 #include<list>
+#include<memory>
 #include<unordered_set>
 
 struct Term;
@@ -10,6 +11,9 @@ struct Term;
 /** @brief represents a list of term trees */
 using TermList = std::list<Term*>;
 
+/** @brief An owning handle to a term, frees the term tree when it goes out of scope */
+using pTerm = std::unique_ptr<Term>;
+
 /**
  * @brief Represents an term level construct such as constants, term variables,
  * functions with args, and function variables. 
@@ -34,8 +38,18 @@ struct Term{
     Term() = default;
     ~Term();
 
+    /** @brief Terms own their args, use copy() for deep copies */
+    Term(const Term&) = delete;
+    Term& operator=(const Term&) = delete;
+
+    /** @brief Steals the name and args of other, leaving other without args */
+    Term(Term&& other) noexcept;
+
+    /** @brief Frees the current args and steals the name and args of other */
+    Term& operator=(Term&& other) noexcept;
+
     /** @brief  true iff two terms are syntactically equivelent */
-    bool operator==(const Term& term);
+    bool operator==(const Term& term) const;
 
     /**
      * @brief Creates a copy of this term and returns 
@@ -0,0 +1,106 @@
+/**
+ * @file TruthTable.hpp
+ * @brief Bit-parallel truth tables of propositional formulae
+ * @details A formula is compiled once into a straight-line program over its
+ * propositions, with structurally equal subformulae computed once. The
+ * program is then run on bit vectors where bit a of a word is the value
+ * under assignment a, so every instruction evaluates 64 assignments per word
+ * and a block of words per loop the compiler can vectorize.
+ *
+ * Proposition i is bit i of the assignment index, so its bit pattern is
+ * a constant within a word for i < 6 and a whole word of ones or zeros
+ * otherwise.
+ */
+
+#pragma once
+
+#include<string>
+#include<vector>
+#include<cstdint>
+
+#include"Formula.hpp"
+
+/** @brief The largest number of propositions a truth table is built for */
+constexpr size_t MAX_TRUTH_TABLE_ATOMS = 24;
+
+/**
+ * @brief The truth table of a formula as a bitmap over all assignments
+ */
+struct TruthTable{
+    std::vector<std::string> atoms; ///< the propositions, atom i is bit i of an assignment
+    std::vector<uint64_t> bits;     ///< bit a is the value of the formula under assignment a
+
+    /** @return the number of assignments, 2 ^ atoms */
+    size_t assignments() const;
+
+    /** @return the value of the formula under an assignment */
+    bool value(size_t assignment) const;
+
+    /** @return the number of satisfying assignments */
+    size_t models() const;
+
+    /** @return true iff the formula is true under every assignment */
+    bool isTautology() const;
+
+    /** @return true iff the formula is true under some assignment */
+    bool isSatisfiable() const;
+
+    /** @brief true iff both tables are over the same atoms and agree */
+    bool operator==(const TruthTable& other) const;
+};
+
+/**
+ * @brief A propositional formula compiled to a straight-line program
+ */
+struct CompiledFormula{
+    /** @brief The operation of an instruction */
+    enum class Op : uint8_t{
+        ATOM,   ///< load the pattern of atom left
+        NOT,
+        AND,
+        OR,
+        IF,
+        IFF,
+    };
+
+    /**
+     * @brief An instruction writing to its own register, operands are the
+     * indices of earlier instructions. The last instruction is the result.
+     */
+    struct Instruction{
+        Op op;
+        uint32_t left;
+        uint32_t right;
+    };
+
+    std::vector<std::string> atoms;
+    std::vector<Instruction> program;
+
+    /** @brief runs the program on every assignment of the atoms */
+    TruthTable evaluate() const;
+};
+
+/**
+ * @brief Compiles a propositional formula over its propositions in the order
+ * they first appear.
+ * @throws std::runtime_error if the formula is not propositional or has more
+ * than MAX_TRUTH_TABLE_ATOMS propositions.
+ */
+CompiledFormula compilePropositional(const Formula* formula);
+
+/**
+ * @brief Compiles a propositional formula over a given list of atoms, which
+ * must contain every proposition of the formula.
+ * @throws std::runtime_error if the formula is not propositional, uses a
+ * proposition not in atoms, or atoms is too long.
+ */
+CompiledFormula compilePropositional(const Formula* formula, const std::vector<std::string>& atoms);
+
+/** @brief Compiles and evaluates the truth table of a propositional formula */
+TruthTable truthTable(const Formula* formula);
+
+/**
+ * @brief Checks if two propositional formulae have the same truth table
+ * over the union of their propositions.
+ */
+bool truthTableEquivalent(const Formula* a, const Formula* b);
@@ -43,4 +43,8 @@ const std::unordered_map<std::string, Justification> JUSTIFICATION_STRING_MAP =
     {"IfElim", Justification::IfElim},
     {"IffIntro", Justification::IffIntro},
     {"IffElim", Justification::IffElim},
+    {"ForallIntro", Justification::ForallIntro},
+    {"ForallElim", Justification::ForallElim},
+    {"ExistsIntro", Justification::ExistsIntro},
+    {"ExistsElim", Justification::ExistsElim},
 };
\ No newline at end of file
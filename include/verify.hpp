@@ -1,18 +1,310 @@
 
 #pragma once
 
+#include<list>
+#include<span>
+#include<mutex>
+#include<atomic>
+#include<string>
+#include<vector>
+#include<string_view>
+#include<cstdint>
+#include<unordered_set>
+#include<unordered_map>
+
 #include"ProofGraph.hpp"
 
+/**
+ * What a failed condition of a proof node expected
+*/
+enum class VerifyErrorCode : uint8_t {
+    PARENT_COUNT,           ///< the node has `actual` parents rather than `expected`
+    CONNECTIVE,             ///< formulas[0] does not have top level connective `connective`
+    BINARY_CONNECTIVE,      ///< formulas[0] does not have a binary top level connective
+    NOT_EQUAL,              ///< formulas[0] does not equal formulas[1]
+    MISSING_ASSUMPTION,     ///< formulas[0] does not have formulas[1] as an assumption
+    NOT_INSTANCE,           ///< formulas[0] is not an instance of the quantifier formulas[1]
+    MISSING_INSTANCE,       ///< formulas[0] has no instance of the quantifier formulas[1] as an assumption
+    NOT_CONSTANT,           ///< `term`, which a quantified variable is replaced by, is not a constant
+    EIGENVARIABLE,          ///< the eigenvariable `term` of formulas[0] occurs free in formulas[1]
+    PARENT_FAILED,          ///< the node's parent with id `parent` did not verify
+    CYCLE,                  ///< the node is on or depends on a cycle
+};
+
+/**
+ * A failed condition of a proof node
+ * @details the formulae are borrowed from the node and its parents, they are
+ * only valid while those formulae are. Which fields are set depends on the
+ * code.
+*/
+struct VerifyCondition{
+    static constexpr int8_t CONCLUSION = -1;    ///< the role of the node itself
+    static constexpr int8_t ASSUMPTION = -2;    ///< the role of an assumption of the premises
+
+    VerifyErrorCode code;
+    const Formula* formulas[2] = {nullptr, nullptr};
+    int8_t roles[2] = {CONCLUSION, CONCLUSION}; ///< premise role each formula is or is part of
+    Formula::Type connective = Formula::Type::PRED;
+    const Term* term = nullptr;
+    size_t expected = 0;
+    size_t actual = 0;
+    size_t parent = 0;
+
+    /** @return the condition in English, without a full stop */
+    std::string message() const;
+};
+
+/**
+ * Why a proof node did not verify, its message is only built when asked for
+*/
+struct VerifyError{
+    Justification rule;                             ///< justification of the node
+    VerifyCondition condition;
+    std::optional<VerifyCondition> alternative = std::nullopt;  ///< set if either condition would have done
+
+    /** @return the error in English */
+    std::string message() const;
+};
+
+/**
+ * A thread safe memo of rule verdicts, shared between proofs
+ * @details entries are keyed by the justification of a node, the hash of its
+ * conclusion and the hashes of its parents' formulae in order, and hold the
+ * verdict with the assignment of parents to premise roles it was reached
+ * with. A node matching an entry only has its rule checked for that one
+ * assignment rather than searched over every assignment. A verified entry
+ * is only taken if that check passes, which keeps hash collisions and rules
+ * reading the assumptions of their premises sound. Failed verdicts of rules
+ * that read assumptions are not kept, as they depend on more than the
+ * formulae.
+ *
+ * Entries are spread over shards by key, each with its own lock and least
+ * recently used order, and a full shard evicts its least recently used entry.
+*/
+struct VerifyCache{
+
+    struct Key{
+        Justification justification;
+        size_t conclusion;                  ///< hash of the node's formula
+        std::vector<size_t> parents;        ///< hashes of the parents' formulae in order
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash{
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry{
+        bool verified;
+        std::vector<uint32_t> assignment;   ///< index of the parent taken for each premise
+    };
+
+    struct Stats{
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t entries;
+    };
+
+    /**
+     * @param capacity most entries kept over all shards
+     * @param shards number of independently locked parts, at least one
+    */
+    explicit VerifyCache(size_t capacity = 1 << 16, size_t shards = 16);
+
+    /** @return the entry of a key, marking it most recently used */
+    std::optional<Entry> find(const Key& key);
+
+    /** @brief Adds or replaces the entry of a key, evicting if its shard is full */
+    void insert(const Key& key, Entry entry);
+
+    Stats stats() const;
+
+    /** @brief Removes every entry and resets the counters */
+    void clear();
+
+    /** @name Internal State */
+    ///@{
+    struct Shard{
+        mutable std::mutex mutex;
+        std::list<std::pair<Key, Entry>> order;     ///< most recently used first
+        std::unordered_map<Key, std::list<std::pair<Key, Entry>>::iterator, KeyHash> entries;
+    };
+
+    size_t shardCapacity;
+    std::vector<Shard> shards;
+    std::atomic<size_t> hits = 0;           ///< nodes verified from an entry
+    std::atomic<size_t> misses = 0;         ///< nodes searched in full
+    std::atomic<size_t> evictions = 0;
+
+    Shard& shardOf(const Key& key);
+    ///@}
+};
+
 /**
  * Verify a single proof node
  * @param node a pointer to a proof node to verify (probably created via
  *  newProofNode). `node->assumptions` will be overwritten by this function.
+ * @return std::nullopt if the node is verified, else why it wasn't able to
+ * verify. For a node with several parents this is the assignment of parents
+ * to premise roles that failed deepest into the rule.
+ * @param cache a memo of rule verdicts to consult and fill, or nullptr
+*/
+std::optional<VerifyError> verifyNode(ProofNode* node, VerifyCache* cache = nullptr);
+
+/**
+ * Verify a single proof node
  * @return an optional string, if std::nullopt the node is verified else 
  * contains the error string of why it wasn't able to verify.
+ * @see verifyNode
 */
 std::optional<std::string> verify(ProofNode* node);
 
 /**
- * In Development 
+ * Verify every node of a proof graph
+ * @details nodes are verified once each, in a topological order found with
+ * Kahn's algorithm over `children`, so every node is verified after its
+ * parents. A node whose parent did not verify, or that is on or after a
+ * cycle, is reported as an error without being checked. The assumptions of
+ * a node that did not verify are cleared.
+ *
+ * With several threads, nodes whose parents are all finished are verified
+ * concurrently by workers stealing from each others queues. The results do
+ * not depend on the number of threads.
+ * @param threads number of threads verifying nodes, 0 for one per core
+ * @param cache a memo of rule verdicts shared by the threads, or nullptr
+ * @return a json string conforming to res/VerifyResultsSchema.json, with the
+ * assumptions of each verified node and the errors of the others, both in
+ * order of id.
+*/
+std::string verifyProofGraph(ProofGraph& graph, size_t threads = 1, VerifyCache* cache = nullptr);
+
+/**
+ * Verify a proof graph given as a json string
+ * @param jsonProofGraph a json string conforming to res/ProofGraphSchema.json
+ * @throws std::runtime_error if the json is malformed or does not conform
+ * @see verifyProofGraph(ProofGraph&, size_t, VerifyCache*)
+*/
+std::string verifyProofGraph(const std::string& jsonProofGraph, size_t threads = 1,
+                             VerifyCache* cache = nullptr);
+
+/**
+ * The outcome of one proof graph of a batch
 */
-//std::string verifyProofGraph(const std::string& jsonProofGraph);
+struct BatchResult{
+    std::string results;    ///< as verifyProofGraph() returns them, empty if the graph was rejected
+    std::string error;      ///< why the json was rejected, empty if the graph was verified
+};
+
+/**
+ * Verify many proof graphs given as json strings
+ * @details graphs are parsed and verified concurrently, one graph per thread
+ * at a time, each thread taking the next graph once it is done with its
+ * last. Every thread keeps one ProofGraphParser, and so one schema validator
+ * and json arena, for all the graphs it takes.
+ * @param jsonProofGraphs json strings conforming to res/ProofGraphSchema.json,
+ * they are only read during the call
+ * @param threads number of threads, 0 for one per core
+ * @param cache a memo of rule verdicts shared by all graphs, or nullptr
+ * @return the outcome of each graph in input order, a graph that is
+ * malformed or does not conform is reported rather than thrown
+*/
+std::vector<BatchResult> verifyBatch(std::span<const std::string_view> jsonProofGraphs, size_t threads = 0,
+                                     VerifyCache* cache = nullptr);
+
+/**
+ * How far a node of a proof graph got
+*/
+enum class NodeStatus : uint8_t {
+    UNREACHED,      ///< on or after a cycle
+    VERIFIED,
+    FAILED,
+};
+
+/**
+ * An incremental verification of a proof graph that is being edited
+ * @details edits change the graph straight away and mark the nodes they
+ * affect dirty. update() re-verifies the dirty nodes in topological order.
+ * Only the children of a node whose status, error or assumptions changed
+ * are re-verified after it, so an edit costs the part of its cone that
+ * actually changes rather than the whole graph.
+ *
+ * Every node keeps a level, 0 for nodes without parents and one more than
+ * its deepest parent otherwise, which orders re-verification and bounds
+ * the search for cycles when a link is added. Nodes on or after a cycle have
+ * no level.
+ *
+ * The results after update() are always the same as verifyProofGraph() of
+ * the edited graph.
+*/
+struct VerificationSession{
+
+    /** @name Interface */
+    ///@{
+
+    /**
+     * @brief Verifies every node of a graph, the graph and the cache, if
+     * any, must outlive the session
+    */
+    explicit VerificationSession(ProofGraph& graph, VerifyCache* cache = nullptr);
+
+    /**
+     * @name Edits
+     * @throws std::runtime_error if a node or link does not exist, a node
+     * already exists or a justification is unknown.
+    */
+    ///@{
+    void setFormula(size_t id, const std::string& formula);
+    void setJustification(size_t id, const std::string& justification);
+    void addNode(size_t id, const std::string& formula, const std::string& justification);
+    void removeNode(size_t id);
+    void addLink(size_t from, size_t to);
+    void removeLink(size_t from, size_t to);        ///< removes one link if there are several
+    ///@}
+
+    /**
+     * @brief Re-verifies the nodes affected by the edits since the last update
+     * @return the ids of nodes whose results changed, in increasing order
+    */
+    std::vector<size_t> update();
+
+    /** @return the status of a node as of the last update */
+    NodeStatus status(size_t id) const;
+
+    /** @return the error of a node as of the last update, nullopt if it verified */
+    std::optional<std::string> error(size_t id) const;
+
+    /**
+     * @return the results as of the last update, as verifyProofGraph() returns
+     * them. Call update() after edits first.
+    */
+    std::string results() const;
+
+    size_t reverified = 0;      ///< nodes verified by update() over the session
+    ///@}
+
+    /** @name Internal State */
+    ///@{
+    static constexpr uint32_t NO_LEVEL = UINT32_MAX;
+
+    struct NodeState{
+        NodeStatus status = NodeStatus::UNREACHED;
+        uint32_t level = NO_LEVEL;
+        std::string error;
+    };
+
+    ProofGraph& graph;
+    VerifyCache* cache;
+    std::unordered_map<const ProofNode*, NodeState> states;
+    std::unordered_set<ProofNode*> unreached;           ///< nodes without a level
+    std::unordered_set<ProofNode*> dirty;               ///< nodes to re-verify
+
+    ProofNode* nodeAt(size_t id) const;
+    uint32_t levelFromParents(const ProofNode* node) const;
+    void relevel(ProofNode* node);
+    void markUnreached(ProofNode* node);
+    bool reaches(ProofNode* from, const ProofNode* to, uint32_t maxLevel) const;
+    void levelUnreached();
+    bool reverify(ProofNode* node);
+    ///@}
+};
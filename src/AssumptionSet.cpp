@@ -0,0 +1,453 @@
+
+#include<bit>
+#include<algorithm>
+#include<stdexcept>
+
+#include"AssumptionSet.hpp"
+#include"ProofGraph.hpp"
+
+// Universes ===================================================================
+
+uint32_t AssumptionUniverse::add(ProofNode* node){
+    std::lock_guard<std::mutex> lock(mutex);
+    if(nodes.size() == UINT32_MAX){
+        throw std::runtime_error("Assumption universe is full");
+    }
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+void AssumptionUniverse::remove(uint32_t index){
+    std::lock_guard<std::mutex> lock(mutex);
+    nodes[index] = nullptr;
+}
+
+std::vector<uint32_t> AssumptionUniverse::intern(const std::unordered_set<std::string>& names){
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<uint32_t> rv;
+    rv.reserve(names.size());
+    for(const std::string& name : names){
+        auto [itr, added] = identifierNumbers.emplace(name, identifiers.size());
+        if(added){
+            identifiers.emplace_back();
+        }
+        rv.push_back(itr->second);
+    }
+    std::sort(rv.begin(), rv.end());
+    return rv;
+}
+
+uint32_t AssumptionUniverse::identifierNumber(const std::string& name) const{
+    auto itr = identifierNumbers.find(name);
+    return itr == identifierNumbers.end() ? UINT32_MAX : itr->second;
+}
+
+void AssumptionUniverse::index(const ProofNode* node){
+    std::lock_guard<std::mutex> lock(mutex);
+    AssumptionSet of = AssumptionSet::of(node);
+    AssumptionSet& set = formulas[node->formulaHash];
+    set = set.unite(of);
+    for(uint32_t identifier : node->identifiers){
+        identifiers[identifier] = identifiers[identifier].unite(of);
+    }
+}
+
+void AssumptionUniverse::unindex(const ProofNode* node){
+    std::lock_guard<std::mutex> lock(mutex);
+    AssumptionSet of = AssumptionSet::of(node);
+    for(uint32_t identifier : node->identifiers){
+        identifiers[identifier] = identifiers[identifier].minus(of);
+    }
+    auto itr = formulas.find(node->formulaHash);
+    if(itr == formulas.end()){
+        return;
+    }
+    itr->second = itr->second.minus(of);
+    if(itr->second.empty()){
+        formulas.erase(itr);
+    }
+}
+
+const AssumptionSet& AssumptionUniverse::withFormulaHash(size_t hash) const{
+    static const AssumptionSet none;
+    auto itr = formulas.find(hash);
+    return itr == formulas.end() ? none : itr->second;
+}
+
+const AssumptionSet& AssumptionUniverse::withIdentifier(uint32_t number) const{
+    return identifiers[number];
+}
+
+std::shared_ptr<AssumptionUniverse> defaultUniverse(){
+    static std::shared_ptr<AssumptionUniverse> universe = std::make_shared<AssumptionUniverse>();
+    return universe;
+}
+
+// Tries =======================================================================
+
+/** @return the position of the child for a bit among the children of a node */
+inline size_t childPosition(const AssumptionSet::Node* node, uint32_t bit){
+    return std::popcount(node->bits & (((uint64_t)1 << bit) - 1));
+}
+
+/** @return the slot of a number in a node at a level */
+inline uint32_t slot(uint32_t index, uint32_t level){
+    return ((uint64_t)index >> (6 * level)) & 63;
+}
+
+/** @return the union of two subtries at the same level, one of them if it holds the other */
+std::shared_ptr<const AssumptionSet::Node> uniteNodes(
+    const std::shared_ptr<const AssumptionSet::Node>& x,
+    const std::shared_ptr<const AssumptionSet::Node>& y,
+    uint32_t level
+){
+    using Node = AssumptionSet::Node;
+    if(x == y || !y){
+        return x;
+    }
+    if(!x){
+        return y;
+    }
+    uint64_t bits = x->bits | y->bits;
+    bool sameX = bits == x->bits;
+    bool sameY = bits == y->bits;
+    if(level == 0){
+        return sameX ? x : sameY ? y : std::make_shared<const Node>(Node{bits, {}});
+    }
+    std::vector<std::shared_ptr<const Node>> children;
+    children.reserve(std::popcount(bits));
+    size_t i = 0, j = 0;
+    for(uint64_t rest = bits; rest != 0; rest &= rest - 1){
+        uint64_t bit = rest & -rest;
+        std::shared_ptr<const Node> childX = x->bits & bit ? x->children[i++] : nullptr;
+        std::shared_ptr<const Node> childY = y->bits & bit ? y->children[j++] : nullptr;
+        std::shared_ptr<const Node> child = uniteNodes(childX, childY, level - 1);
+        sameX = sameX && child == childX;
+        sameY = sameY && child == childY;
+        children.push_back(std::move(child));
+    }
+    if(sameX){
+        return x;
+    }
+    if(sameY){
+        return y;
+    }
+    return std::make_shared<const Node>(Node{bits, std::move(children)});
+}
+
+/** @return the intersection of two subtries at the same level, null if it is empty */
+std::shared_ptr<const AssumptionSet::Node> intersectNodes(
+    const std::shared_ptr<const AssumptionSet::Node>& x,
+    const std::shared_ptr<const AssumptionSet::Node>& y,
+    uint32_t level
+){
+    using Node = AssumptionSet::Node;
+    if(x == y){
+        return x;
+    }
+    uint64_t bits = x->bits & y->bits;
+    if(bits == 0){
+        return nullptr;
+    }
+    if(level == 0){
+        return bits == x->bits ? x : bits == y->bits ? y : std::make_shared<const Node>(Node{bits, {}});
+    }
+    uint64_t kept = 0;
+    std::vector<std::shared_ptr<const Node>> children;
+    bool sameX = bits == x->bits;
+    bool sameY = bits == y->bits;
+    for(uint64_t rest = bits; rest != 0; rest &= rest - 1){
+        uint32_t bit = std::countr_zero(rest);
+        const std::shared_ptr<const Node>& childX = x->children[childPosition(x.get(), bit)];
+        const std::shared_ptr<const Node>& childY = y->children[childPosition(y.get(), bit)];
+        std::shared_ptr<const Node> child = intersectNodes(childX, childY, level - 1);
+        sameX = sameX && child == childX;
+        sameY = sameY && child == childY;
+        if(child){
+            kept |= (uint64_t)1 << bit;
+            children.push_back(std::move(child));
+        }
+    }
+    if(sameX){
+        return x;
+    }
+    if(sameY){
+        return y;
+    }
+    if(kept == 0){
+        return nullptr;
+    }
+    return std::make_shared<const Node>(Node{kept, std::move(children)});
+}
+
+/** @return the members of x not in y at the same level, x if they share none */
+std::shared_ptr<const AssumptionSet::Node> minusNodes(
+    const std::shared_ptr<const AssumptionSet::Node>& x,
+    const std::shared_ptr<const AssumptionSet::Node>& y,
+    uint32_t level
+){
+    using Node = AssumptionSet::Node;
+    if(x == y){
+        return nullptr;
+    }
+    if((x->bits & y->bits) == 0){
+        return x;
+    }
+    if(level == 0){
+        uint64_t bits = x->bits & ~y->bits;
+        return bits == 0 ? nullptr : std::make_shared<const Node>(Node{bits, {}});
+    }
+    uint64_t kept = 0;
+    std::vector<std::shared_ptr<const Node>> children;
+    bool same = true;
+    size_t k = 0;
+    for(uint64_t rest = x->bits; rest != 0; rest &= rest - 1, k++){
+        uint32_t bit = std::countr_zero(rest);
+        std::shared_ptr<const Node> child = x->children[k];
+        if(y->bits & ((uint64_t)1 << bit)){
+            child = minusNodes(child, y->children[childPosition(y.get(), bit)], level - 1);
+            same = same && child == x->children[k];
+        }
+        if(child){
+            kept |= (uint64_t)1 << bit;
+            children.push_back(std::move(child));
+        }
+    }
+    if(same){
+        return x;
+    }
+    if(kept == 0){
+        return nullptr;
+    }
+    return std::make_shared<const Node>(Node{kept, std::move(children)});
+}
+
+/**
+ * @return the subtrie of a set at a lower height, the one under slot 0 of
+ * each level above it, or null if there is none
+*/
+std::shared_ptr<const AssumptionSet::Node> lowered(const AssumptionSet& set, uint32_t height){
+    std::shared_ptr<const AssumptionSet::Node> node = set.root;
+    for(uint32_t level = set.height; level > height; level--){
+        if(!(node->bits & 1)){
+            return nullptr;
+        }
+        node = node->children[0];
+    }
+    return node;
+}
+
+bool equalNodes(const AssumptionSet::Node* x, const AssumptionSet::Node* y, uint32_t level){
+    if(x == y){
+        return true;
+    }
+    if(x->bits != y->bits){
+        return false;
+    }
+    if(level > 0){
+        for(size_t i = 0; i < x->children.size(); i++){
+            if(!equalNodes(x->children[i].get(), y->children[i].get(), level - 1)){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t countNodes(const AssumptionSet::Node* node, uint32_t level){
+    if(level == 0){
+        return std::popcount(node->bits);
+    }
+    size_t rv = 0;
+    for(const auto& child : node->children){
+        rv += countNodes(child.get(), level - 1);
+    }
+    return rv;
+}
+
+// Sets ========================================================================
+
+AssumptionSet AssumptionSet::of(const ProofNode* node){
+    AssumptionSet rv;
+    rv.universe = node->universe.get();
+    uint32_t index = node->index;
+    while(((uint64_t)index >> (6 * (rv.height + 1))) != 0){
+        rv.height++;
+    }
+    rv.root = std::make_shared<const Node>(Node{(uint64_t)1 << slot(index, 0), {}});
+    for(uint32_t level = 1; level <= rv.height; level++){
+        rv.root = std::make_shared<const Node>(Node{(uint64_t)1 << slot(index, level), {rv.root}});
+    }
+    return rv;
+}
+
+AssumptionSet AssumptionSet::unite(const AssumptionSet& other) const{
+    if(other.empty()){
+        return *this;
+    }
+    if(empty()){
+        return other;
+    }
+    if(universe != other.universe){
+        throw std::runtime_error("Assumption sets of different universes can not be united");
+    }
+    //Lift the lower trie so both have the same height, its numbers are all in slot 0
+    AssumptionSet a = *this;
+    AssumptionSet b = other;
+    uint32_t height = std::max(a.height, b.height);
+    a.lift(height);
+    b.lift(height);
+    std::shared_ptr<const Node> root = uniteNodes(a.root, b.root, height);
+    if(root == this->root){
+        return *this;
+    }
+    if(root == other.root){
+        return other;
+    }
+    a.root = std::move(root);
+    return a;
+}
+
+AssumptionSet AssumptionSet::intersect(const AssumptionSet& other) const{
+    if(empty() || other.empty() || universe != other.universe){
+        return AssumptionSet();
+    }
+    //Numbers above the lower trie are in neither set
+    AssumptionSet rv = height < other.height ? *this : other;
+    std::shared_ptr<const Node> x = lowered(*this, rv.height);
+    std::shared_ptr<const Node> y = lowered(other, rv.height);
+    rv.root = x && y ? intersectNodes(x, y, rv.height) : nullptr;
+    rv.shrink();
+    return rv;
+}
+
+AssumptionSet AssumptionSet::minus(const AssumptionSet& other) const{
+    if(empty() || other.empty() || universe != other.universe){
+        return *this;
+    }
+    //Lift other if it is lower, or drop its numbers above this one
+    AssumptionSet rv = *this;
+    AssumptionSet removed = other;
+    removed.lift(rv.height);
+    removed.root = lowered(removed, rv.height);
+    if(!removed.root){
+        return *this;
+    }
+    rv.root = minusNodes(rv.root, removed.root, rv.height);
+    if(rv.root == root){
+        return *this;
+    }
+    rv.shrink();
+    return rv;
+}
+
+bool AssumptionSet::contains(const ProofNode* node) const{
+    if(empty() || node->universe.get() != universe){
+        return false;
+    }
+    uint32_t index = node->index;
+    if(((uint64_t)index >> (6 * (height + 1))) != 0){
+        return false;
+    }
+    const Node* n = root.get();
+    for(uint32_t level = height; level > 0; level--){
+        uint32_t bit = slot(index, level);
+        if(!(n->bits & ((uint64_t)1 << bit))){
+            return false;
+        }
+        n = n->children[childPosition(n, bit)].get();
+    }
+    return n->bits & ((uint64_t)1 << slot(index, 0));
+}
+
+bool AssumptionSet::empty() const{
+    return !root;
+}
+
+size_t AssumptionSet::size() const{
+    return empty() ? 0 : countNodes(root.get(), height);
+}
+
+void AssumptionSet::clear(){
+    *this = AssumptionSet();
+}
+
+bool AssumptionSet::operator==(const AssumptionSet& other) const{
+    if(empty() || other.empty()){
+        return empty() == other.empty();
+    }
+    return universe == other.universe && height == other.height &&
+           equalNodes(root.get(), other.root.get(), height);
+}
+
+/** @brief Adds roots with only slot 0 until the trie is at least height high */
+void AssumptionSet::lift(uint32_t height){
+    while(this->height < height){
+        root = std::make_shared<const Node>(Node{1, {root}});
+        this->height++;
+    }
+}
+
+/** @brief Removes a root with only slot 0, and the universe of an empty set */
+void AssumptionSet::shrink(){
+    if(!root){
+        clear();
+        return;
+    }
+    while(height > 0 && root->bits == 1){
+        root = root->children[0];
+        height--;
+    }
+}
+
+// Iteration ===================================================================
+
+AssumptionSet::Iterator AssumptionSet::begin() const{
+    Iterator rv;
+    rv.set = this;
+    if(!empty()){
+        rv.stack[0] = {root.get(), root->bits, 0};
+        rv.depth = 1;
+        rv.advance();
+    }
+    return rv;
+}
+
+AssumptionSet::Iterator AssumptionSet::end() const{
+    Iterator rv;
+    rv.set = this;
+    return rv;
+}
+
+ProofNode* AssumptionSet::Iterator::operator*() const{
+    return set->universe->nodes[index];
+}
+
+AssumptionSet::Iterator& AssumptionSet::Iterator::operator++(){
+    advance();
+    return *this;
+}
+
+bool AssumptionSet::Iterator::operator==(const Iterator& other) const{
+    return depth == other.depth && (depth == 0 || index == other.index);
+}
+
+/** @brief Moves to the next member, descending into the next child until a leaf */
+void AssumptionSet::Iterator::advance(){
+    while(depth > 0){
+        Frame& top = stack[depth - 1];
+        if(top.bits == 0){
+            depth--;
+            continue;
+        }
+        uint32_t bit = std::countr_zero(top.bits);
+        top.bits &= top.bits - 1;
+        uint32_t level = set->height - (depth - 1);
+        if(level == 0){
+            index = top.base + bit;
+            return;
+        }
+        const Node* child = top.node->children[childPosition(top.node, bit)].get();
+        stack[depth++] = {child, child->bits, top.base + (uint32_t)((uint64_t)bit << (6 * level))};
+    }
+}
@@ -0,0 +1,527 @@
+
+#include<string>
+#include<vector>
+#include<cstring>
+#include<fstream>
+#include<tuple>
+#include<utility>
+#include<algorithm>
+#include<stdexcept>
+#include<string_view>
+#include<unordered_map>
+
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+#include "Binary.hpp"
+#include "FormulaVisitor.hpp"
+#include "settings.hpp"
+
+/** @brief The kind of a formula record, the low bits of its tag */
+enum class RecordKind : uint32_t{
+    PRED, NOT, AND, OR, IF, IFF, FORALL, EXISTS,
+    REF,    ///< followed by the offset of an earlier, equal record
+};
+
+constexpr uint32_t KIND_BITS = 4;
+constexpr uint32_t KIND_MASK = (1u << KIND_BITS) - 1;
+constexpr uint32_t SHARED_FLAG = 1u << KIND_BITS;
+constexpr uint32_t PAYLOAD_SHIFT = KIND_BITS + 1;
+constexpr uint32_t ARITY_BITS = 8;
+constexpr uint32_t ARITY_ESCAPE = (1u << ARITY_BITS) - 1;    ///< the arity follows in its own word
+constexpr uint32_t MAX_SYMBOLS = 1u << (32 - ARITY_BITS);
+
+// Writing =====================================================================
+
+/**
+ * Post-order visitor hashing every connective bottom up, so finding the
+ * repeated subformulae of a formula is linear in its size. Predicates are
+ * not shared, a reference is rarely smaller than the predicate itself.
+*/
+struct SubformulaHasher{
+    std::unordered_map<const Formula*, std::size_t>& hashes;
+    std::vector<std::size_t> stack = {};
+    std::vector<const Term*> terms = {};
+
+    void onPred(const Formula* formula){
+        std::size_t seed = std::hash<std::string>()(formula->pred->name);
+        terms.assign(formula->pred->args.rbegin(), formula->pred->args.rend());
+        while(!terms.empty()){
+            const Term* term = terms.back();
+            terms.pop_back();
+            hashCombine(seed, std::hash<std::string>()(term->name));
+            hashCombine(seed, term->args.size());
+            terms.insert(terms.end(), term->args.rbegin(), term->args.rend());
+        }
+        stack.push_back(seed);
+    }
+    void onUnary(const Formula* formula){
+        hashCombine(stack.back(), (std::size_t)formula->type);
+        hashes.emplace(formula, stack.back());
+    }
+    void onBinary(const Formula* formula){
+        std::size_t right = stack.back();
+        stack.pop_back();
+        hashCombine(stack.back(), right);
+        hashCombine(stack.back(), (std::size_t)formula->type);
+        hashes.emplace(formula, stack.back());
+    }
+    void onQuant(const Formula* formula){
+        hashCombine(stack.back(), std::hash<std::string>()(formula->quantifier->var));
+        hashCombine(stack.back(), (std::size_t)formula->type);
+        hashes.emplace(formula, stack.back());
+    }
+};
+
+struct BinaryWriter{
+    bool share;
+    std::vector<std::string_view> symbols = {};
+    std::unordered_map<std::string_view, uint32_t> symbolIds = {};
+    BinaryBuffer records = {};
+    std::vector<const Term*> terms = {};
+    std::unordered_map<const Formula*, std::size_t> hashes = {};
+
+    /** @brief A connective written so far, chained with others of equal hash */
+    struct Written{
+        const Formula* formula;
+        uint32_t offset;
+        uint32_t next;
+    };
+    std::vector<Written> written = {};
+    std::unordered_map<std::size_t, uint32_t> writtenByHash = {};   ///< last of each chain
+
+    uint32_t symbol(std::string_view name){
+        auto [itr, inserted] = symbolIds.try_emplace(name, symbols.size());
+        if(inserted){
+            if(symbols.size() == MAX_SYMBOLS){
+                throw std::runtime_error("Binary images are limited to " +
+                                         std::to_string(MAX_SYMBOLS) + " symbols");
+            }
+            symbols.push_back(name);
+        }
+        return itr->second;
+    }
+
+    void tag(RecordKind kind, uint32_t payload = 0){
+        records.push_back((uint32_t)kind | (payload << PAYLOAD_SHIFT));
+    }
+
+    /** @brief Writes a symbol and a small arity as one word */
+    void symbolWithArity(std::string_view name, size_t arity){
+        if(arity < ARITY_ESCAPE){
+            records.push_back(symbol(name) << ARITY_BITS | arity);
+        }else{
+            records.push_back(symbol(name) << ARITY_BITS | ARITY_ESCAPE);
+            records.push_back(arity);
+        }
+    }
+
+    void writePredicate(const Formula::Pred* pred){
+        tag(RecordKind::PRED);
+        symbolWithArity(pred->name, pred->args.size());
+        terms.assign(pred->args.rbegin(), pred->args.rend());
+        while(!terms.empty()){
+            const Term* term = terms.back();
+            terms.pop_back();
+            symbolWithArity(term->name, term->args.size());
+            terms.insert(terms.end(), term->args.rbegin(), term->args.rend());
+        }
+    }
+
+    /** @return true if the formula was written as a reference to an equal record */
+    bool writeReference(const Formula* formula){
+        auto [itr, inserted] = writtenByHash.try_emplace(hashes.at(formula), written.size());
+        uint32_t chain = inserted ? UINT32_MAX : itr->second;
+        for(uint32_t i = chain; i != UINT32_MAX; i = written[i].next){
+            if(*written[i].formula == *formula){
+                records[written[i].offset] |= SHARED_FLAG;
+                tag(RecordKind::REF);
+                records.push_back(written[i].offset);
+                return true;
+            }
+        }
+        itr->second = written.size();
+        written.push_back({formula, (uint32_t)records.size(), chain});
+        return false;
+    }
+
+    void writeFormula(const Formula* formula){
+        if(share){
+            SubformulaHasher hasher{hashes};
+            visitPostOrder(formula, hasher);
+        }
+        std::vector<const Formula*> stack = {formula};
+        while(!stack.empty()){
+            const Formula* f = stack.back();
+            stack.pop_back();
+            if(share && f->connectiveType != Formula::ConnectiveType::PRED && writeReference(f)){
+                continue;
+            }
+            switch(f->connectiveType){
+                case Formula::ConnectiveType::PRED:
+                    writePredicate(f->pred);
+                    break;
+                case Formula::ConnectiveType::UNARY:
+                    tag(RecordKind::NOT);
+                    stack.push_back(f->unary->arg);
+                    break;
+                case Formula::ConnectiveType::BINARY:
+                    tag((RecordKind)f->type);
+                    stack.push_back(f->binary->right);
+                    stack.push_back(f->binary->left);
+                    break;
+                case Formula::ConnectiveType::QUANT:
+                    tag((RecordKind)f->type, symbol(f->quantifier->var));
+                    stack.push_back(f->quantifier->arg);
+                    break;
+            }
+        }
+    }
+
+    BinaryBuffer finish(BinaryHeader::Kind kind, size_t count){
+        BinaryHeader header;
+        header.kind = kind;
+        header.count = count;
+        header.symbols = symbols.size();
+        BinaryBuffer rv(BINARY_HEADER_WORDS);
+        for(std::string_view name : symbols){
+            rv.push_back(name.size());
+            size_t start = rv.size();
+            rv.resize(start + (name.size() + 3) / 4);
+            std::memcpy(rv.data() + start, name.data(), name.size());
+        }
+        header.symbolWords = rv.size() - BINARY_HEADER_WORDS;
+        if(records.size() > UINT32_MAX){
+            throw std::runtime_error("Binary images are limited to 2^32 words of records");
+        }
+        header.recordWords = records.size();
+        rv.insert(rv.end(), records.begin(), records.end());
+        std::memcpy(rv.data(), &header, sizeof(header));
+        return rv;
+    }
+};
+
+BinaryBuffer serialize(const Formula* formula, bool share){
+    BinaryWriter writer{share};
+    writer.writeFormula(formula);
+    return writer.finish(BinaryHeader::Kind::FORMULAE, 1);
+}
+
+BinaryBuffer serialize(const FormulaList& formulae, bool share){
+    BinaryWriter writer{share};
+    for(const Formula* formula : formulae){
+        writer.writeFormula(formula);
+    }
+    return writer.finish(BinaryHeader::Kind::FORMULAE, formulae.size());
+}
+
+BinaryBuffer serialize(const ProofGraph& graph, bool share){
+    std::vector<const ProofNode*> nodes;
+    nodes.reserve(graph.nodes.size());
+    for(const auto& [_, node] : graph.nodes){
+        nodes.push_back(node.get());
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const ProofNode* a, const ProofNode* b){
+        return a->id < b->id;
+    });
+    std::unordered_map<const ProofNode*, uint32_t> indices;
+    for(uint32_t i = 0; i < nodes.size(); i++){
+        indices.emplace(nodes[i], i);
+    }
+    std::unordered_map<Justification, std::string_view> justificationNames;
+    for(const auto& [name, justification] : JUSTIFICATION_STRING_MAP){
+        justificationNames.emplace(justification, name);
+    }
+
+    BinaryWriter writer{share};
+    for(const ProofNode* node : nodes){
+        writer.records.push_back(node->id & UINT32_MAX);
+        writer.records.push_back((uint64_t)node->id >> 32);
+        writer.records.push_back(writer.symbol(justificationNames.at(node->justification)));
+        writer.records.push_back(node->parents.size());
+        for(const ProofNode* parent : node->parents){
+            writer.records.push_back(indices.at(parent));
+        }
+        writer.writeFormula(node->formula.get());
+    }
+    return writer.finish(BinaryHeader::Kind::PROOF_GRAPH, nodes.size());
+}
+
+// Reading =====================================================================
+
+void throwMalformed(const std::string& message){
+    throw std::runtime_error("Malformed binary image: " + message);
+}
+
+struct BinaryReader{
+    const uint32_t* records;
+    size_t size;            ///< words of records
+    size_t position = 0;
+    std::vector<std::string> symbols = {};
+    /// the decoded formulae of records flagged as shared, by offset
+    std::unordered_map<uint32_t, const Formula*> shared = {};
+
+    BinaryReader(std::span<const uint32_t> image, BinaryHeader::Kind kind, uint32_t& count){
+        if(image.size() < BINARY_HEADER_WORDS){
+            throwMalformed("missing header");
+        }
+        BinaryHeader header;
+        std::memcpy(static_cast<void*>(&header), image.data(), sizeof(header));
+        if(header.magic != BINARY_MAGIC){
+            throwMalformed(__builtin_bswap32(header.magic) == BINARY_MAGIC ?
+                           "written with another byte order" : "bad magic number");
+        }
+        if(header.version != BINARY_VERSION){
+            throw std::runtime_error("Binary image version " + std::to_string(header.version) +
+                                     " is not supported, expected " + std::to_string(BINARY_VERSION));
+        }
+        if(header.kind != kind){
+            throw std::runtime_error("Binary image holds another kind of data");
+        }
+        if((uint64_t)BINARY_HEADER_WORDS + header.symbolWords + header.recordWords != image.size()){
+            throwMalformed("section sizes do not match the image size");
+        }
+        count = header.count;
+
+        const uint32_t* words = image.data() + BINARY_HEADER_WORDS;
+        size_t symbolWords = header.symbolWords;
+        symbols.reserve(header.symbols);
+        for(size_t w = 0; symbols.size() < header.symbols;){
+            if(w >= symbolWords || (symbolWords - w - 1) * 4 < words[w]){
+                throwMalformed("symbol table overruns its section");
+            }
+            symbols.emplace_back((const char*)(words + w + 1), words[w]);
+            w += 1 + (words[w] + 3) / 4;
+        }
+        records = words + symbolWords;
+        size = header.recordWords;
+    }
+
+    uint32_t next(){
+        if(position >= size){
+            throwMalformed("records end early");
+        }
+        return records[position++];
+    }
+
+    const std::string& symbol(uint32_t index){
+        if(index >= symbols.size()){
+            throwMalformed("symbol index out of range");
+        }
+        return symbols[index];
+    }
+
+    /** @return the symbol and arity of a word written by symbolWithArity */
+    std::pair<const std::string*, uint32_t> symbolWithArity(){
+        uint32_t word = next();
+        uint32_t arity = word & ARITY_ESCAPE;
+        return {&symbol(word >> ARITY_BITS), arity == ARITY_ESCAPE ? next() : arity};
+    }
+
+    void readTerms(TermList& args, uint32_t arity){
+        std::vector<std::pair<TermList*, uint32_t>> pending = {{&args, arity}};
+        while(!pending.empty()){
+            auto& [list, remaining] = pending.back();
+            if(remaining == 0){
+                pending.pop_back();
+                continue;
+            }
+            remaining--;
+            Term* term = new Term;
+            list->push_back(term);
+            auto [name, termArity] = symbolWithArity();
+            term->name = *name;
+            if(termArity != 0){
+                pending.emplace_back(&term->args, termArity);
+            }
+        }
+    }
+
+    /** @return a newly allocated formula decoded from the next records */
+    Formula* readFormula(){
+        pFormula rv (new Formula);
+        std::vector<Formula*> stack = {rv.get()};
+        //Shared records and the stack depth at which their subtree is decoded
+        std::vector<std::tuple<uint32_t, const Formula*, size_t>> unfinished;
+        while(!stack.empty()){
+            Formula* target = stack.back();
+            stack.pop_back();
+            size_t depth = stack.size();
+            uint32_t offset = position;
+            uint32_t tag = next();
+            uint32_t payload = tag >> PAYLOAD_SHIFT;
+            RecordKind kind = (RecordKind)(tag & KIND_MASK);
+            switch(kind){
+                case RecordKind::PRED:{
+                    target->type = Formula::Type::PRED;
+                    target->connectiveType = Formula::ConnectiveType::PRED;
+                    target->pred = new Formula::Pred;
+                    auto [name, arity] = symbolWithArity();
+                    target->pred->name = *name;
+                    readTerms(target->pred->args, arity);
+                    break;
+                }
+                case RecordKind::NOT:
+                    target->type = Formula::Type::NOT;
+                    target->connectiveType = Formula::ConnectiveType::UNARY;
+                    target->unary = new Formula::UnaryConnective{new Formula};
+                    stack.push_back(target->unary->arg);
+                    break;
+                case RecordKind::AND:
+                case RecordKind::OR:
+                case RecordKind::IF:
+                case RecordKind::IFF:
+                    target->type = (Formula::Type)kind;
+                    target->connectiveType = Formula::ConnectiveType::BINARY;
+                    target->binary = new Formula::BinaryConnective{new Formula, new Formula};
+                    stack.push_back(target->binary->right);
+                    stack.push_back(target->binary->left);
+                    break;
+                case RecordKind::FORALL:
+                case RecordKind::EXISTS:
+                    target->type = (Formula::Type)kind;
+                    target->connectiveType = Formula::ConnectiveType::QUANT;
+                    target->quantifier = new Formula::Quantifier{symbol(payload), new Formula};
+                    stack.push_back(target->quantifier->arg);
+                    break;
+                case RecordKind::REF:{
+                    //Only records whose subtree is fully decoded can be referenced
+                    auto itr = shared.find(next());
+                    if(itr == shared.end()){
+                        throwMalformed("reference to a record that is not shared or not yet decoded");
+                    }
+                    pFormula copy (itr->second->copy());
+                    *target = std::move(*copy);
+                    break;
+                }
+                default:
+                    throwMalformed("unknown record kind " + std::to_string((uint32_t)kind));
+            }
+            if(tag & SHARED_FLAG){
+                unfinished.emplace_back(offset, target, depth);
+            }
+            while(!unfinished.empty() && std::get<2>(unfinished.back()) == stack.size()){
+                shared.emplace(std::get<0>(unfinished.back()), std::get<1>(unfinished.back()));
+                unfinished.pop_back();
+            }
+        }
+        return rv.release();
+    }
+};
+
+FormulaList deserializeAll(std::span<const uint32_t> image){
+    uint32_t count;
+    BinaryReader reader(image, BinaryHeader::Kind::FORMULAE, count);
+    FormulaList rv;
+    try{
+        for(uint32_t i = 0; i < count; i++){
+            rv.push_back(reader.readFormula());
+        }
+    }catch(...){
+        for(Formula* formula : rv){
+            delete formula;
+        }
+        throw;
+    }
+    return rv;
+}
+
+Formula* deserialize(std::span<const uint32_t> image){
+    uint32_t count;
+    BinaryReader reader(image, BinaryHeader::Kind::FORMULAE, count);
+    if(count != 1){
+        throw std::runtime_error("Binary image holds " + std::to_string(count) + " formulae, expected 1");
+    }
+    return reader.readFormula();
+}
+
+ProofGraph* deserializeProofGraph(std::span<const uint32_t> image){
+    uint32_t count;
+    BinaryReader reader(image, BinaryHeader::Kind::PROOF_GRAPH, count);
+    std::unique_ptr<ProofGraph> graph (new ProofGraph);
+    std::vector<ProofNode*> nodes;
+    nodes.reserve(std::min<size_t>(count, reader.size));
+    //Nodes are written in order of id, so a parent may come after its child
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    for(uint32_t i = 0; i < count; i++){
+        pProofNode node (new ProofNode(graph->universe));
+        uint64_t low = reader.next();
+        node->id = low | ((uint64_t)reader.next() << 32);
+        auto justification = JUSTIFICATION_STRING_MAP.find(reader.symbol(reader.next()));
+        if(justification == JUSTIFICATION_STRING_MAP.end()){
+            throwMalformed("unknown justification");
+        }
+        node->justification = justification->second;
+        uint32_t parents = reader.next();
+        for(uint32_t p = 0; p < parents; p++){
+            links.emplace_back(i, reader.next());
+        }
+        node->setFormula(pFormula(reader.readFormula()));
+        nodes.push_back(node.get());
+        if(!graph->nodes.emplace(node->id, std::move(node)).second){
+            throwMalformed("duplicate node id");
+        }
+    }
+    for(auto [child, parent] : links){
+        if(parent >= nodes.size()){
+            throwMalformed("parent index out of range");
+        }
+        nodes[child]->parents.push_back(nodes[parent]);
+        nodes[parent]->children.push_back(nodes[child]);
+    }
+    for(ProofNode* node : nodes){
+        if(node->parents.empty()){
+            graph->assumptions.insert(node);
+        }
+    }
+    return graph.release();
+}
+
+// Files =======================================================================
+
+void writeBinaryFile(const std::string& path, const BinaryBuffer& image){
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)image.data(), image.size() * sizeof(uint32_t));
+    if(!file){
+        throw std::runtime_error("Could not write binary image " + path);
+    }
+}
+
+MappedBinaryFile::MappedBinaryFile(const std::string& path){
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        throw std::runtime_error("Could not open binary image " + path);
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0){
+        close(fd);
+        throw std::runtime_error("Could not read the size of binary image " + path);
+    }
+    this->size = info.st_size;
+    if(this->size % sizeof(uint32_t) != 0){
+        close(fd);
+        throw std::runtime_error("Binary image " + path + " is not a whole number of words");
+    }
+    if(this->size != 0){
+        void* mapping = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED){
+            close(fd);
+            throw std::runtime_error("Could not map binary image " + path);
+        }
+        this->data = mapping;
+    }
+    //The mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedBinaryFile::~MappedBinaryFile(){
+    if(this->data != nullptr){
+        munmap(const_cast<void*>(this->data), this->size);
+    }
+}
+
+std::span<const uint32_t> MappedBinaryFile::words() const{
+    return {(const uint32_t*)this->data, this->size / sizeof(uint32_t)};
+}
@@ -0,0 +1,288 @@
+
+#include<string>
+#include<vector>
+#include<utility>
+#include<algorithm>
+#include<stdexcept>
+
+#include "Congruence.hpp"
+
+constexpr uint64_t SYMBOL_KEY = 1ull << 63;
+constexpr uint32_t MAX_NODES = 1u << 31;
+
+/** @return the key of an application in the interning and signature tables */
+inline uint64_t applyKey(uint32_t left, uint32_t right){
+    return ((uint64_t)left << 32) | right;
+}
+
+// Interning ===================================================================
+
+uint32_t CongruenceClosure::newNode(Node node){
+    if(this->nodes.size() >= MAX_NODES){
+        throw std::runtime_error("Congruence closure node table is full");
+    }
+    uint32_t id = this->nodes.size();
+    this->nodes.push_back(node);
+    this->parents.push_back(id);
+    this->sizes.push_back(1);
+    this->useLists.emplace_back();
+    this->proofParents.push_back(NONE);
+    this->proofReasons.push_back(NONE);
+    this->ancestors.push_back(0);
+    this->explained.push_back(0);
+    return id;
+}
+
+uint32_t CongruenceClosure::internSymbol(const std::string& name, size_t arity){
+    auto [symbol, inserted] = this->symbolIds.try_emplace(name, this->symbols.size());
+    if(inserted){
+        this->symbols.push_back(name);
+    }
+    uint64_t key = SYMBOL_KEY | ((uint64_t)symbol->second << 32) | arity;
+    auto itr = this->nodeIds.find(key);
+    if(itr == this->nodeIds.end()){
+        itr = this->nodeIds.emplace(key, this->newNode({NONE, symbol->second})).first;
+    }
+    return itr->second;
+}
+
+/**
+ * Interns an application. A new application is entered in the signature
+ * table and the use-lists of its operands, or merged with the application
+ * already there if its operands are congruent to those of another.
+*/
+uint32_t CongruenceClosure::internApply(uint32_t left, uint32_t right){
+    auto itr = this->nodeIds.find(applyKey(left, right));
+    if(itr != this->nodeIds.end()){
+        return itr->second;
+    }
+    uint32_t id = this->newNode({left, right});
+    this->nodeIds.emplace(applyKey(left, right), id);
+    uint32_t leftRoot = this->find(left);
+    uint32_t rightRoot = this->find(right);
+    auto [signature, inserted] = this->signatures.try_emplace(applyKey(leftRoot, rightRoot), id);
+    if(inserted){
+        this->useLists[leftRoot].push_back(id);
+        if(rightRoot != leftRoot){
+            this->useLists[rightRoot].push_back(id);
+        }
+    }else{
+        this->merge(id, signature->second, CONGRUENCE);
+    }
+    return id;
+}
+
+/**
+ * Interns a term in post-order with an explicit stack, the ids of the
+ * arguments not yet consumed by their function are kept on a second stack.
+*/
+uint32_t CongruenceClosure::internTerm(const Term* term){
+    std::vector<std::pair<const Term*, bool>> stack = {{term, false}};
+    std::vector<uint32_t> ids;
+    while(!stack.empty()){
+        auto [t, expanded] = stack.back();
+        stack.pop_back();
+        if(!expanded && t->args.size() != 0){
+            stack.emplace_back(t, true);
+            for(auto itr = t->args.rbegin(); itr != t->args.rend(); itr++){
+                stack.emplace_back(*itr, false);
+            }
+            continue;
+        }
+        size_t arity = t->args.size();
+        uint32_t id = this->internSymbol(t->name, arity);
+        for(size_t i = ids.size() - arity; i < ids.size(); i++){
+            id = this->internApply(id, ids[i]);
+        }
+        ids.resize(ids.size() - arity);
+        ids.push_back(id);
+    }
+    return ids.back();
+}
+
+// Merging =====================================================================
+
+uint32_t CongruenceClosure::find(uint32_t id){
+    uint32_t root = id;
+    while(this->parents[root] != root){
+        root = this->parents[root];
+    }
+    while(this->parents[id] != root){
+        uint32_t next = this->parents[id];
+        this->parents[id] = root;
+        id = next;
+    }
+    return root;
+}
+
+void CongruenceClosure::merge(uint32_t left, uint32_t right, uint32_t reason){
+    this->pending.push_back({left, right, reason});
+    this->propagate();
+}
+
+/**
+ * Makes a node the root of its proof tree by reversing the edges on its
+ * path to the root.
+*/
+void CongruenceClosure::reroot(uint32_t id){
+    uint32_t parent = NONE;
+    uint32_t reason = NONE;
+    while(id != NONE){
+        uint32_t next = this->proofParents[id];
+        uint32_t nextReason = this->proofReasons[id];
+        this->proofParents[id] = parent;
+        this->proofReasons[id] = reason;
+        parent = id;
+        reason = nextReason;
+        id = next;
+    }
+}
+
+/**
+ * Applies pending merges until none are left. The smaller class is merged
+ * into the larger one, and the applications over it are re-entered in the
+ * signature table under their new operand representatives, queueing a
+ * merge whenever one collides with a congruent application.
+*/
+void CongruenceClosure::propagate(){
+    while(!this->pending.empty()){
+        auto [left, right, reason] = this->pending.back();
+        this->pending.pop_back();
+        uint32_t leftRoot = this->find(left);
+        uint32_t rightRoot = this->find(right);
+        if(leftRoot == rightRoot){
+            continue;
+        }
+        if(reason == CONGRUENCE){
+            this->congruences++;
+        }
+        if(this->sizes[leftRoot] > this->sizes[rightRoot]){
+            std::swap(left, right);
+            std::swap(leftRoot, rightRoot);
+        }
+        //Only the proof tree of the smaller class is rerooted
+        this->reroot(left);
+        this->proofParents[left] = right;
+        this->proofReasons[left] = reason;
+
+        this->parents[leftRoot] = rightRoot;
+        this->sizes[rightRoot] += this->sizes[leftRoot];
+        std::vector<uint32_t> uses = std::move(this->useLists[leftRoot]);
+        this->useLists[leftRoot] = {};
+        for(uint32_t use : uses){
+            const Node& node = this->nodes[use];
+            uint64_t key = applyKey(this->find(node.left), this->find(node.right));
+            auto [signature, inserted] = this->signatures.try_emplace(key, use);
+            if(inserted){
+                this->useLists[rightRoot].push_back(use);
+            }else if(this->find(signature->second) != this->find(use)){
+                this->pending.push_back({use, signature->second, CONGRUENCE});
+            }
+        }
+    }
+}
+
+// Interface ===================================================================
+
+/** @return the two terms of an equality predicate */
+std::pair<const Term*, const Term*> equationTerms(const Formula* equation){
+    if(equation->type != Formula::Type::PRED || equation->pred->name != EQUALITY_PREDICATE ||
+       equation->pred->args.size() != 2){
+        throw std::runtime_error("Expected an equality predicate over two terms");
+    }
+    return {equation->pred->args.front(), equation->pred->args.back()};
+}
+
+size_t CongruenceClosure::addEquation(const Term* left, const Term* right){
+    uint32_t leftId = this->internTerm(left);
+    uint32_t rightId = this->internTerm(right);
+    this->merge(leftId, rightId, this->equations);
+    return this->equations++;
+}
+
+size_t CongruenceClosure::addEquation(const Formula* equation){
+    auto [left, right] = equationTerms(equation);
+    return this->addEquation(left, right);
+}
+
+bool CongruenceClosure::equal(const Term* left, const Term* right){
+    uint32_t leftId = this->internTerm(left);
+    uint32_t rightId = this->internTerm(right);
+    return this->find(leftId) == this->find(rightId);
+}
+
+bool CongruenceClosure::entails(const Formula* equation){
+    auto [left, right] = equationTerms(equation);
+    return this->equal(left, right);
+}
+
+/**
+ * @return a fresh stamp for a vector of marks, the marks are cleared when the
+ * stamps wrap around
+*/
+uint32_t nextStamp(uint32_t& stamp, std::vector<uint32_t>& marks){
+    if(++stamp == 0){
+        std::fill(marks.begin(), marks.end(), 0);
+        stamp = 1;
+    }
+    return stamp;
+}
+
+/**
+ * Explains pairs of equal nodes with a worklist. The proof forest path
+ * between two nodes runs through their nearest common ancestor, equation
+ * edges on it are collected and congruence edges add the pairs of operands
+ * of the two applications they join. Every edge is explained once.
+*/
+std::vector<size_t> CongruenceClosure::explain(const Term* left, const Term* right){
+    uint32_t leftId = this->internTerm(left);
+    uint32_t rightId = this->internTerm(right);
+    if(this->find(leftId) != this->find(rightId)){
+        throw std::runtime_error("Trying to explain terms that are not equal");
+    }
+    std::vector<size_t> rv;
+    uint32_t explanation = nextStamp(this->explanations, this->explained);
+    std::vector<std::pair<uint32_t, uint32_t>> work = {{leftId, rightId}};
+    while(!work.empty()){
+        auto [a, b] = work.back();
+        work.pop_back();
+        if(a == b){
+            continue;
+        }
+        uint32_t pair = nextStamp(this->pairs, this->ancestors);
+        for(uint32_t id = a; id != NONE; id = this->proofParents[id]){
+            this->ancestors[id] = pair;
+        }
+        uint32_t ancestor = b;
+        while(this->ancestors[ancestor] != pair){
+            ancestor = this->proofParents[ancestor];
+        }
+        for(uint32_t id : {a, b}){
+            for(; id != ancestor; id = this->proofParents[id]){
+                if(this->explained[id] == explanation){
+                    continue;
+                }
+                this->explained[id] = explanation;
+                uint32_t reason = this->proofReasons[id];
+                if(reason != CONGRUENCE){
+                    rv.push_back(reason);
+                    continue;
+                }
+                const Node& from = this->nodes[id];
+                const Node& to = this->nodes[this->proofParents[id]];
+                work.emplace_back(from.left, to.left);
+                work.emplace_back(from.right, to.right);
+            }
+        }
+    }
+    std::sort(rv.begin(), rv.end());
+    return rv;
+}
+
+bool entailsEquality(const FormulaList& equations, const Formula* query){
+    CongruenceClosure closure;
+    for(const Formula* equation : equations){
+        closure.addEquation(equation);
+    }
+    return closure.entails(query);
+}
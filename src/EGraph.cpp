@@ -0,0 +1,449 @@
+
+#include<string>
+#include<vector>
+#include<utility>
+#include<algorithm>
+#include<stdexcept>
+
+#include "EGraph.hpp"
+
+size_t EGraph::ENodeHash::operator()(const ENode& node) const{
+    uint64_t rv = node.symbol * 0x9E3779B97F4A7C15ull;
+    for(uint32_t arg : node.args){
+        rv = (rv ^ arg) * 0xBF58476D1CE4E5B9ull;
+        rv ^= rv >> 31;
+    }
+    return rv;
+}
+
+// Union-find and Invariants ===================================================
+
+uint32_t EGraph::find(uint32_t id){
+    uint32_t root = id;
+    while(this->parents[root] != root){
+        root = this->parents[root];
+    }
+    while(this->parents[id] != root){
+        uint32_t next = this->parents[id];
+        this->parents[id] = root;
+        id = next;
+    }
+    return root;
+}
+
+void EGraph::canonicalize(ENode& node){
+    for(uint32_t& arg : node.args){
+        arg = this->find(arg);
+    }
+}
+
+uint32_t EGraph::internSymbol(const std::string& name){
+    auto [itr, inserted] = this->symbolIds.try_emplace(name, this->symbols.size());
+    if(inserted){
+        this->symbols.push_back(name);
+    }
+    return itr->second;
+}
+
+/** Adds an e-node to a new e-class unless an equal e-node is already known */
+uint32_t EGraph::addNode(ENode node){
+    this->canonicalize(node);
+    auto itr = this->memo.find(node);
+    if(itr != this->memo.end()){
+        return this->find(itr->second);
+    }
+    if(this->classes.size() >= NONE){
+        throw std::runtime_error("E-graph class table is full");
+    }
+    uint32_t id = this->classes.size();
+    this->parents.push_back(id);
+    this->classes.emplace_back();
+    for(size_t i = 0; i < node.args.size(); i++){
+        uint32_t arg = node.args[i];
+        //A repeated argument is only used once
+        if(std::find(node.args.begin(), node.args.begin() + i, arg) == node.args.begin() + i){
+            this->classes[arg].parents.emplace_back(node, id);
+        }
+    }
+    this->classes[id].nodes.push_back(node);
+    this->memo.emplace(std::move(node), id);
+    this->classCount++;
+    this->enodes++;
+    return id;
+}
+
+/**
+ * Adds a term in post-order with an explicit stack, the e-classes of the
+ * arguments not yet consumed by their function are kept on a second stack.
+*/
+uint32_t EGraph::add(const Term* term){
+    std::vector<std::pair<const Term*, bool>> stack = {{term, false}};
+    std::vector<uint32_t> ids;
+    while(!stack.empty()){
+        auto [t, expanded] = stack.back();
+        stack.pop_back();
+        if(!expanded && t->args.size() != 0){
+            stack.emplace_back(t, true);
+            for(auto itr = t->args.rbegin(); itr != t->args.rend(); itr++){
+                stack.emplace_back(*itr, false);
+            }
+            continue;
+        }
+        ENode node{this->internSymbol(t->name), {}};
+        node.args.assign(ids.end() - t->args.size(), ids.end());
+        ids.resize(ids.size() - t->args.size());
+        ids.push_back(this->addNode(std::move(node)));
+    }
+    return ids.back();
+}
+
+/**
+ * The e-class with fewer e-nodes and uses is merged into the other, its
+ * uses are repaired on the next rebuild.
+*/
+uint32_t EGraph::merge(uint32_t left, uint32_t right){
+    left = this->find(left);
+    right = this->find(right);
+    if(left == right){
+        return left;
+    }
+    EClass* into = &this->classes[left];
+    EClass* from = &this->classes[right];
+    if(into->nodes.size() + into->parents.size() < from->nodes.size() + from->parents.size()){
+        std::swap(left, right);
+        std::swap(into, from);
+    }
+    this->parents[right] = left;
+    into->nodes.insert(into->nodes.end(), std::make_move_iterator(from->nodes.begin()),
+                       std::make_move_iterator(from->nodes.end()));
+    into->parents.insert(into->parents.end(), std::make_move_iterator(from->parents.begin()),
+                         std::make_move_iterator(from->parents.end()));
+    *from = {};
+    this->pending.push_back(left);
+    this->classCount--;
+    this->unions++;
+    return left;
+}
+
+/**
+ * Re-enters the uses of an e-class in the memo under their canonical form,
+ * merging the e-classes of uses that have become congruent. The e-classes
+ * holding the uses are noted in dirty, their e-nodes are canonicalized once
+ * all repairs are done.
+*/
+void EGraph::repair(uint32_t id, std::vector<uint32_t>& dirty){
+    std::vector<std::pair<ENode, uint32_t>> uses = std::move(this->classes[id].parents);
+    this->classes[id].parents.clear();
+    for(auto& [node, user] : uses){
+        this->memo.erase(node);
+    }
+    for(auto& [node, user] : uses){
+        this->canonicalize(node);
+        user = this->find(user);
+        auto [itr, inserted] = this->memo.try_emplace(node, user);
+        if(!inserted){
+            user = this->merge(itr->second, user);
+            itr->second = user;
+        }
+        dirty.push_back(user);
+    }
+    std::sort(uses.begin(), uses.end());
+    size_t kept = 0;
+    for(size_t i = 0; i < uses.size(); i++){
+        if(kept != 0 && uses[kept - 1].first == uses[i].first){
+            this->merge(uses[kept - 1].second, uses[i].second);
+            continue;
+        }
+        if(kept != i){
+            uses[kept] = std::move(uses[i]);
+        }
+        kept++;
+    }
+    uses.resize(kept);
+    std::vector<std::pair<ENode, uint32_t>>& target = this->classes[this->find(id)].parents;
+    target.insert(target.end(), std::make_move_iterator(uses.begin()), std::make_move_iterator(uses.end()));
+    this->rebuilds++;
+}
+
+void EGraph::rebuild(){
+    std::vector<uint32_t> dirty;
+    while(!this->pending.empty()){
+        std::vector<uint32_t> todo = std::move(this->pending);
+        this->pending.clear();
+        for(uint32_t& id : todo){
+            id = this->find(id);
+        }
+        std::sort(todo.begin(), todo.end());
+        todo.erase(std::unique(todo.begin(), todo.end()), todo.end());
+        for(uint32_t id : todo){
+            dirty.push_back(id);
+            this->repair(id, dirty);
+        }
+    }
+    for(uint32_t& id : dirty){
+        id = this->find(id);
+    }
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    for(uint32_t id : dirty){
+        std::vector<ENode>& nodes = this->classes[id].nodes;
+        for(ENode& node : nodes){
+            this->canonicalize(node);
+        }
+        std::sort(nodes.begin(), nodes.end());
+        size_t size = nodes.size();
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        this->enodes -= size - nodes.size();
+    }
+}
+
+size_t EGraph::nodeCount() const{
+    return this->enodes;
+}
+
+// Rules =======================================================================
+
+/**
+ * Compiles a pattern into nodes in post-order, constants starting with `?`
+ * are variables and are numbered in order of first appearance.
+*/
+std::vector<EGraph::PatternNode> EGraph::compilePattern(const std::string& pattern,
+                                                        std::unordered_map<std::string, uint32_t>& variables){
+    pTerm term (termFromSExpressionString(pattern));
+    std::vector<PatternNode> rv;
+    std::vector<std::pair<const Term*, bool>> stack = {{term.get(), false}};
+    std::vector<uint32_t> ids;
+    while(!stack.empty()){
+        auto [t, expanded] = stack.back();
+        stack.pop_back();
+        if(!expanded && t->args.size() != 0){
+            stack.emplace_back(t, true);
+            for(auto itr = t->args.rbegin(); itr != t->args.rend(); itr++){
+                stack.emplace_back(*itr, false);
+            }
+            continue;
+        }
+        if(t->args.size() == 0 && t->name.size() > 1 && t->name[0] == '?'){
+            auto [variable, _] = variables.try_emplace(t->name, variables.size());
+            rv.push_back({variable->second, true, {}});
+        }else{
+            rv.push_back({this->internSymbol(t->name), false, {}});
+            rv.back().children.assign(ids.end() - t->args.size(), ids.end());
+            ids.resize(ids.size() - t->args.size());
+        }
+        ids.push_back(rv.size() - 1);
+    }
+    return rv;
+}
+
+void EGraph::addRule(const RewriteRuleSpec& spec){
+    std::unordered_map<std::string, uint32_t> variables;
+    Rule rule{spec.name, this->compilePattern(spec.pattern, variables), {}, 0};
+    if(rule.pattern.back().variable){
+        throw std::runtime_error("Rule " + spec.name + " has a pattern variable as its pattern");
+    }
+    rule.variables = variables.size();
+    rule.replacement = this->compilePattern(spec.replacement, variables);
+    if(variables.size() != rule.variables){
+        throw std::runtime_error("Rule " + spec.name + " uses an unbound pattern variable");
+    }
+    this->rules.push_back(std::move(rule));
+}
+
+void EGraph::addRules(const std::vector<RewriteRuleSpec>& rules){
+    for(const RewriteRuleSpec& rule : rules){
+        this->addRule(rule);
+    }
+}
+
+/**
+ * Finds every way a pattern matches an e-class. Each search state holds
+ * the variable bindings and the pattern nodes left to match against
+ * e-classes, a pattern node with several matching e-nodes forks the state.
+ * The e-graph must be rebuilt.
+*/
+void EGraph::search(const std::vector<PatternNode>& pattern, size_t variables, uint32_t id,
+                    std::vector<Match>& matches) const{
+    struct State{
+        std::vector<uint32_t> bindings;
+        std::vector<std::pair<uint32_t, uint32_t>> goals;
+    };
+    std::vector<State> states;
+    states.push_back({std::vector<uint32_t>(variables, NONE), {{pattern.size() - 1, id}}});
+    while(!states.empty()){
+        State state = std::move(states.back());
+        states.pop_back();
+        if(state.goals.empty()){
+            matches.push_back({id, std::move(state.bindings)});
+            continue;
+        }
+        auto [p, c] = state.goals.back();
+        state.goals.pop_back();
+        const PatternNode& pNode = pattern[p];
+        if(pNode.variable){
+            uint32_t& binding = state.bindings[pNode.symbol];
+            if(binding == NONE || binding == c){
+                binding = c;
+                states.push_back(std::move(state));
+            }
+            continue;
+        }
+        //E-nodes are sorted, so those with the pattern's symbol are adjacent
+        const std::vector<ENode>& nodes = this->classes[c].nodes;
+        auto itr = std::lower_bound(nodes.begin(), nodes.end(), pNode.symbol,
+                                    [](const ENode& node, uint32_t symbol){ return node.symbol < symbol; });
+        for(; itr != nodes.end() && itr->symbol == pNode.symbol; itr++){
+            if(itr->args.size() != pNode.children.size()){
+                continue;
+            }
+            State fork = state;
+            for(size_t i = 0; i < pNode.children.size(); i++){
+                fork.goals.emplace_back(pNode.children[i], itr->args[i]);
+            }
+            states.push_back(std::move(fork));
+        }
+    }
+}
+
+uint32_t EGraph::instantiate(const std::vector<PatternNode>& replacement, const std::vector<uint32_t>& bindings){
+    std::vector<uint32_t> ids(replacement.size());
+    for(size_t i = 0; i < replacement.size(); i++){
+        const PatternNode& pNode = replacement[i];
+        if(pNode.variable){
+            ids[i] = bindings[pNode.symbol];
+            continue;
+        }
+        ENode node{pNode.symbol, std::vector<uint32_t>(pNode.children.size())};
+        for(size_t j = 0; j < pNode.children.size(); j++){
+            node.args[j] = ids[pNode.children[j]];
+        }
+        ids[i] = this->addNode(std::move(node));
+    }
+    return ids.back();
+}
+
+/**
+ * Each iteration searches every rule against the rebuilt e-graph, then
+ * applies all the matches and rebuilds once, so the invariants are
+ * restored once per iteration rather than once per union.
+*/
+SaturationStop EGraph::saturate(const SaturationLimits& limits){
+    auto deadline = std::chrono::steady_clock::now() + limits.time;
+    this->rebuild();
+    std::vector<std::vector<uint32_t>> classesBySymbol;
+    std::vector<std::vector<Match>> matches(this->rules.size());
+    for(size_t iteration = 0;; iteration++){
+        if(iteration == limits.iterations){
+            return SaturationStop::ITERATION_LIMIT;
+        }
+        if(this->nodeCount() >= limits.nodes){
+            return SaturationStop::NODE_LIMIT;
+        }
+        this->iterations++;
+
+        classesBySymbol.assign(this->symbols.size(), {});
+        for(uint32_t id = 0; id < this->classes.size(); id++){
+            if(this->parents[id] != id){
+                continue;
+            }
+            for(const ENode& node : this->classes[id].nodes){
+                std::vector<uint32_t>& bucket = classesBySymbol[node.symbol];
+                if(bucket.empty() || bucket.back() != id){
+                    bucket.push_back(id);
+                }
+            }
+        }
+        for(size_t r = 0; r < this->rules.size(); r++){
+            const Rule& rule = this->rules[r];
+            matches[r].clear();
+            for(uint32_t id : classesBySymbol[rule.pattern.back().symbol]){
+                this->search(rule.pattern, rule.variables, id, matches[r]);
+            }
+            if(std::chrono::steady_clock::now() > deadline){
+                return SaturationStop::TIME_LIMIT;
+            }
+        }
+
+        size_t nodes = this->nodeCount();
+        size_t unions = this->unions;
+        for(size_t r = 0; r < this->rules.size(); r++){
+            for(const Match& match : matches[r]){
+                this->merge(match.id, this->instantiate(this->rules[r].replacement, match.bindings));
+                if(this->nodeCount() >= limits.nodes){
+                    this->rebuild();
+                    return SaturationStop::NODE_LIMIT;
+                }
+            }
+        }
+        this->rebuild();
+        if(this->nodeCount() == nodes && this->unions == unions){
+            return SaturationStop::SATURATED;
+        }
+        if(std::chrono::steady_clock::now() > deadline){
+            return SaturationStop::TIME_LIMIT;
+        }
+    }
+}
+
+// Extraction ==================================================================
+
+/**
+ * The cost of every e-class is relaxed over its e-nodes until no cost
+ * improves. Costs are at least 1, so the chosen e-nodes form a DAG and the
+ * term is built top down with an explicit stack.
+*/
+Term* EGraph::extract(uint32_t id, const std::unordered_map<std::string, uint64_t>& costs){
+    this->rebuild();
+    std::vector<uint64_t> symbolCosts(this->symbols.size(), 1);
+    for(const auto& [name, cost] : costs){
+        auto itr = this->symbolIds.find(name);
+        if(itr != this->symbolIds.end()){
+            symbolCosts[itr->second] = std::max<uint64_t>(cost, 1);
+        }
+    }
+    std::vector<uint64_t> best(this->classes.size(), UINT64_MAX);
+    std::vector<const ENode*> choices(this->classes.size(), nullptr);
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(uint32_t c = 0; c < this->classes.size(); c++){
+            if(this->parents[c] != c){
+                continue;
+            }
+            for(const ENode& node : this->classes[c].nodes){
+                uint64_t cost = symbolCosts[node.symbol];
+                for(uint32_t arg : node.args){
+                    cost = best[arg] >= UINT64_MAX - cost ? UINT64_MAX : cost + best[arg];
+                }
+                if(cost < best[c]){
+                    best[c] = cost;
+                    choices[c] = &node;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    pTerm rv (new Term);
+    std::vector<std::pair<uint32_t, Term*>> stack = {{this->find(id), rv.get()}};
+    while(!stack.empty()){
+        auto [c, target] = stack.back();
+        stack.pop_back();
+        const ENode* node = choices[c];
+        target->name = this->symbols[node->symbol];
+        for(uint32_t arg : node->args){
+            target->args.push_back(new Term);
+            stack.emplace_back(arg, target->args.back());
+        }
+    }
+    return rv.release();
+}
+
+Term* smallestEquivalent(const Term* term, const std::vector<RewriteRuleSpec>& rules,
+                         const SaturationLimits& limits){
+    EGraph graph;
+    uint32_t id = graph.add(term);
+    graph.addRules(rules);
+    graph.saturate(limits);
+    return graph.extract(id);
+}
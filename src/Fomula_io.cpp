@@ -1,11 +1,13 @@
 #include<string>
 #include<list>
+#include<vector>
+#include<utility>
 #include<unordered_map>
-#include<unordered_set>
 #include<stdexcept>
 
 #include "SExpression.hpp"
 #include "Formula.hpp"
+#include "FormulaVisitor.hpp"
 #include "settings.hpp"
 
 //Construction Helpers =========================================================
@@ -99,25 +101,43 @@ Formula* Exists(std::string varName, Formula* arg){
     return rv;
 }
 
+/**
+ * @return the name of a list S-Expression's operator, throwing if the
+ * list is empty or begins with another list.
+*/
+const std::string& listOperator(const sExpression& expr, const char* kind){
+    if(expr.members.size() == 0 || 
+       expr.members[0].type == sExpression::Type::List){
+        throw std::runtime_error(std::string("Malformed ") + kind + 
+                                 " SExpression: " + expr.toString());
+    }
+    return expr.members[0].value;
+}
+
 Term* termFromSExpression(const sExpression& expr){
     if(expr.type != sExpression::Type::List){
         return Const(expr.value);
-    }else{
-        sExpression firstMember = expr.members[0];
-        if(firstMember.type == sExpression::Type::List){
-            throw std::runtime_error("Malformed Term SExpression: " 
-                                     + expr.toString());
+    }
+    pTerm rv (new Term);
+    //Stack of S-Expressions and the terms they are converted into
+    std::vector<std::pair<const sExpression*, Term*>> stack = {{&expr, rv.get()}};
+    while(!stack.empty()){
+        auto [subExpr, target] = stack.back();
+        stack.pop_back();
+        if(subExpr->type != sExpression::Type::List){
+            target->name = subExpr->value;
+            continue;
         }
-        std::string name = firstMember.value;
-        TermList args;
-        //Recursively convert all subterms.
-        std::vector<sExpression>::const_iterator itr = expr.members.cbegin();
+        target->name = listOperator(*subExpr, "Term");
+        //Convert all subterms into slots owned by target
+        std::vector<sExpression>::const_iterator itr = subExpr->members.cbegin();
         itr++;
-        for(;itr != expr.members.end(); itr++){
-            args.push_back(termFromSExpression(*itr));
+        for(;itr != subExpr->members.end(); itr++){
+            target->args.push_back(new Term);
+            stack.emplace_back(&*itr, target->args.back());
         }
-        return Func(name, args);
     }
+    return rv.release();
 }
 
 const std::unordered_map<Formula::Type, size_t> TYPE_ARGS_MAP = {     
@@ -130,252 +150,192 @@ const std::unordered_map<Formula::Type, size_t> TYPE_ARGS_MAP = {
     {Formula::Type::EXISTS, 2},        
 };
 
+/**
+ * @param expr a list S-Expression
+ * @param type set to the connective of the list if it is one
+ * @return true iff expr is a list whose operator is a connective used with
+ * the right number of arguments, otherwise the list is a predicate.
+*/
+bool isConnectiveExpression(const sExpression& expr, Formula::Type& type){
+    auto itr = STRING_TYPE_MAP.find(listOperator(expr, "Formula"));
+    if(itr == STRING_TYPE_MAP.end() ||
+       TYPE_ARGS_MAP.at(itr->second) != expr.members.size() - 1){
+        return false;
+    }
+    type = itr->second;
+    return true;
+}
+
 Formula* fromSExpression(const sExpression& expr){
-    if(expr.type != sExpression::Type::List){
-        return Prop(expr.value);
-    }else{
-        sExpression firstMember = expr.members[0];
-        if(firstMember.type == sExpression::Type::List){
-            throw std::runtime_error("Malformed Formula SExpression: " 
-                                     + expr.toString());
+    //Post-order traversal, connectives are built once their subformulae have
+    //been converted and pushed onto the results stack.
+    std::vector<std::pair<const sExpression*, bool>> stack = {{&expr, false}};
+    std::vector<pFormula> results;
+    stack.reserve(16);
+    results.reserve(16);
+    while(!stack.empty()){
+        auto [subExpr, expanded] = stack.back();
+        stack.pop_back();
+        if(subExpr->type != sExpression::Type::List){
+            results.emplace_back(Prop(subExpr->value));
+            continue;
         }
-        std::string name = firstMember.value; 
-        //If the connective name is a valid connective and uses the right
-        //number of arguments, it is a proper connective, otherwise
-        //it is treated as a predicate.
-        if(
-            STRING_TYPE_MAP.find(name) != STRING_TYPE_MAP.end() &&
-            TYPE_ARGS_MAP.at(STRING_TYPE_MAP.at(name)) == expr.members.size() - 1
-        ){
-            switch(STRING_TYPE_MAP.at(name)){
-                case Formula::Type::AND:
-                    return And(fromSExpression(expr.members[1]), fromSExpression(expr.members[2]));
-                case Formula::Type::OR:
-                    return Or(fromSExpression(expr.members[1]), fromSExpression(expr.members[2]));
-                case Formula::Type::IF:
-                    return If(fromSExpression(expr.members[1]), fromSExpression(expr.members[2]));
-                case Formula::Type::IFF:
-                    return Iff(fromSExpression(expr.members[1]), fromSExpression(expr.members[2]));
-                case Formula::Type::NOT:
-                    return Not(fromSExpression(expr.members[1]));
-                case Formula::Type::FORALL:{
-                    if(expr.members[1].type == sExpression::Type::List){
-                        throw std::runtime_error("Lists of vars are unsupported");
-                    }
-                    return Forall(expr.members[1].value, fromSExpression(expr.members[2]));
-                }
-                case Formula::Type::EXISTS:{
-                    if(expr.members[1].type == sExpression::Type::List){
-                        throw std::runtime_error("Lists of vars are unsupported");
-                    }
-                    return Exists(expr.members[1].value, fromSExpression(expr.members[2]));
-                }
-                default:
-                    throw std::runtime_error("Unsupported Connective");
-            }
-        }else{
-            //Recursively convert everything else as a subterm
+        Formula::Type type;
+        if(!isConnectiveExpression(*subExpr, type)){
+            //Convert everything else as a predicate over subterms
             TermList args;
-            std::vector<sExpression>::const_iterator itr = expr.members.cbegin();
+            std::vector<sExpression>::const_iterator itr = subExpr->members.cbegin();
             itr++;
-            for(;itr != expr.members.end(); itr++){
+            for(;itr != subExpr->members.end(); itr++){
                 args.push_back(termFromSExpression(*itr));
             }
-            return Pred(name, args);
+            results.emplace_back(Pred(subExpr->members[0].value, std::move(args)));
+            continue;
         }
+        bool quantifier = type == Formula::Type::FORALL || type == Formula::Type::EXISTS;
+        if(!expanded){
+            if(quantifier && subExpr->members[1].type == sExpression::Type::List){
+                throw std::runtime_error("Lists of vars are unsupported");
+            }
+            stack.emplace_back(subExpr, true);
+            //Subformulae are pushed in reverse so they are converted left to right
+            for(size_t i = subExpr->members.size() - 1; i >= (quantifier ? 2 : 1); i--){
+                stack.emplace_back(&subExpr->members[i], false);
+            }
+            continue;
+        }
+        Formula* rv;
+        switch(type){
+            case Formula::Type::NOT:
+                rv = Not(results.back().release());
+                results.pop_back();
+                break;
+            case Formula::Type::FORALL:
+                rv = Forall(subExpr->members[1].value, results.back().release());
+                results.pop_back();
+                break;
+            case Formula::Type::EXISTS:
+                rv = Exists(subExpr->members[1].value, results.back().release());
+                results.pop_back();
+                break;
+            default:{
+                Formula* right = results.back().release();
+                results.pop_back();
+                Formula* left = results.back().release();
+                results.pop_back();
+                switch(type){
+                    case Formula::Type::AND: rv = And(left, right); break;
+                    case Formula::Type::OR: rv = Or(left, right); break;
+                    case Formula::Type::IF: rv = If(left, right); break;
+                    case Formula::Type::IFF: rv = Iff(left, right); break;
+                    default:
+                        delete left;
+                        delete right;
+                        throw std::runtime_error("Unsupported Connective");
+                }
+            }
+        }
+        results.emplace_back(rv);
     }
-    throw std::runtime_error("Impossible");
+    return results.back().release();
 }
 
 Formula* fromSExpressionString(std::string sExpressionString){
-    sExpression expr(sExpressionString);
+    sExpression expr(std::move(sExpressionString));
     return fromSExpression(expr);
 }
 
-// SExpression Converters ======================================================
-
-std::string toSExpression(Term* term){
-    if(term->args.size() == 0){
-        return term->name;
-    }else{
-        std::string rv = "(" + term->name + " ";
-        for(Term* arg : term->args){
-            rv += toSExpression(arg) + " ";
-        }
-        rv.pop_back();
-        rv += ")";
-        return rv;
-    }
+Term* termFromSExpressionString(std::string sExpressionString){
+    sExpression expr(std::move(sExpressionString));
+    return termFromSExpression(expr);
 }
 
-std::string toSExpression(const Formula* formula){
-    switch(formula->type)
-    {
-        case Formula::Type::PRED:{
-            std::string rv;
-            formula->pred->applyToAsTerm([&rv](Term* t){
-                rv = toSExpression(t);
-            });
-            return rv;
-        }
-        case Formula::Type::FORALL:
-        case Formula::Type::EXISTS:{
-            std::string name = TYPE_STRING_MAP.at(formula->type);
-            return "(" + name + " " + formula->quantifier->var +
-                   " " + toSExpression(formula->quantifier->arg) + ")";
-        }
-        default:{
-            //If the formula is a valid type, use its type string as its operator, else use "???"
-            auto itr = TYPE_STRING_MAP.find(formula->type);
-            std::string typeString = itr != TYPE_STRING_MAP.end() ? itr->second : "???";
-            std::string rv = "(" + typeString + " ";
-            for(Formula* arg : formula->subformulae()){
-                rv += toSExpression(arg) + " ";
-            }
-            rv.pop_back();
-            rv += ")";
-            return rv;
-        }
-    }
-}
-
-// TPTP ========================================================================
-
-using BoundTermSet = std::unordered_set<Term*>;
+// SExpression Converters ======================================================
 
 /**
- *  Converts an arbitrary eminence prover identifier to an TPTP identifier
- *  All TPTP identifiers start with a letter followed by any length of letters
- *  and numbers Functions and Predicates are use lowercase letters 
- *  Quantified variables are forced to use upper case letters
- *  @param epIdentifier the identifier string provided by eminence prover
- *  @param upper if the identifier should be upper cased, I.E. is a 
- *  @return a legal TPTP Identifier 
+ * Appends the S-Expression of a term like structure (a term or a predicate)
+ * to rv followed by a trailing space. Uses an explicit stack where a null
+ * entry closes the innermost open list.
 */
-std::string makeLegalTPTPIdentifier(const std::string& epIdentifier,
-                                    bool upper){
-    std::string rv = "";
-    //Ensure first char is a letter; if not, append an S on front
-    if (epIdentifier.size() == 0 || !std::isalpha(epIdentifier[0])){
-        rv = (upper ? "S" : "s") + rv; 
+void appendTermSExpression(const std::string& name, const TermList& args,
+                           std::string& rv){
+    if(args.size() == 0){
+        rv += name;
+        rv += ' ';
+        return;
+    }
+    rv += '(';
+    rv += name;
+    rv += ' ';
+    std::vector<const Term*> stack = {nullptr};
+    for(auto itr = args.rbegin(); itr != args.rend(); itr++){
+        stack.push_back(*itr);
     }
-    for(char c : epIdentifier){ //append all legal chars
-        if(std::isalnum(c)){ 
-            rv += (char)(upper ? std::toupper(c) : std::tolower(c));
+    while(!stack.empty()){
+        const Term* term = stack.back();
+        stack.pop_back();
+        if(term == nullptr){
+            //Replace the space after the last arg with the closing parenthesis
+            rv.back() = ')';
+            rv += ' ';
+        }else if(term->args.size() == 0){
+            rv += term->name;
+            rv += ' ';
+        }else{
+            rv += '(';
+            rv += term->name;
+            rv += ' ';
+            stack.push_back(nullptr);
+            for(auto itr = term->args.rbegin(); itr != term->args.rend(); itr++){
+                stack.push_back(*itr);
+            }
         }
     }
+}
+
+std::string toSExpression(const Term* term){
+    std::string rv;
+    appendTermSExpression(term->name, term->args, rv);
+    rv.pop_back();
     return rv;
 }
 
 /**
- * Makes all identifiers an constants in the given formula a "legal" for
- * conversion to a TPTP formula
- * 1) Converts bound variables to legal uppercase idents 
- * 2) Converts functions to be valid TPTP identifiers
- * 3) Converts predicates to be valid TPTP identifiers 
- * 4) Converts term constants to have quotation marks around them in name
- * 
- * @param formula
- * @return a version of the formula which will generate 
- * 
- * @todo Potential optimizations, 
- * 1) create a map of identifiers that have already been converted to TPTP
- *    idents so we don't waste time reconverting
- * 2) check if an identifier is a legal TPTP identifier before converting
+ * Visitor printing a formula as an S-Expression with a trailing space,
+ * closing each connective's list once its subformulae have been printed.
 */
-Formula* makeLegalTPTP(const Formula* formula){
-    
-    Formula* rv = formula->copy();
-    
-    //Get the set of all bound constants
-    BoundTermSet boundTerms;
-    for(auto [term, quantifierFormula] : rv->boundTermVariables()){
-        boundTerms.insert(term);
-    }
+struct SExpressionPrinter{
+    std::string& rv;
 
-    //Put quotes around unbound constants and make bound constants legal uppercase idents
-    for(Term* constant : rv->allConstants()){
-        if(boundTerms.find(constant) == boundTerms.end()){
-            constant->name = "\"" + constant->name + "\"";
-        }else{
-            constant->name = makeLegalTPTPIdentifier(constant->name, true);
-        }
+    void onPred(const Formula* f){
+        appendTermSExpression(f->pred->name, f->pred->args, rv);
     }
-
-    //Convert functions and predicates to lowercase idents
-    for(Term* function : rv->allFunctions()){
-        function->name = makeLegalTPTPIdentifier(function->name, false);
+    void open(const Formula* f){
+        //If the formula is a valid type, use its type string as its operator, else use "???"
+        auto itr = TYPE_STRING_MAP.find(f->type);
+        rv += '(';
+        rv += itr != TYPE_STRING_MAP.end() ? itr->second : "???";
+        rv += ' ';
     }
-    for(Formula* p : rv->allPredicates()){
-        p->pred->name = makeLegalTPTPIdentifier(p->pred->name, false);
+    void close(const Formula*){
+        rv.back() = ')';
+        rv += ' ';
     }
-
-    //Convert all quantifier variables to 
-    //Note we can't iter over boundTermVariables as it is possible we have quantifiers that don't bind to any anything
-    for(Formula* f : rv->allQuantified()){
-        f->quantifier->var = makeLegalTPTPIdentifier(f->quantifier->var, true);
+    void onUnary(const Formula* f){ open(f); }
+    void onBinary(const Formula* f){ open(f); }
+    void onQuant(const Formula* f){
+        open(f);
+        rv += f->quantifier->var;
+        rv += ' ';
     }
-
-    return rv;
-}
-
-const std::unordered_map<Formula::Type, std::string> TPTPStringMap = {      
-    {Formula::Type::NOT, "~"},          
-    {Formula::Type::AND, "&"},           
-    {Formula::Type::OR, "|"},            
-    {Formula::Type::IF, "=>"},            
-    {Formula::Type::IFF, "<=>"},           
-    {Formula::Type::FORALL, "!"},        
-    {Formula::Type::EXISTS, "?"},        
+    void leaveUnary(const Formula* f){ close(f); }
+    void leaveBinary(const Formula* f){ close(f); }
+    void leaveQuant(const Formula* f){ close(f); }
 };
 
-std::string recursiveToTPTP(Term* term){
-    if(term->args.size() == 0){
-        return term->name;
-    }else{
-        std::string rv = term->name + "(";
-        for(Term* arg : term->args){
-            rv += recursiveToTPTP(arg) + ", ";
-        }
-        rv.pop_back();
-        rv.pop_back();
-        rv += ")";
-        return rv;
-    }
-}
-
-std::string recursiveToTPTP(Formula* formula){
-    switch(formula->type){
-        case Formula::Type::PRED:{
-            std::string rv;
-            formula->pred->applyToAsTerm([&rv](Term* t){
-                rv = recursiveToTPTP(t);
-            });
-            return rv;
-        }
-        case Formula::Type::NOT:
-            return TPTPStringMap.at(formula->type) + recursiveToTPTP(formula->unary->arg);
-        case Formula::Type::AND:
-        case Formula::Type::OR:
-        case Formula::Type::IF:
-        case Formula::Type::IFF:
-            return "(" + recursiveToTPTP(formula->binary->left) + TPTPStringMap.at(formula->type) +
-                   recursiveToTPTP(formula->binary->right) + ")";
-        case Formula::Type::FORALL:
-        case Formula::Type::EXISTS:
-            return "(" + TPTPStringMap.at(formula->type) + " [" + formula->quantifier->var + "] : " +
-                   recursiveToTPTP(formula->quantifier->arg) + ")"; 
-    }
-    throw std::runtime_error("invalid ");
+std::string toSExpression(const Formula* formula){
+    std::string rv;
+    visit(formula, SExpressionPrinter{rv});
+    rv.pop_back();
+    return rv;
 }
-
-
-std::string toFirstOrderTPTP(std::string name, std::string type, Formula* formula){
-    if(!formula->isFirstOrder()){
-        throw std::runtime_error("Trying to convert a non-first order formula to first order TPTP");
-    }
-    Formula* cleanFormula = makeLegalTPTP(formula);
-    std::string tptpFormulaString = "fof(" + name + "," + type + "," + recursiveToTPTP(cleanFormula) + ").";
-    delete cleanFormula;
-    return tptpFormulaString;
-}
\ No newline at end of file
@@ -2,84 +2,160 @@
 #include<queue>
 #include<stack>
 #include<list>
+#include<vector>
+#include<utility>
 #include<algorithm>
 #include<stdexcept>
+#include<string_view>
+#include<type_traits>
+#include<unordered_map>
 
 #include "Formula.hpp"
+#include "FormulaVisitor.hpp"
 
-
-Formula::~Formula(){
-    switch(this->connectiveType){
-        case ConnectiveType::PRED:
-            for(Term* arg : this->pred->args){
+/**
+ * Frees the connective struct of a formula and moves ownership of its
+ * subformulae onto a stack, leaving the formula empty.
+*/
+inline void releaseSubformulae(Formula* formula, std::vector<Formula*>& stack){
+    //Moved from subformulae own nothing
+    if(formula->pred == nullptr){
+        return;
+    }
+    switch(formula->connectiveType){
+        case Formula::ConnectiveType::PRED:
+            //Term destructors are stack safe themselves
+            for(Term* arg : formula->pred->args){
                 delete arg;
             }
-            delete this->pred;
+            delete formula->pred;
             break;
-        case ConnectiveType::UNARY:
-            delete this->unary->arg;
-            delete this->unary;
+        case Formula::ConnectiveType::UNARY:
+            stack.push_back(formula->unary->arg);
+            delete formula->unary;
             break;
-        case ConnectiveType::BINARY:
-            delete this->binary->left;
-            delete this->binary->right;
-            delete this->binary;
+        case Formula::ConnectiveType::BINARY:
+            stack.push_back(formula->binary->left);
+            stack.push_back(formula->binary->right);
+            delete formula->binary;
             break;
-        case ConnectiveType::QUANT:
-            delete this->quantifier->arg;
-            delete this->quantifier;
+        case Formula::ConnectiveType::QUANT:
+            stack.push_back(formula->quantifier->arg);
+            delete formula->quantifier;
             break;
     }
+    formula->pred = nullptr;
+}
+
+
+Formula::Formula(Formula&& other) noexcept
+:type(other.type), connectiveType(other.connectiveType), pred(other.pred){
+    //All union members are pointers, clearing one clears the active member
+    other.pred = nullptr;
+}
+
+Formula& Formula::operator=(Formula&& other) noexcept{
+    if(this != &other){
+        //old takes our current subformulae and frees them when it leaves scope
+        Formula old(std::move(*this));
+        this->type = other.type;
+        this->connectiveType = other.connectiveType;
+        this->pred = other.pred;
+        other.pred = nullptr;
+    }
+    return *this;
+}
+
+Formula::~Formula(){
+    //Empty and moved from formulae own nothing
+    if(this->pred == nullptr){
+        return;
+    }
+    //Subformulae are detached before being deleted so each destructor call
+    //returns immediately instead of recursing
+    std::vector<Formula*> stack;
+    stack.reserve(16);
+    releaseSubformulae(this, stack);
+    while(!stack.empty()){
+        Formula* subformula = stack.back();
+        stack.pop_back();
+        releaseSubformulae(subformula, stack);
+        delete subformula;
+    }
 }
 
 Formula* Formula::copy() const{
     Formula* rv = new Formula;
-    rv->type = this->type;
-    rv->connectiveType = this->connectiveType;
-    switch(this->connectiveType){
-        case ConnectiveType::PRED:
-            rv->pred = new Pred;
-            rv->pred->name = this->pred->name;
-            rv->pred->args = TermList();
-            for(Term * arg : this->pred->args){
-                rv->pred->args.push_back(arg->copy());
-            }
-            return rv;
-        case ConnectiveType::UNARY:
-            rv->unary = new UnaryConnective;
-            rv->unary->arg = this->unary->arg->copy();
-            return rv;
-        case ConnectiveType::BINARY:
-            rv->binary = new BinaryConnective;
-            rv->binary->left = this->binary->left->copy(); 
-            rv->binary->right = this->binary->right->copy();
-            return rv;
-        case ConnectiveType::QUANT:
-            rv->quantifier = new Quantifier;
-            rv->quantifier->var = this->quantifier->var;
-            rv->quantifier->arg = this->quantifier->arg->copy();
-            return rv;
+    //Stack of source formulae and the slots their copies are written to
+    std::vector<std::pair<const Formula*, Formula*>> stack = {{this, rv}};
+    stack.reserve(16);
+    while(!stack.empty()){
+        auto [source, target] = stack.back();
+        stack.pop_back();
+        target->type = source->type;
+        target->connectiveType = source->connectiveType;
+        switch(source->connectiveType){
+            case ConnectiveType::PRED:
+                target->pred = new Pred;
+                target->pred->name = source->pred->name;
+                for(Term * arg : source->pred->args){
+                    target->pred->args.push_back(arg->copy());
+                }
+                break;
+            case ConnectiveType::UNARY:
+                target->unary = new UnaryConnective;
+                target->unary->arg = new Formula;
+                stack.emplace_back(source->unary->arg, target->unary->arg);
+                break;
+            case ConnectiveType::BINARY:
+                target->binary = new BinaryConnective;
+                target->binary->left = new Formula;
+                target->binary->right = new Formula;
+                stack.emplace_back(source->binary->left, target->binary->left);
+                stack.emplace_back(source->binary->right, target->binary->right);
+                break;
+            case ConnectiveType::QUANT:
+                target->quantifier = new Quantifier;
+                target->quantifier->var = source->quantifier->var;
+                target->quantifier->arg = new Formula;
+                stack.emplace_back(source->quantifier->arg, target->quantifier->arg);
+                break;
+        }
     }
-    throw std::runtime_error("Invalid connective type");
+    return rv;
 }
 
 bool Formula::operator==(const Formula& other) const{
-    if(this->type != other.type){
-        return false;
-    }
-    if(this->type == Type::PRED){
-        return *this->pred == *other.pred;
-    }else{
-        FormulaList thisSubformulae = this->subformulae();
-        FormulaList::const_iterator itr1 = thisSubformulae.begin();
-        FormulaList::const_iterator itr2 = other.subformulae().begin();
-        for(; itr1 == thisSubformulae.end(); itr1++, itr2++){
-            if(!(**itr1 == **itr2)){
-                return false;
-            }
+    std::vector<std::pair<const Formula*, const Formula*>> stack = {{this, &other}};
+    stack.reserve(16);
+    while(!stack.empty()){
+        auto [a, b] = stack.back();
+        stack.pop_back();
+        if(a->type != b->type){
+            return false;
+        }
+        switch(a->connectiveType){
+            case ConnectiveType::PRED:
+                if(!(*a->pred == *b->pred)){
+                    return false;
+                }
+                break;
+            case ConnectiveType::UNARY:
+                stack.emplace_back(a->unary->arg, b->unary->arg);
+                break;
+            case ConnectiveType::BINARY:
+                stack.emplace_back(a->binary->right, b->binary->right);
+                stack.emplace_back(a->binary->left, b->binary->left);
+                break;
+            case ConnectiveType::QUANT:
+                if(a->quantifier->var != b->quantifier->var){
+                    return false;
+                }
+                stack.emplace_back(a->quantifier->arg, b->quantifier->arg);
+                break;
         }
-        return true;
     }
+    return true;
 }
 
 FormulaList Formula::subformulae() const{
@@ -118,26 +194,37 @@ FormulaList Formula::allFormulae() const{
 
 
 /**
- * Recursively traverses a formula tree in-order and returns the depth
+ * Visitor tracking the depth of the current node and the deepest leaf seen
+*/
+struct DepthVisitor{
+    bool withTerms; ///< if true, will count the depth of term trees else treats predicates as leaves.
+    size_t depth = 0;
+    size_t max = 0;
+
+    void onPred(const Formula* formula){
+        size_t leafDepth = depth + (!withTerms ? 1 : formula->pred->depth());
+        if(leafDepth > max){
+            max = leafDepth;
+        }
+    }
+    void onUnary(const Formula*){ depth++; }
+    void onBinary(const Formula*){ depth++; }
+    void onQuant(const Formula*){ depth++; }
+    void leaveUnary(const Formula*){ depth--; }
+    void leaveBinary(const Formula*){ depth--; }
+    void leaveQuant(const Formula*){ depth--; }
+};
+
+/**
+ * Traverses a formula tree and returns the depth
  * @param base the tree to traverse and get the depth of
  * @param withTerms if true, will count the depth of term trees else treats predicates as leaves.
  * @return the depth of the tree
 */
 size_t depthTraversal(const Formula* base, bool withTerms){
-    switch(base->type){
-        case Formula::Type::PRED:
-            return !withTerms ? 1 : base->pred->depth();
-        default:{
-            size_t max = 0;
-            for(Formula* arg : base->subformulae()){
-                size_t argDepth = depthTraversal(arg, withTerms);
-                if(argDepth > max){
-                    max = argDepth;
-                }
-            }
-            return 1 + max;
-        }
-    } 
+    DepthVisitor visitor{withTerms};
+    visit(base, visitor);
+    return visitor.max;
 }
 
 size_t Formula::depth() const{
@@ -149,32 +236,27 @@ size_t Formula::depthWithTerms() const{
 }
 
 /**
- * Recursively performs an in-order traversal of the formula tree to get a vector of all predicates
- * in the order in which they appear in the formula.
- * @param base the formula to start the in order traversal at
- * @param predicates the list of predicates being built up in the order they appear within base.
+ * Visitor collecting all predicates in the order in which they appear in the
+ * formula, predicates are the leaves so a pre-order traversal visits them in order.
 */
-void inOrderPredicateTraversal(Formula* base, FormulaList& predicates){
-    switch(base->connectiveType){
-        case Formula::ConnectiveType::PRED:
-            predicates.push_back(base);
-            break;
-        default:
-            for(Formula* f : base->subformulae())
-                inOrderPredicateTraversal(f, predicates);
+struct PredicateVisitor{
+    FormulaList& predicates;
+
+    void onPred(Formula* formula){
+        predicates.push_back(formula);
     }
-}
+};
 
 FormulaList Formula::allPredicates() const{
     FormulaList predicates;
-    inOrderPredicateTraversal((Formula*)this, predicates);
+    visit((Formula*)this, PredicateVisitor{predicates});
     return predicates;
 }
 
 FormulaList Formula::allPropositions() const{
     FormulaList predicates = this->allPredicates();
     //filter for out predicates with args
-    std::remove_if(predicates.begin(), predicates.end(), [](Formula* p){return !p->isProposition();});
+    predicates.remove_if([](Formula* p){return !p->isProposition();});
     return predicates;
 }
 
@@ -213,164 +295,308 @@ bool Formula::isProposition() const{
     return this->type == Type::PRED && this->pred->args.size() == 0;
 }
 
+/** @brief The kinds of identifier occurrences a quantifier can bind */
+enum class BoundItem{
+    TERM,       ///< term constants and variables
+    FUNCTION,   ///< function symbols
+    PREDICATE   ///< predicate symbols
+};
+
 /**
- * Recursive in-order traversal function for finding a list of items (Predicates, Constants, or Functions)
- * of that are bound by quantifiers.
- * @tparam ItemType the type of item that the quantifier formula will be associated with, Term* in the case
- * of quantifying over terms and functions and Formula* in the case of quantifying over Predicates
- * @param base The formula to start checking from
- * @param quantifierStack An iterable stack of quantifier formulae
- * @param boundObjVars the vector or Term* Formula* pairs the result is written to.
- * @param baseCase a function mapping Predicates to a list of items with names to check if they are bound
- * @param itemName a function mapping an item to its name to check against the quantifier's bound name
+ * Single pass binder resolution. A scoped symbol table maps each bound
+ * variable name to the stack of quantifiers binding it, so each occurrence
+ * costs one lookup and is annotated with its innermost binder.
+ * @tparam Item the kind of occurrence to resolve
 */
-template<typename ItemType>
-void inOrderQuantifierTraversal(Formula* base, 
-                                std::list<Formula*>& quantifierStack,
-                                std::list<std::pair<ItemType, Formula*>>& boundObjVars,
-                                std::list<ItemType> (*baseCase)(Formula*),
-                                std::string (*itemName)(ItemType)){
-    switch(base->connectiveType){
-        //Base Case 1: the formula is a Predicate check if we associate with anything and leave
-        case Formula::ConnectiveType::PRED:
-            for(ItemType arg : baseCase(base)){
-                for(Formula* quantifierFormula : quantifierStack){
-                    if(quantifierFormula->quantifier->var == itemName(arg)){
-                        boundObjVars.push_back(std::make_pair(arg, quantifierFormula));
+template<BoundItem Item>
+struct BinderResolver{
+    using ItemType = std::conditional_t<Item == BoundItem::PREDICATE, Formula*, Term*>;
+
+    std::list<std::pair<ItemType, Formula*>>& boundObjVars; ///< the result list
+    std::unordered_map<std::string_view, std::vector<Formula*>> scopes = {};
+    size_t openScopes = 0;
+    std::vector<Term*> terms = {};
+
+    /** @return the innermost quantifier binding name or nullptr if it is free */
+    Formula* binder(const std::string& name) const{
+        auto itr = scopes.find(name);
+        if(itr == scopes.end() || itr->second.empty()){
+            return nullptr;
+        }
+        return itr->second.back();
+    }
+
+    void resolve(ItemType item, const std::string& name){
+        if(Formula* quantifierFormula = binder(name)){
+            boundObjVars.emplace_back(item, quantifierFormula);
+        }
+    }
+
+    void onQuant(Formula* formula){
+        //Names are views into the quantifiers which outlive their scope
+        scopes[formula->quantifier->var].push_back(formula);
+        openScopes++;
+    }
+
+    void leaveQuant(Formula* formula){
+        scopes.find(formula->quantifier->var)->second.pop_back();
+        openScopes--;
+    }
+
+    void onPred(Formula* formula){
+        //Nothing can be bound outside of every quantifier
+        if(openScopes == 0){
+            return;
+        }
+        if constexpr(Item == BoundItem::PREDICATE){
+            resolve(formula, formula->pred->name);
+        }else{
+            //Pre-order over the argument terms, the order allConstants() and allFunctions() use
+            const TermList& args = formula->pred->args;
+            terms.assign(args.rbegin(), args.rend());
+            while(!terms.empty()){
+                Term* term = terms.back();
+                terms.pop_back();
+                if(term->args.size() == 0){
+                    if constexpr(Item == BoundItem::TERM){
+                        resolve(term, term->name);
                     }
+                }else{
+                    if constexpr(Item == BoundItem::FUNCTION){
+                        resolve(term, term->name);
+                    }
+                    terms.insert(terms.end(), term->args.rbegin(), term->args.rend());
                 }
             }
-            break;
-        //Recursive case 1: The formula is a quantifier, push onto the quantifier stack to update binding order
-        //and traverse the subformula
-        case Formula::ConnectiveType::QUANT:
-            //Push the current quantifier onto the list of bound vars we're looking for
-            quantifierStack.push_front(base);
-            inOrderQuantifierTraversal(base->quantifier->arg, quantifierStack, boundObjVars, baseCase, itemName);
-            //Pop the quantifier since we've traversed all its inner vars
-            quantifierStack.pop_front();
-            break;
-        //Recursive case 2: For any other formula type recurse on all subformulae
-        default:
-            for(Formula* subformula : base->subformulae()){
-                inOrderQuantifierTraversal(subformula, quantifierStack, boundObjVars, baseCase, itemName);
-            }
+        }
     }
+};
+
+/**
+ * Collects the occurrences of a kind bound by quantifiers in the order they
+ * appear, each paired with the quantifier that binds it.
+*/
+template<BoundItem Item>
+std::list<std::pair<typename BinderResolver<Item>::ItemType, Formula*>> boundItems(Formula* base){
+    std::list<std::pair<typename BinderResolver<Item>::ItemType, Formula*>> rv;
+    visit(base, BinderResolver<Item>{rv});
+    return rv;
 }
 
 std::list<std::pair<Term*, Formula*>> Formula::boundTermVariables() const{
-    std::list<std::pair<Term*, Formula*>> rv;
-    std::list<Formula*> quantifierStack;
-    auto getConstants = [](Formula* f){return f->pred->allConstants();};
-    auto getTermName = [](Term* o){return o->name;};
-    inOrderQuantifierTraversal<Term*>((Formula*)this, quantifierStack, rv, getConstants, getTermName);
-    return rv;
+    return boundItems<BoundItem::TERM>((Formula*)this);
 }
 
 std::list<std::pair<Term*, Formula*>> Formula::boundFunctionVariables() const{
-    std::list<std::pair<Term*, Formula*>> rv;
-    std::list<Formula*> quantifierStack;
-    auto getFunctions = [](Formula* f){return f->pred->allFunctions();};
-    auto getTermName = [](Term* o){return o->name;};
-    inOrderQuantifierTraversal<Term*>((Formula*)this, quantifierStack, rv, getFunctions, getTermName);
-    return rv;
+    return boundItems<BoundItem::FUNCTION>((Formula*)this);
 }
 
 std::list<std::pair<Formula*, Formula*>> Formula::boundPredicateVariables() const{
-    std::list<std::pair<Formula*, Formula*>> rv;
-    std::list<Formula*> quantifierStack;
-    auto getPredicates = [](Formula* p){return std::list<Formula*>{p};};
-    auto getPredicateName = [](Formula* p){return p->pred->name;};
-    inOrderQuantifierTraversal<Formula*>((Formula*)this, quantifierStack, rv, getPredicates, getPredicateName);
-    return rv;
+    return boundItems<BoundItem::PREDICATE>((Formula*)this);
 }
 
-std::unordered_set<std::string> Formula::identifiers() const{
-    switch (this->connectiveType){
-        case ConnectiveType::PRED:{
-            std::unordered_set<std::string> rv;
-            this->pred->applyToAsTerm([&rv](Term* t){rv = t->identifiers();});
-            return rv;
-        }
-        default:{
-            std::unordered_set<std::string> rv;
-            for(Formula* subformula : this->subformulae()){
-                rv.merge(subformula->identifiers());
-            }
-            return rv;
+/**
+ * Visitor collecting the names of predicates, terms and bound variables
+*/
+struct IdentifierVisitor{
+    std::unordered_set<std::string>& identifiers;
+
+    void onPred(const Formula* formula){
+        identifiers.insert(formula->pred->name);
+        for(Term* arg : formula->pred->args){
+            identifiers.merge(arg->identifiers());
         }
     }
-}
+    void onQuant(const Formula* formula){
+        identifiers.insert(formula->quantifier->var);
+    }
+};
 
-// Formula Class testers -----------------------------------------------------------------------------------------------
+std::unordered_set<std::string> Formula::identifiers() const{
+    std::unordered_set<std::string> rv;
+    visit(this, IdentifierVisitor{rv});
+    return rv;
+}
 
 /**
- * @brief tests if a formula only contains the given connectives
- * @param connectives the set of connectives to check if the formula contains
- * @param formula the formula to test
- * @return true iff formula contains only propositional connectives
+ * Visitor collecting the names of predicates and terms outside the scope of
+ * quantifiers binding them, open binders are counted per name
 */
-bool onlyConnectives(std::unordered_set<Formula::Type> connectives, const Formula * formula){
-    for(Formula* subformula : formula->allFormulae()){
-        if(subformula->type != Formula::Type::PRED && 
-           connectives.find(subformula->type) == connectives.end()){
-            return false;
+struct FreeIdentifierVisitor{
+    std::unordered_set<std::string>& identifiers;
+    std::unordered_map<std::string_view, unsigned> bound = {};
+    std::vector<const Term*> terms = {};
+
+    void add(const std::string& name){
+        if(!bound.contains(std::string_view(name))){
+            identifiers.insert(name);
         }
     }
-    return true;
+    void onPred(const Formula* formula){
+        add(formula->pred->name);
+        terms.assign(formula->pred->args.begin(), formula->pred->args.end());
+        while(!terms.empty()){
+            const Term* term = terms.back();
+            terms.pop_back();
+            add(term->name);
+            terms.insert(terms.end(), term->args.begin(), term->args.end());
+        }
+    }
+    void onQuant(const Formula* formula){
+        bound[formula->quantifier->var]++;
+    }
+    void leaveQuant(const Formula* formula){
+        auto itr = bound.find(formula->quantifier->var);
+        if(--itr->second == 0){
+            bound.erase(itr);
+        }
+    }
+};
+
+std::unordered_set<std::string> Formula::freeIdentifiers() const{
+    std::unordered_set<std::string> rv;
+    visit(this, FreeIdentifierVisitor{rv});
+    return rv;
 }
 
-const std::unordered_set<Formula::Type> PropositionalConnectives = 
-{Formula::Type::NOT, Formula::Type::AND, Formula::Type::OR, Formula::Type::IF, Formula::Type::IFF};
+// Formula Class testers -----------------------------------------------------------------------------------------------
 
-const std::unordered_set<Formula::Type> BaseConnectives = 
-{Formula::Type::NOT, Formula::Type::AND, Formula::Type::OR,
- Formula::Type::IF, Formula::Type::IFF, Formula::Type::EXISTS, Formula::Type::FORALL};
+/** @return the bitmask bit of a formula type */
+constexpr unsigned typeBit(Formula::Type type){
+    return 1u << static_cast<unsigned>(type);
+}
 
-bool Formula::isPropositional() const{
-    
-    //Make sure we only use propositional connectives
-    if(!onlyConnectives(PropositionalConnectives, this)){
-        return false;
-    }
-    
-    //Make sure all predicates are propositions
-    for(Formula * predicate : this->allPredicates()){
-        if(!predicate->isProposition()){
-            return false;
-        }
+constexpr unsigned PropositionalConnectives = 
+    typeBit(Formula::Type::NOT) | typeBit(Formula::Type::AND) | typeBit(Formula::Type::OR) |
+    typeBit(Formula::Type::IF) | typeBit(Formula::Type::IFF);
+
+constexpr unsigned BaseConnectives = 
+    PropositionalConnectives | typeBit(Formula::Type::EXISTS) | typeBit(Formula::Type::FORALL);
+
+/**
+ * Visitor gathering everything the logic order testers need in one pass:
+ * the connectives used as a bitmask, whether every predicate is a 
+ * proposition, and whether any quantifier binds a predicate or function.
+ * Open binders are counted per name, bound names are looked up only for
+ * predicate and function symbols.
+*/
+struct ClassifyVisitor{
+    unsigned connectives = 0;
+    bool onlyPropositions = true;
+    bool bindsHigherOrder = false;
+    std::unordered_map<std::string_view, size_t> scopes = {};
+    size_t openScopes = 0;
+    std::vector<const Term*> terms = {};
+
+    bool isBound(const std::string& name) const{
+        auto itr = scopes.find(name);
+        return itr != scopes.end() && itr->second > 0;
     }
 
-    return true;
+    void onPred(const Formula* formula){
+        const TermList& args = formula->pred->args;
+        onlyPropositions = onlyPropositions && args.size() == 0;
+        //Nothing can be bound outside of every quantifier
+        if(openScopes == 0 || bindsHigherOrder){
+            return;
+        }
+        if(isBound(formula->pred->name)){
+            bindsHigherOrder = true;
+            return;
+        }
+        terms.assign(args.begin(), args.end());
+        while(!terms.empty()){
+            const Term* term = terms.back();
+            terms.pop_back();
+            if(term->args.size() > 0){
+                if(isBound(term->name)){
+                    bindsHigherOrder = true;
+                    return;
+                }
+                terms.insert(terms.end(), term->args.begin(), term->args.end());
+            }
+        }
+    }
+    void onUnary(const Formula* formula){ connectives |= typeBit(formula->type); }
+    void onBinary(const Formula* formula){ connectives |= typeBit(formula->type); }
+    void onQuant(const Formula* formula){
+        connectives |= typeBit(formula->type);
+        scopes[formula->quantifier->var]++;
+        openScopes++;
+    }
+    void leaveQuant(const Formula* formula){
+        scopes.find(formula->quantifier->var)->second--;
+        openScopes--;
+    }
+};
+
+Formula::Classification Formula::classify() const{
+    ClassifyVisitor visitor;
+    visit(this, visitor);
+    bool zerothOrderConnectives = (visitor.connectives & ~PropositionalConnectives) == 0;
+    bool baseConnectives = (visitor.connectives & ~BaseConnectives) == 0;
+    Classification rv;
+    rv.propositional = zerothOrderConnectives && visitor.onlyPropositions;
+    rv.zerothOrder = zerothOrderConnectives;
+    //We may not quantify over predicates or functions in first order logic
+    rv.firstOrder = baseConnectives && !visitor.bindsHigherOrder;
+    rv.secondOrder = baseConnectives;
+    return rv;
 }
 
+bool Formula::isPropositional() const{
+    return this->classify().propositional;
+}
 
 bool Formula::isZerothOrder() const{
-    return onlyConnectives(PropositionalConnectives, this);
+    return this->classify().zerothOrder;
 }
 
 bool Formula::isFirstOrder() const{
-    //Make sure we only use base connectives (Prop + quantifiers)
-    if(!onlyConnectives(BaseConnectives, this)){
-        return false;
-    }
-
-    //Make sure we don't quantify over predicates or formulae
-    if(this->boundPredicateVariables().size() > 0 || this->boundFunctionVariables().size() > 0){
-        return false;
-    }
+    return this->classify().firstOrder;
+}
 
-    return true;
+bool Formula::isSecondOrder() const{
+    return this->classify().secondOrder;
 }
 
+// Hashing -------------------------------------------------------------------------------------------------------------
 
-bool Formula::isSecondOrder() const{
-    //Make sure we only use base connectives (Prop + quantifiers)
-    if(!onlyConnectives(BaseConnectives, this)){
-        return false;
+/**
+ * Visitor folding the pre-order sequence of (type, identifier, arity) over
+ * the formula and its terms into a hash. The pre-order sequence together
+ * with the arities determines the tree, so distinct formulae only collide by chance.
+*/
+struct HashVisitor{
+    std::size_t seed = 0;
+    std::vector<const Term*> terms = {};
+
+    void node(const Formula* formula){
+        hashCombine(seed, static_cast<std::size_t>(formula->type));
+    }
+    void onPred(const Formula* formula){
+        node(formula);
+        hashCombine(seed, std::hash<std::string>()(formula->pred->name));
+        hashCombine(seed, formula->pred->args.size());
+        terms.assign(formula->pred->args.rbegin(), formula->pred->args.rend());
+        while(!terms.empty()){
+            const Term* term = terms.back();
+            terms.pop_back();
+            hashCombine(seed, std::hash<std::string>()(term->name));
+            hashCombine(seed, term->args.size());
+            terms.insert(terms.end(), term->args.rbegin(), term->args.rend());
+        }
     }
+    void onUnary(const Formula* formula){ node(formula); }
+    void onBinary(const Formula* formula){ node(formula); }
+    void onQuant(const Formula* formula){
+        node(formula);
+        hashCombine(seed, std::hash<std::string>()(formula->quantifier->var));
+    }
+};
 
-    return true;
+std::size_t std::hash<Formula>::operator()(const Formula& formula) const{
+    HashVisitor visitor;
+    visit(&formula, visitor);
+    return visitor.seed;
 }
-
-
@@ -1,15 +1,6 @@
 
 #include "Formula.hpp"
 
-void Formula::Pred::applyToAsTerm(std::function<void(Term*)> termContext) const{
-    Term* dummy = new Term;
-    dummy->name = this->name;
-    dummy->args = this->args;
-    termContext(dummy);
-    //Don't call the destructor on dummy, just delete the pointer
-    operator delete(dummy); 
-}
-
 bool Formula::Pred::operator==(const Pred& other) const{
     if(this->name != other.name || this->args.size() != other.args.size())
         return false;
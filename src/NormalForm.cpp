@@ -0,0 +1,464 @@
+
+#include<string>
+#include<vector>
+#include<utility>
+#include<iterator>
+#include<algorithm>
+#include<cstdlib>
+#include<stdexcept>
+#include<unordered_set>
+#include<unordered_map>
+
+#include "NormalForm.hpp"
+#include "FormulaVisitor.hpp"
+
+// Construction Helpers ========================================================
+// Fill an empty formula in place, new subformulae are empty and wait to be filled
+
+void makePredicate(Formula* target, const Formula* source){
+    target->type = Formula::Type::PRED;
+    target->connectiveType = Formula::ConnectiveType::PRED;
+    target->pred = new Formula::Pred;
+    target->pred->name = source->pred->name;
+    for(Term* arg : source->pred->args){
+        target->pred->args.push_back(arg->copy());
+    }
+}
+
+void makeNot(Formula* target){
+    target->type = Formula::Type::NOT;
+    target->connectiveType = Formula::ConnectiveType::UNARY;
+    target->unary = new Formula::UnaryConnective{new Formula};
+}
+
+void makeBinary(Formula* target, Formula::Type type){
+    target->type = type;
+    target->connectiveType = Formula::ConnectiveType::BINARY;
+    target->binary = new Formula::BinaryConnective{new Formula, new Formula};
+}
+
+void makeQuantifier(Formula* target, Formula::Type type, const std::string& var){
+    target->type = type;
+    target->connectiveType = Formula::ConnectiveType::QUANT;
+    target->quantifier = new Formula::Quantifier{var, new Formula};
+}
+
+// NNF =========================================================================
+
+Formula* toNNF(const Formula* formula){
+    Formula* rv = new Formula;
+    //Stack of source formulae, whether they are under a negation, and the
+    //empty formula their normal form is written to
+    struct Task{
+        const Formula* source;
+        bool negated;
+        Formula* target;
+    };
+    std::vector<Task> stack = {{formula, false, rv}};
+    stack.reserve(16);
+    while(!stack.empty()){
+        auto [source, negated, target] = stack.back();
+        stack.pop_back();
+        switch(source->type){
+            case Formula::Type::PRED:
+                if(negated){
+                    makeNot(target);
+                    target = target->unary->arg;
+                }
+                makePredicate(target, source);
+                break;
+            case Formula::Type::NOT:
+                stack.push_back({source->unary->arg, !negated, target});
+                break;
+            case Formula::Type::AND:
+            case Formula::Type::OR:{
+                //De Morgan's laws
+                bool isAnd = (source->type == Formula::Type::AND) != negated;
+                makeBinary(target, isAnd ? Formula::Type::AND : Formula::Type::OR);
+                stack.push_back({source->binary->right, negated, target->binary->right});
+                stack.push_back({source->binary->left, negated, target->binary->left});
+                break;
+            }
+            case Formula::Type::IF:
+                //a -> b is ~a \/ b, ~(a -> b) is a /\ ~b
+                makeBinary(target, negated ? Formula::Type::AND : Formula::Type::OR);
+                stack.push_back({source->binary->right, negated, target->binary->right});
+                stack.push_back({source->binary->left, !negated, target->binary->left});
+                break;
+            case Formula::Type::IFF:{
+                //a <-> b is (~a \/ b) /\ (a \/ ~b), ~(a <-> b) is (a /\ ~b) \/ (~a /\ b)
+                Formula::Type outer = negated ? Formula::Type::OR : Formula::Type::AND;
+                Formula::Type inner = negated ? Formula::Type::AND : Formula::Type::OR;
+                makeBinary(target, outer);
+                Formula* left = target->binary->left;
+                Formula* right = target->binary->right;
+                makeBinary(left, inner);
+                makeBinary(right, inner);
+                stack.push_back({source->binary->right, !negated, right->binary->right});
+                stack.push_back({source->binary->left, negated, right->binary->left});
+                stack.push_back({source->binary->right, negated, left->binary->right});
+                stack.push_back({source->binary->left, !negated, left->binary->left});
+                break;
+            }
+            case Formula::Type::FORALL:
+            case Formula::Type::EXISTS:{
+                bool isForall = (source->type == Formula::Type::FORALL) != negated;
+                makeQuantifier(target, isForall ? Formula::Type::FORALL : Formula::Type::EXISTS,
+                               source->quantifier->var);
+                stack.push_back({source->quantifier->arg, negated, target->quantifier->arg});
+                break;
+            }
+        }
+    }
+    return rv;
+}
+
+// Prenex ======================================================================
+
+/**
+ * Visitor collecting quantifiers in pre-order
+*/
+struct QuantifierCollector{
+    std::vector<Formula*>& quantifiers;
+
+    void onQuant(Formula* formula){
+        quantifiers.push_back(formula);
+    }
+};
+
+/**
+ * Renames the quantifiers of a formula so that no two quantifiers bind the
+ * same name and no quantifier binds a name that also occurs free. Afterwards
+ * quantifiers can be moved anywhere without capturing anything.
+*/
+void renameQuantifiers(Formula* formula){
+    //The name of every occurrence bound to each quantifier
+    std::unordered_map<Formula*, std::vector<std::string*>> occurrences;
+    for(auto [term, quantifierFormula] : formula->boundTermVariables()){
+        occurrences[quantifierFormula].push_back(&term->name);
+    }
+    for(auto [function, quantifierFormula] : formula->boundFunctionVariables()){
+        occurrences[quantifierFormula].push_back(&function->name);
+    }
+    for(auto [predicate, quantifierFormula] : formula->boundPredicateVariables()){
+        occurrences[quantifierFormula].push_back(&predicate->pred->name);
+    }
+    std::unordered_set<const std::string*> bound;
+    for(auto& [quantifierFormula, names] : occurrences){
+        bound.insert(names.begin(), names.end());
+    }
+
+    //The names of every free occurrence
+    std::unordered_set<std::string> freeNames;
+    std::vector<const Term*> terms;
+    for(Formula* predicate : formula->allPredicates()){
+        if(bound.find(&predicate->pred->name) == bound.end()){
+            freeNames.insert(predicate->pred->name);
+        }
+        terms.assign(predicate->pred->args.begin(), predicate->pred->args.end());
+        while(!terms.empty()){
+            const Term* term = terms.back();
+            terms.pop_back();
+            if(bound.find(&term->name) == bound.end()){
+                freeNames.insert(term->name);
+            }
+            terms.insert(terms.end(), term->args.begin(), term->args.end());
+        }
+    }
+
+    std::vector<Formula*> quantifiers;
+    visit(formula, QuantifierCollector{quantifiers});
+    std::unordered_set<std::string> taken = formula->identifiers();
+    std::unordered_set<std::string> binders;
+    for(Formula* quantifierFormula : quantifiers){
+        std::string& var = quantifierFormula->quantifier->var;
+        if(binders.find(var) != binders.end() || freeNames.find(var) != freeNames.end()){
+            //Number the variable until it is fresh
+            std::string fresh;
+            size_t i = 1;
+            do{
+                fresh = var + std::to_string(i++);
+            }while(taken.find(fresh) != taken.end());
+            taken.insert(fresh);
+            for(std::string* name : occurrences[quantifierFormula]){
+                *name = fresh;
+            }
+            var = std::move(fresh);
+        }
+        binders.insert(var);
+    }
+}
+
+Formula* toPrenex(const Formula* formula){
+    pFormula matrix(toNNF(formula));
+    renameQuantifiers(matrix.get());
+
+    //Splice every quantifier out of the matrix, keeping them in pre-order
+    std::vector<std::pair<Formula::Type, std::string>> prefix;
+    std::vector<Formula*> stack = {matrix.get()};
+    stack.reserve(16);
+    while(!stack.empty()){
+        Formula* f = stack.back();
+        stack.pop_back();
+        while(f->connectiveType == Formula::ConnectiveType::QUANT){
+            prefix.emplace_back(f->type, std::move(f->quantifier->var));
+            Formula body(std::move(*f->quantifier->arg));
+            *f = std::move(body);
+        }
+        if(f->connectiveType == Formula::ConnectiveType::UNARY){
+            stack.push_back(f->unary->arg);
+        }else if(f->connectiveType == Formula::ConnectiveType::BINARY){
+            stack.push_back(f->binary->right);
+            stack.push_back(f->binary->left);
+        }
+    }
+
+    Formula* rv = matrix.release();
+    for(auto itr = prefix.rbegin(); itr != prefix.rend(); itr++){
+        rv = itr->first == Formula::Type::FORALL ? Forall(std::move(itr->second), rv) :
+                                                   Exists(std::move(itr->second), rv);
+    }
+    return rv;
+}
+
+// Clause Sets =================================================================
+
+size_t ClauseSet::size() const{
+    return this->offsets.size() - 1;
+}
+
+size_t ClauseSet::variables() const{
+    return this->atoms.size();
+}
+
+std::span<const int> ClauseSet::clause(size_t i) const{
+    return std::span<const int>(this->literals.data() + this->offsets[i],
+                                this->offsets[i + 1] - this->offsets[i]);
+}
+
+void ClauseSet::addClause(std::span<const int> clause){
+    this->literals.insert(this->literals.end(), clause.begin(), clause.end());
+    this->offsets.push_back(this->literals.size());
+}
+
+void ClauseSet::addClause(std::initializer_list<int> clause){
+    this->addClause(std::span<const int>(clause.begin(), clause.size()));
+}
+
+int ClauseSet::newVariable(pFormula atom){
+    this->atoms.push_back(std::move(atom));
+    return (int)this->atoms.size();
+}
+
+// Tseitin =====================================================================
+
+size_t Tseitin::DefinitionHash::operator()(const std::pair<int, std::pair<int, int>>& key) const{
+    size_t rv = std::hash<int>()(key.first);
+    rv = rv * 0x9e3779b97f4a7c15ULL + std::hash<int>()(key.second.first);
+    rv = rv * 0x9e3779b97f4a7c15ULL + std::hash<int>()(key.second.second);
+    return rv;
+}
+
+int Tseitin::atom(const Formula* formula){
+    auto itr = this->atomVariables.find(formula);
+    if(itr != this->atomVariables.end()){
+        return itr->second;
+    }
+    pFormula copy(formula->copy());
+    const Formula* key = copy.get();
+    int variable = this->clauses.newVariable(std::move(copy));
+    this->atomVariables.emplace(key, variable);
+    return variable;
+}
+
+int Tseitin::connective(Formula::Type type, int left, int right){
+    bool negated = false;
+    switch(type){
+        case Formula::Type::IF:
+            //a -> b is ~(a /\ ~b)
+            right = -right;
+            negated = true;
+            type = Formula::Type::AND;
+            break;
+        case Formula::Type::OR:
+            //a \/ b is ~(~a /\ ~b)
+            left = -left;
+            right = -right;
+            negated = true;
+            type = Formula::Type::AND;
+            break;
+        case Formula::Type::IFF:
+            //~a <-> b is ~(a <-> b)
+            negated = (left < 0) != (right < 0);
+            left = std::abs(left);
+            right = std::abs(right);
+            break;
+        case Formula::Type::AND:
+            break;
+        default:
+            throw std::runtime_error("Tseitin definitions are only for binary connectives");
+    }
+    if(left > right){
+        std::swap(left, right);
+    }
+
+    auto [itr, inserted] = this->definitions.try_emplace({(int)type, {left, right}}, 0);
+    if(inserted){
+        int v = this->clauses.newVariable();
+        itr->second = v;
+        if(type == Formula::Type::AND){
+            this->clauses.addClause({-v, left});
+            this->clauses.addClause({-v, right});
+            this->clauses.addClause({v, -left, -right});
+        }else{
+            this->clauses.addClause({-v, -left, right});
+            this->clauses.addClause({-v, left, -right});
+            this->clauses.addClause({v, left, right});
+            this->clauses.addClause({v, -left, -right});
+        }
+    }
+    return negated ? -itr->second : itr->second;
+}
+
+/**
+ * Post-order visitor replacing each subformula with its literal on a stack,
+ * quantified subformulae are atoms so everything inside them is skipped.
+*/
+struct TseitinVisitor{
+    Tseitin& tseitin;
+    std::vector<int> literals = {};
+    size_t quantifierDepth = 0;
+
+    void onPred(const Formula* formula){
+        if(quantifierDepth == 0){
+            literals.push_back(tseitin.atom(formula));
+        }
+    }
+    void onUnary(const Formula*){
+        if(quantifierDepth == 0){
+            literals.back() = -literals.back();
+        }
+    }
+    void onBinary(const Formula* formula){
+        if(quantifierDepth == 0){
+            int right = literals.back();
+            literals.pop_back();
+            literals.back() = tseitin.connective(formula->type, literals.back(), right);
+        }
+    }
+    void enterQuant(const Formula*){
+        quantifierDepth++;
+    }
+    void onQuant(const Formula* formula){
+        if(--quantifierDepth == 0){
+            literals.push_back(tseitin.atom(formula));
+        }
+    }
+};
+
+int Tseitin::define(const Formula* formula){
+    TseitinVisitor visitor{*this};
+    visitPostOrder(formula, visitor);
+    return visitor.literals.back();
+}
+
+ClauseSet toCNF(const Formula* formula){
+    Tseitin tseitin;
+    int literal = tseitin.define(formula);
+    tseitin.clauses.addClause({literal});
+    return std::move(tseitin.clauses);
+}
+
+// DNF =========================================================================
+
+using Cube = std::vector<int>;
+using Cubes = std::vector<Cube>;
+
+/**
+ * Conjoins two cubes, literals are kept sorted by variable.
+ * @return false if the conjunction is contradictory
+*/
+bool conjoinCubes(const Cube& a, const Cube& b, Cube& rv){
+    rv.clear();
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(rv),
+               [](int x, int y){ return std::abs(x) < std::abs(y) || (std::abs(x) == std::abs(y) && x < y); });
+    rv.erase(std::unique(rv.begin(), rv.end()), rv.end());
+    for(size_t i = 1; i < rv.size(); i++){
+        if(rv[i] == -rv[i - 1]){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Post-order visitor distributing a negation normal form into cubes, each
+ * subformula is replaced with its list of cubes on a stack.
+*/
+struct DNFVisitor{
+    Tseitin& atoms;
+    size_t maxCubes;
+    std::vector<Cubes> results = {};
+    size_t quantifierDepth = 0;
+
+    void onPred(const Formula* formula){
+        if(quantifierDepth == 0){
+            results.push_back({{atoms.atom(formula)}});
+        }
+    }
+    //Negations only apply to atoms in negation normal form
+    void onUnary(const Formula*){
+        if(quantifierDepth == 0){
+            results.back()[0][0] = -results.back()[0][0];
+        }
+    }
+    void onBinary(const Formula* formula){
+        if(quantifierDepth > 0){
+            return;
+        }
+        Cubes right = std::move(results.back());
+        results.pop_back();
+        Cubes& left = results.back();
+        if(formula->type == Formula::Type::OR){
+            left.insert(left.end(), std::make_move_iterator(right.begin()),
+                        std::make_move_iterator(right.end()));
+        }else{
+            Cubes product;
+            Cube cube;
+            for(const Cube& a : left){
+                for(const Cube& b : right){
+                    if(conjoinCubes(a, b, cube)){
+                        product.push_back(cube);
+                    }
+                }
+                if(product.size() > maxCubes){
+                    break;
+                }
+            }
+            left = std::move(product);
+        }
+        if(left.size() > maxCubes){
+            throw std::runtime_error("DNF conversion exceeded the limit of " +
+                                     std::to_string(maxCubes) + " cubes");
+        }
+    }
+    void enterQuant(const Formula*){
+        quantifierDepth++;
+    }
+    void onQuant(const Formula* formula){
+        if(--quantifierDepth == 0){
+            results.push_back({{atoms.atom(formula)}});
+        }
+    }
+};
+
+ClauseSet toDNF(const Formula* formula, size_t maxCubes){
+    pFormula nnf(toNNF(formula));
+    Tseitin atoms;
+    DNFVisitor visitor{atoms, maxCubes};
+    visitPostOrder((const Formula*)nnf.get(), visitor);
+    for(const Cube& cube : visitor.results.back()){
+        atoms.clauses.addClause(cube);
+    }
+    return std::move(atoms.clauses);
+}
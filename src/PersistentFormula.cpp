@@ -0,0 +1,296 @@
+
+#include<vector>
+#include<utility>
+#include<stdexcept>
+
+#include "PersistentFormula.hpp"
+#include "settings.hpp"
+
+using NodePtr = std::shared_ptr<const PersistentFormula::Node>;
+using MutableNodePtr = std::shared_ptr<PersistentFormula::Node>;
+
+PersistentFormula::Node::~Node(){
+    //Subtrees only referenced by this node are unlinked onto an explicit stack
+    //and released one at a time, so freeing a deep chain does not recurse
+    std::vector<NodePtr> stack;
+    for(NodePtr& arg : this->args){
+        if(arg.use_count() == 1){
+            stack.push_back(std::move(arg));
+        }
+    }
+    while(!stack.empty()){
+        NodePtr node = std::move(stack.back());
+        stack.pop_back();
+        //We hold the last reference, nothing else can observe the node
+        Node* last = const_cast<Node*>(node.get());
+        for(NodePtr& arg : last->args){
+            if(arg.use_count() == 1){
+                stack.push_back(std::move(arg));
+            }
+        }
+        last->args.clear();
+    }
+}
+
+/**
+ * Converts a mutable formula tree into persistent nodes using an explicit stack
+ * @param formula the formula to convert
+ * @return the root of the new persistent tree
+*/
+NodePtr toPersistentNode(const Formula* formula){
+    MutableNodePtr root = std::make_shared<PersistentFormula::Node>();
+    std::vector<std::pair<const Formula*, PersistentFormula::Node*>> stack = 
+        {{formula, root.get()}};
+    while(!stack.empty()){
+        auto [source, node] = stack.back();
+        stack.pop_back();
+        node->type = source->type;
+        node->connectiveType = source->connectiveType;
+        if(source->connectiveType == Formula::ConnectiveType::PRED){
+            node->pred = pFormula(source->copy());
+            continue;
+        }
+        if(source->connectiveType == Formula::ConnectiveType::QUANT){
+            node->var = source->quantifier->var;
+        }
+        for(Formula* subformula : source->subformulae()){
+            MutableNodePtr arg = std::make_shared<PersistentFormula::Node>();
+            stack.emplace_back(subformula, arg.get());
+            node->args.push_back(std::move(arg));
+        }
+    }
+    return root;
+}
+
+/**
+ * Converts persistent nodes back into a mutable formula tree using an
+ * explicit stack
+ * @param root the root of the persistent tree to convert
+ * @return a newly allocated formula 
+*/
+Formula* fromPersistentNode(const PersistentFormula::Node* root){
+    //Post-order traversal, connectives are built from the results stack
+    std::vector<std::pair<const PersistentFormula::Node*, bool>> stack = {{root, false}};
+    std::vector<pFormula> results;
+    while(!stack.empty()){
+        auto [node, expanded] = stack.back();
+        stack.pop_back();
+        if(node->type == Formula::Type::PRED){
+            results.emplace_back(node->pred->copy());
+            continue;
+        }
+        if(!expanded){
+            stack.emplace_back(node, true);
+            for(auto itr = node->args.rbegin(); itr != node->args.rend(); itr++){
+                stack.emplace_back(itr->get(), false);
+            }
+            continue;
+        }
+        Formula* rv;
+        if(node->args.size() == 1){
+            Formula* arg = results.back().release();
+            results.pop_back();
+            switch(node->type){
+                case Formula::Type::NOT: rv = Not(arg); break;
+                case Formula::Type::FORALL: rv = Forall(node->var, arg); break;
+                default: rv = Exists(node->var, arg); break;
+            }
+        }else{
+            Formula* right = results.back().release();
+            results.pop_back();
+            Formula* left = results.back().release();
+            results.pop_back();
+            switch(node->type){
+                case Formula::Type::AND: rv = And(left, right); break;
+                case Formula::Type::OR: rv = Or(left, right); break;
+                case Formula::Type::IF: rv = If(left, right); break;
+                default: rv = Iff(left, right); break;
+            }
+        }
+        results.emplace_back(rv);
+    }
+    return results.back().release();
+}
+
+/**
+ * Compares two persistent trees with an explicit stack, shared subtrees are
+ * equal without being traversed.
+*/
+bool equalNodes(const PersistentFormula::Node* a, const PersistentFormula::Node* b){
+    std::vector<std::pair<const PersistentFormula::Node*, 
+                          const PersistentFormula::Node*>> stack = {{a, b}};
+    while(!stack.empty()){
+        auto [x, y] = stack.back();
+        stack.pop_back();
+        if(x == y){
+            continue;
+        }
+        if(x->type != y->type || x->var != y->var || x->args.size() != y->args.size()){
+            return false;
+        }
+        if(x->type == Formula::Type::PRED && !(*x->pred == *y->pred)){
+            return false;
+        }
+        for(size_t i = 0; i < x->args.size(); i++){
+            stack.emplace_back(x->args[i].get(), y->args[i].get());
+        }
+    }
+    return true;
+}
+
+/**
+ * Rebuilds the path from node to pos, sharing all off path subtrees.
+*/
+NodePtr replaceNode(const NodePtr& node, std::queue<size_t>& pos, 
+                    const NodePtr& replacement){
+    if(pos.empty()){
+        return replacement;
+    }
+    //Copy each node on the path, linking it into the copy of its parent
+    MutableNodePtr root;
+    PersistentFormula::Node* parentCopy = nullptr;
+    size_t parentIndex = 0;
+    const PersistentFormula::Node* current = node.get();
+    while(!pos.empty()){
+        size_t index = pos.front();
+        pos.pop();
+        if(index >= current->args.size()){
+            throw std::out_of_range("Persistent Formula Error: Position does"
+                                    " not exist for this formula");
+        }
+        MutableNodePtr copy = std::make_shared<PersistentFormula::Node>();
+        copy->type = current->type;
+        copy->connectiveType = current->connectiveType;
+        copy->var = current->var;
+        copy->args = current->args;
+        if(parentCopy == nullptr){
+            root = copy;
+        }else{
+            parentCopy->args[parentIndex] = copy;
+        }
+        parentCopy = copy.get();
+        parentIndex = index;
+        current = current->args[index].get();
+    }
+    parentCopy->args[parentIndex] = replacement;
+    return root;
+}
+
+// PersistentFormula members ===================================================
+
+PersistentFormula::PersistentFormula(const Formula* formula)
+:root(toPersistentNode(formula)){
+}
+
+PersistentFormula::PersistentFormula(std::shared_ptr<const Node> root_)
+:root(std::move(root_)){
+}
+
+PersistentFormula PersistentFormula::copy() const{
+    return PersistentFormula(this->root);
+}
+
+Formula* PersistentFormula::toFormula() const{
+    if(this->empty()){
+        throw std::runtime_error("Persistent Formula Error: Can not convert an"
+                                 " empty formula");
+    }
+    return fromPersistentNode(this->root.get());
+}
+
+bool PersistentFormula::operator==(const PersistentFormula& other) const{
+    if(this->empty() || other.empty()){
+        return this->empty() && other.empty();
+    }
+    return equalNodes(this->root.get(), other.root.get());
+}
+
+bool PersistentFormula::empty() const{
+    return this->root == nullptr;
+}
+
+Formula::Type PersistentFormula::type() const{
+    return this->root->type;
+}
+
+Formula::ConnectiveType PersistentFormula::connectiveType() const{
+    return this->root->connectiveType;
+}
+
+const std::string& PersistentFormula::var() const{
+    return this->root->var;
+}
+
+const Formula* PersistentFormula::predicate() const{
+    return this->root->pred.get();
+}
+
+size_t PersistentFormula::arity() const{
+    return this->root->args.size();
+}
+
+PersistentFormula PersistentFormula::subformula(size_t i) const{
+    if(i >= this->arity()){
+        throw std::out_of_range("Persistent Formula Error: Subformula index out"
+                                " of range");
+    }
+    return PersistentFormula(this->root->args[i]);
+}
+
+PersistentFormula PersistentFormula::atPosition(std::queue<size_t> pos) const{
+    NodePtr node = this->root;
+    while(!pos.empty()){
+        if(pos.front() >= node->args.size()){
+            throw std::out_of_range("Persistent Formula Error: Position does"
+                                    " not exist for this formula");
+        }
+        node = node->args[pos.front()];
+        pos.pop();
+    }
+    return PersistentFormula(node);
+}
+
+PersistentFormula PersistentFormula::replaceAt(std::queue<size_t> pos,
+    const PersistentFormula& replacement) const{
+    if(this->empty() || replacement.empty()){
+        throw std::runtime_error("Persistent Formula Error: Can not edit with"
+                                 " an empty formula");
+    }
+    return PersistentFormula(replaceNode(this->root, pos, replacement.root));
+}
+
+// SExpression Converters ======================================================
+
+std::string toSExpression(const PersistentFormula& formula){
+    if(formula.empty()){
+        return "";
+    }
+    std::string rv;
+    //A null entry closes the innermost open connective
+    std::vector<const PersistentFormula::Node*> stack = {formula.root.get()};
+    while(!stack.empty()){
+        const PersistentFormula::Node* node = stack.back();
+        stack.pop_back();
+        if(node == nullptr){
+            rv.back() = ')';
+            rv += ' ';
+        }else if(node->type == Formula::Type::PRED){
+            rv += toSExpression(node->pred.get());
+            rv += ' ';
+        }else{
+            rv += '(';
+            rv += TYPE_STRING_MAP.at(node->type);
+            rv += ' ';
+            if(node->connectiveType == Formula::ConnectiveType::QUANT){
+                rv += node->var;
+                rv += ' ';
+            }
+            stack.push_back(nullptr);
+            for(auto itr = node->args.rbegin(); itr != node->args.rend(); itr++){
+                stack.push_back(itr->get());
+            }
+        }
+    }
+    rv.pop_back();
+    return rv;
+}
@@ -1,4 +1,7 @@
+#include<memory>
 #include<string>
+#include<vector>
+#include<string_view>
 
 #include<rapidjson/document.h>
 #include<rapidjson/schema.h>
@@ -13,52 +16,90 @@ void throwFailure(const std::string& message){
     "json file: " + message);
 }
 
+ProofNode::ProofNode(std::shared_ptr<AssumptionUniverse> universe)
+    : universe(std::move(universe)){
+    index = this->universe->add(this);
+}
+
+ProofNode::~ProofNode(){
+    if(formula){
+        universe->unindex(this);
+    }
+    universe->remove(index);
+}
+
+void ProofNode::setFormula(pFormula formula){
+    if(this->formula){
+        universe->unindex(this);
+    }
+    this->formula = std::move(formula);
+    formulaHash = std::hash<Formula>()(*this->formula);
+    identifiers = universe->intern(this->formula->freeIdentifiers());
+    universe->index(this);
+}
+
 ProofNode* newProofNode(
     std::string formulaExpr, std::string justification, 
-    std::vector<ProofNode*> parents
+    std::vector<ProofNode*> parents,
+    std::shared_ptr<AssumptionUniverse> universe
 ){
-    ProofNode* p = new ProofNode;
-    p->formula = fromSExpressionString(formulaExpr);
+    ProofNode* p = new ProofNode(std::move(universe));
+    p->setFormula(pFormula(fromSExpressionString(std::move(formulaExpr))));
     p->justification = JUSTIFICATION_STRING_MAP.at(justification);
-    p->parents = parents;
-    p->assumptions = {};
+    p->parents = std::move(parents);
     return p;
 }
 
-ProofGraph* newProofGraph(std::string jsonProofGraph){
+// Proof Graph Parsing =========================================================
+
+struct ProofGraphParser::State{
+    static constexpr size_t ARENA_SIZE = 64 * 1024;
+
     rapidjson::Document schemaDoc;
-    schemaDoc.Parse(proofGraphSchema.c_str());
-    if(schemaDoc.HasParseError()){
+    std::unique_ptr<rapidjson::SchemaDocument> schema;
+    std::unique_ptr<rapidjson::SchemaValidator> validator;
+    std::vector<char> arena = std::vector<char>(ARENA_SIZE);
+    rapidjson::Document::AllocatorType allocator{arena.data(), arena.size()};
+    rapidjson::Document document{&allocator};
+};
+
+ProofGraphParser::ProofGraphParser() : state(new State){
+    state->schemaDoc.Parse(proofGraphSchema.c_str());
+    if(state->schemaDoc.HasParseError()){
         throw std::runtime_error("Proof Graph Schema JSON is invalid");
     }
-    rapidjson::Document proofGraphDoc;
-    proofGraphDoc.Parse(jsonProofGraph.c_str());
+    state->schema.reset(new rapidjson::SchemaDocument(state->schemaDoc));
+    state->validator.reset(new rapidjson::SchemaValidator(*state->schema));
+}
+
+ProofGraphParser::~ProofGraphParser() = default;
+
+ProofGraph* ProofGraphParser::parse(std::string_view jsonProofGraph){
+    //The values of the last graph are dropped with the arena rather than freed
+    state->allocator.Clear();
+    rapidjson::Document& proofGraphDoc = state->document;
+    proofGraphDoc.Parse(jsonProofGraph.data(), jsonProofGraph.size());
     if(proofGraphDoc.HasParseError()){
         throw std::runtime_error("Proof Graph JSON is malformed");
     }
-    rapidjson::SchemaDocument d = rapidjson::SchemaDocument(schemaDoc);
-    rapidjson::SchemaValidator validator(d);
-    if(!proofGraphDoc.Accept(validator)){
+    state->validator->Reset();
+    if(!proofGraphDoc.Accept(*state->validator)){
         throw std::runtime_error("Proof Graph JSON does not conform to schema");
     }
 
     const rapidjson::Value& nodes = proofGraphDoc["nodes"];
     const rapidjson::Value& links = proofGraphDoc["links"];
     
-    ProofGraph* graph = new ProofGraph;
-    graph->assumptions = std::set<ProofNode*>();
-    graph->nodes = std::unordered_map<size_t, ProofNode*>();
+    std::unique_ptr<ProofGraph> graph(new ProofGraph);
 
     //Create the nodes and add them to the list of all nodes
     for (rapidjson::Value::ConstValueIterator itr = nodes.Begin(); itr != nodes.End(); itr++){
         const rapidjson::Value& json_node = *itr;
-        ProofNode* node = new ProofNode;
-        node->formula = fromSExpression(sExpression(json_node["formula"].GetString()));
+        pProofNode node(new ProofNode(graph->universe));
+        node->id = json_node["id"].GetUint();
+        node->setFormula(pFormula(fromSExpression(sExpression(json_node["formula"].GetString()))));
         node->justification = JUSTIFICATION_STRING_MAP.at(json_node["justification"].GetString());
-        node->parents = std::vector<ProofNode*>();
-        node->assumptions = std::set<ProofNode*>();
-        node->children = std::list<ProofNode*>();
-        graph->nodes[json_node["id"].GetUint()] = node;
+        graph->nodes[node->id] = std::move(node);
     }
 
     //Use links to connect the nodes parents and children
@@ -66,18 +107,22 @@ ProofGraph* newProofGraph(std::string jsonProofGraph){
         const rapidjson::Value& json_link = *itr;
         size_t from = json_link["from"].GetUint();
         size_t to = json_link["to"].GetUint();
-        ProofNode* from_p = graph->nodes[from];
-        ProofNode* to_p = graph->nodes[to];
+        ProofNode* from_p = graph->nodes.at(from).get();
+        ProofNode* to_p = graph->nodes.at(to).get();
         from_p->children.push_back(to_p);
         to_p->parents.push_back(from_p);
     }
 
     //Add all nodes with no parents to the assumption set
-    for(const auto [_, node] :  graph->nodes){
+    for(const auto& [_, node] :  graph->nodes){
         if(node->parents.size() == 0){
-            graph->assumptions.insert(node);
+            graph->assumptions.insert(node.get());
         }
     }
 
-    return graph;
-}
\ No newline at end of file
+    return graph.release();
+}
+
+ProofGraph* newProofGraph(std::string jsonProofGraph){
+    return ProofGraphParser().parse(jsonProofGraph);
+}
@@ -0,0 +1,396 @@
+
+#include<string>
+#include<vector>
+#include<utility>
+#include<algorithm>
+#include<stdexcept>
+
+#include "Rewrite.hpp"
+#include "FormulaVisitor.hpp"
+
+using Bindings = std::vector<std::pair<uint32_t, uint32_t>>;
+
+// Interning ===================================================================
+
+uint32_t Rewriter::intern(Formula::Type type, uint32_t left, uint32_t right){
+    uint64_t key = ((uint64_t)type << 60) | ((uint64_t)left << 30) | right;
+    auto [itr, inserted] = this->nodeIds.try_emplace(key, this->nodes.size());
+    if(inserted){
+        if(this->nodes.size() >= (1u << 30)){
+            throw std::runtime_error("Rewriter node table is full");
+        }
+        this->nodes.push_back({type, left, right});
+        this->normalForms.push_back(NONE);
+    }
+    return itr->second;
+}
+
+uint32_t Rewriter::internAtom(const Formula* predicate){
+    auto itr = this->atomIds.find(predicate);
+    if(itr == this->atomIds.end()){
+        pFormula copy(predicate->copy());
+        const std::string& name = copy->pred->name;
+        this->metavariables.push_back(copy->pred->args.size() == 0 && name.size() > 1 && name[0] == '?');
+        itr = this->atomIds.emplace(copy.get(), this->atoms.size()).first;
+        this->atoms.push_back(std::move(copy));
+    }
+    return this->intern(Formula::Type::PRED, itr->second, 0);
+}
+
+/**
+ * Post-order visitor interning each subformula, the ids of the subformulae
+ * not yet consumed by their parent are kept on a stack.
+*/
+struct InternVisitor{
+    Rewriter& rewriter;
+    std::vector<uint32_t> ids = {};
+
+    void onPred(const Formula* formula){
+        ids.push_back(rewriter.internAtom(formula));
+    }
+    void onUnary(const Formula* formula){
+        ids.back() = rewriter.intern(formula->type, ids.back(), 0);
+    }
+    void onBinary(const Formula* formula){
+        uint32_t right = ids.back();
+        ids.pop_back();
+        ids.back() = rewriter.intern(formula->type, ids.back(), right);
+    }
+    void onQuant(const Formula* formula){
+        auto [itr, inserted] = rewriter.variableIds.try_emplace(formula->quantifier->var,
+                                                               rewriter.variables.size());
+        if(inserted){
+            rewriter.variables.push_back(formula->quantifier->var);
+        }
+        ids.back() = rewriter.intern(formula->type, ids.back(), itr->second);
+    }
+};
+
+uint32_t Rewriter::internFormula(const Formula* formula){
+    InternVisitor visitor{*this};
+    visitPostOrder(formula, visitor);
+    return visitor.ids.back();
+}
+
+Formula* Rewriter::toFormula(uint32_t id) const{
+    Formula* rv = new Formula;
+    //Stack of node ids and the empty formulae they are written to
+    std::vector<std::pair<uint32_t, Formula*>> stack = {{id, rv}};
+    stack.reserve(16);
+    while(!stack.empty()){
+        auto [nodeId, target] = stack.back();
+        stack.pop_back();
+        const Node& node = this->nodes[nodeId];
+        target->type = node.type;
+        switch(node.type){
+            case Formula::Type::PRED:{
+                pFormula copy(this->atoms[node.left]->copy());
+                *target = std::move(*copy);
+                break;
+            }
+            case Formula::Type::NOT:
+                target->connectiveType = Formula::ConnectiveType::UNARY;
+                target->unary = new Formula::UnaryConnective{new Formula};
+                stack.emplace_back(node.left, target->unary->arg);
+                break;
+            case Formula::Type::FORALL:
+            case Formula::Type::EXISTS:
+                target->connectiveType = Formula::ConnectiveType::QUANT;
+                target->quantifier = new Formula::Quantifier{this->variables[node.right], new Formula};
+                stack.emplace_back(node.left, target->quantifier->arg);
+                break;
+            default:
+                target->connectiveType = Formula::ConnectiveType::BINARY;
+                target->binary = new Formula::BinaryConnective{new Formula, new Formula};
+                stack.emplace_back(node.right, target->binary->right);
+                stack.emplace_back(node.left, target->binary->left);
+        }
+    }
+    return rv;
+}
+
+// Rules =======================================================================
+
+/** @return the metavariable atoms of a pattern */
+std::vector<uint32_t> patternMetavariables(const Rewriter& rewriter, uint32_t pattern){
+    std::vector<uint32_t> rv;
+    std::vector<uint32_t> stack = {pattern};
+    while(!stack.empty()){
+        const Rewriter::Node& node = rewriter.nodes[stack.back()];
+        stack.pop_back();
+        switch(node.type){
+            case Formula::Type::PRED:
+                if(rewriter.metavariables[node.left]){
+                    rv.push_back(node.left);
+                }
+                break;
+            case Formula::Type::NOT:
+            case Formula::Type::FORALL:
+            case Formula::Type::EXISTS:
+                stack.push_back(node.left);
+                break;
+            default:
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+        }
+    }
+    return rv;
+}
+
+void Rewriter::addRule(const RewriteRuleSpec& spec){
+    pFormula pattern (fromSExpressionString(spec.pattern));
+    pFormula replacement (fromSExpressionString(spec.replacement));
+    Rule rule{spec.name, this->internFormula(pattern.get()), this->internFormula(replacement.get())};
+
+    const Node& root = this->nodes[rule.pattern];
+    if(root.type == Formula::Type::PRED && this->metavariables[root.left]){
+        throw std::runtime_error("Rule " + spec.name + " has a metavariable as its pattern");
+    }
+    std::vector<uint32_t> bound = patternMetavariables(*this, rule.pattern);
+    for(uint32_t metavariable : patternMetavariables(*this, rule.replacement)){
+        if(std::find(bound.begin(), bound.end(), metavariable) == bound.end()){
+            throw std::runtime_error("Rule " + spec.name + " uses the unbound metavariable " +
+                                     this->atoms[metavariable]->pred->name);
+        }
+    }
+
+    this->rulesByType[(size_t)root.type].push_back(this->rules.size());
+    this->rules.push_back(std::move(rule));
+    //Normal forms under the old rules may not be normal anymore
+    std::fill(this->normalForms.begin(), this->normalForms.end(), NONE);
+}
+
+void Rewriter::addRules(const std::vector<RewriteRuleSpec>& rules){
+    for(const RewriteRuleSpec& rule : rules){
+        this->addRule(rule);
+    }
+}
+
+/**
+ * Matches a pattern against a node. Commutative connectives try both
+ * operand orders, a choice point saves the remaining goals so a later
+ * failure can backtrack into the swapped order.
+*/
+bool Rewriter::match(uint32_t pattern, uint32_t id, Bindings& bindings) const{
+    struct Choice{
+        std::vector<std::pair<uint32_t, uint32_t>> goals;
+        size_t bindings;
+    };
+    std::vector<std::pair<uint32_t, uint32_t>> goals = {{pattern, id}};
+    std::vector<Choice> choices;
+    while(!goals.empty()){
+        auto [p, t] = goals.back();
+        goals.pop_back();
+        const Node& pNode = this->nodes[p];
+        const Node& tNode = this->nodes[t];
+        bool matched = true;
+        if(pNode.type == Formula::Type::PRED && this->metavariables[pNode.left]){
+            auto itr = std::find_if(bindings.begin(), bindings.end(),
+                                    [&](const std::pair<uint32_t, uint32_t>& b){ return b.first == pNode.left; });
+            if(itr == bindings.end()){
+                bindings.emplace_back(pNode.left, t);
+            }else{
+                matched = itr->second == t;
+            }
+        }else if(pNode.type != tNode.type){
+            matched = false;
+        }else{
+            switch(pNode.type){
+                case Formula::Type::PRED:
+                    //Atoms are interned, equal atoms have equal ids
+                    matched = p == t;
+                    break;
+                case Formula::Type::NOT:
+                    goals.emplace_back(pNode.left, tNode.left);
+                    break;
+                case Formula::Type::FORALL:
+                case Formula::Type::EXISTS:
+                    matched = pNode.right == tNode.right;
+                    goals.emplace_back(pNode.left, tNode.left);
+                    break;
+                case Formula::Type::IF:
+                    goals.emplace_back(pNode.right, tNode.right);
+                    goals.emplace_back(pNode.left, tNode.left);
+                    break;
+                default:{
+                    std::vector<std::pair<uint32_t, uint32_t>> swapped = goals;
+                    swapped.emplace_back(pNode.right, tNode.left);
+                    swapped.emplace_back(pNode.left, tNode.right);
+                    choices.push_back({std::move(swapped), bindings.size()});
+                    goals.emplace_back(pNode.right, tNode.right);
+                    goals.emplace_back(pNode.left, tNode.left);
+                }
+            }
+        }
+        if(!matched){
+            if(choices.empty()){
+                return false;
+            }
+            goals = std::move(choices.back().goals);
+            bindings.resize(choices.back().bindings);
+            choices.pop_back();
+        }
+    }
+    return true;
+}
+
+/**
+ * Builds a replacement with its metavariables substituted, replacements are
+ * written by hand and small so this recurses.
+*/
+uint32_t Rewriter::instantiate(uint32_t replacement, const Bindings& bindings){
+    Node node = this->nodes[replacement];
+    switch(node.type){
+        case Formula::Type::PRED:
+            if(this->metavariables[node.left]){
+                for(auto [metavariable, id] : bindings){
+                    if(metavariable == node.left){
+                        return id;
+                    }
+                }
+            }
+            return replacement;
+        case Formula::Type::NOT:
+            return this->intern(node.type, this->instantiate(node.left, bindings), 0);
+        case Formula::Type::FORALL:
+        case Formula::Type::EXISTS:
+            return this->intern(node.type, this->instantiate(node.left, bindings), node.right);
+        default:{
+            uint32_t left = this->instantiate(node.left, bindings);
+            uint32_t right = this->instantiate(node.right, bindings);
+            return this->intern(node.type, left, right);
+        }
+    }
+}
+
+uint32_t Rewriter::applyRules(uint32_t id){
+    Bindings bindings;
+    for(uint32_t index : this->rulesByType[(size_t)this->nodes[id].type]){
+        bindings.clear();
+        if(this->match(this->rules[index].pattern, id, bindings)){
+            return this->instantiate(this->rules[index].replacement, bindings);
+        }
+    }
+    return NONE;
+}
+
+// Normalization ===============================================================
+
+/**
+ * Innermost normalization with an explicit stack. A frame first normalizes
+ * the children of its node, then rebuilds the node over their normal forms
+ * and tries the rules at the root. If a rule applies the frame waits on the
+ * normal form of the result.
+*/
+uint32_t Rewriter::normalize(uint32_t root){
+    struct Frame{
+        uint32_t id;
+        uint32_t rebuilt;
+        uint32_t result;
+        unsigned char stage;
+    };
+    std::vector<Frame> stack = {{root, NONE, NONE, 0}};
+    std::vector<uint8_t> onStack(this->nodes.size());
+    auto mark = [&](uint32_t id, uint8_t value){
+        if(onStack.size() <= id){
+            onStack.resize(this->nodes.size());
+        }
+        onStack[id] = value;
+    };
+    auto marked = [&](uint32_t id){
+        return id < onStack.size() && onStack[id];
+    };
+    auto childrenOf = [&](const Node& node, uint32_t children[2]){
+        switch(node.type){
+            case Formula::Type::PRED:
+                return 0;
+            case Formula::Type::NOT:
+            case Formula::Type::FORALL:
+            case Formula::Type::EXISTS:
+                children[0] = node.left;
+                return 1;
+            default:
+                children[0] = node.left;
+                children[1] = node.right;
+                return 2;
+        }
+    };
+
+    size_t steps = 0;
+    while(!stack.empty()){
+        Frame frame = stack.back();
+        if(frame.stage == 0){
+            if(this->normalForms[frame.id] != NONE){
+                stack.pop_back();
+                continue;
+            }
+            //A rule produced a formula containing one being normalized
+            if(marked(frame.id)){
+                throw std::runtime_error("Rewrite rules do not terminate");
+            }
+            mark(frame.id, 1);
+            stack.back().stage = 1;
+            uint32_t children[2];
+            int count = childrenOf(this->nodes[frame.id], children);
+            for(int i = count - 1; i >= 0; i--){
+                stack.push_back({children[i], NONE, NONE, 0});
+            }
+        }else if(frame.stage == 1){
+            Node node = this->nodes[frame.id];
+            uint32_t rebuilt = frame.id;
+            if(node.type != Formula::Type::PRED){
+                uint32_t left = this->normalForms[node.left];
+                uint32_t right = node.right;
+                if(node.type != Formula::Type::NOT && node.type != Formula::Type::FORALL &&
+                   node.type != Formula::Type::EXISTS){
+                    right = this->normalForms[node.right];
+                }
+                rebuilt = this->intern(node.type, left, right);
+            }
+            uint32_t normal = this->normalForms[rebuilt];
+            uint32_t result = NONE;
+            if(normal == NONE){
+                result = this->applyRules(rebuilt);
+                if(result == NONE){
+                    normal = rebuilt;
+                }else if(++steps > this->stepLimit){
+                    throw std::runtime_error("Rewriting exceeded the step limit");
+                }else{
+                    this->rewrites++;
+                    normal = this->normalForms[result];
+                }
+            }
+            if(normal != NONE){
+                this->normalForms[frame.id] = normal;
+                this->normalForms[rebuilt] = normal;
+                mark(frame.id, 0);
+                stack.pop_back();
+                continue;
+            }
+            mark(rebuilt, 1);
+            stack.back() = {frame.id, rebuilt, result, 2};
+            stack.push_back({result, NONE, NONE, 0});
+        }else{
+            uint32_t normal = this->normalForms[frame.result];
+            this->normalForms[frame.id] = normal;
+            this->normalForms[frame.rebuilt] = normal;
+            mark(frame.id, 0);
+            mark(frame.rebuilt, 0);
+            stack.pop_back();
+        }
+    }
+    return this->normalForms[root];
+}
+
+Formula* Rewriter::rewrite(const Formula* formula){
+    return this->toFormula(this->normalize(this->internFormula(formula)));
+}
+
+Formula* simplify(const Formula* formula){
+    Rewriter rewriter;
+    rewriter.addRules(DOUBLE_NEGATION_RULES);
+    rewriter.addRules(IDEMPOTENCE_RULES);
+    rewriter.addRules(ABSORPTION_RULES);
+    rewriter.addRules(CONSTANT_FOLDING_RULES);
+    return rewriter.rewrite(formula);
+}
@@ -12,7 +12,6 @@
 #include<cctype>
 #include<vector>
 #include<string>
-#include<unordered_set>
 
 #include "SExpression.hpp"
 
@@ -40,16 +39,20 @@ struct Token{
 };
 
 Token::Token(TokenType type_, std::string value_)
-:type(type_), value(value_)
+:type(type_), value(std::move(value_))
 {}
 
 //Tokenizer and Lexer Code =====================================================
 
 //Lexer Globals
 //Ignored characters when parsing 
-const std::unordered_set<char> ignoreChars({' ', '\t', '\n'});
+inline bool isIgnoreChar(char c){
+    return c == ' ' || c == '\t' || c == '\n';
+}
 //Tokens that end a previous token if encountered     
-const std::unordered_set<char> endingChars({' ', '(', ')', '\t', '\n'});   
+inline bool isEndingChar(char c){
+    return c == ' ' || c == '(' || c == ')' || c == '\t' || c == '\n';
+}
 
 //Lexer helper functions
 
@@ -88,7 +91,7 @@ inline void addKeyToken(const std::string& expressionString, int &i,
     //the expression string
     for(j = i+1; j<expressionString.length(); j++){
         char curKeyChar = expressionString[j];
-        if(endingChars.find(curKeyChar) != endingChars.end())
+        if(isEndingChar(curKeyChar))
             break;
         else
             tokenValue += curKeyChar;
@@ -108,7 +111,7 @@ inline void addNormalToken(const std::string& expressionString, int &i,
     for(j = i; j < expressionString.length(); j++){  
         char strCur = expressionString[j];
         //if we hit an ending char
-        if(endingChars.find(strCur) != endingChars.end()){ 
+        if(isEndingChar(strCur)){ 
             break;
         }else{
             numeric = numeric && isdigit(strCur);
@@ -146,7 +149,7 @@ std::vector<Token> lex(const std::string& expressionString){
             addStringToken(expressionString, i, tokens);
         }else if(curChar == ':'){                                      
             addKeyToken(expressionString, i, tokens);
-        }else if(ignoreChars.find(curChar) == ignoreChars.end()){  
+        }else if(!isIgnoreChar(curChar)){  
             //Both Symbols and Numbers
             addNormalToken(expressionString, i, tokens);
         }
@@ -157,105 +160,66 @@ std::vector<Token> lex(const std::string& expressionString){
 //Parser Code ==================================================================
 
 /**
- *   @brief A helper for the parser
- *   @param tokens the list of tokens to grab the sub expression from
- *   @param i the token index to begin grabbing the sub expression at
- *   @pre i must be the index of a left parenthesis expression. 
- *   Starting at position i, will grab a subexpression from the token array and
- *   move i to the position after the matching parenthesis. 
- *   ```
- *   For example:
- *       tokens = ( ...  (a (b c)) ...)
- *                       ^        ^
- *                       i        Ni
- *       then grabSubExpression returns (a (b c)) and changes i to position Ni 
- *   ```
+ * @brief Adds a finished S-Expression to the innermost open list, or makes it
+ * the result if no list is open.
+ * @throws std::runtime_error if a complete expression was already parsed
  */
-inline std::vector<Token> grabSubExpression(const std::vector<Token>& tokens,
-                                            int& i){
-    int parenthesisCounter = 1;
-    bool foundMatch = false;
-    size_t j;
-    //find the index of the closing parenthesis and store it in j
-    for(j = i+1; j < tokens.size()-1; j++){ 
-        if(tokens[j].type == TokenType::Right_Parenthesis && \
-           parenthesisCounter == 1){
-            foundMatch = true;
-            break;
-        }else if(tokens[j].type == TokenType::Right_Parenthesis){
-            parenthesisCounter--;
-        } else if(tokens[j].type == TokenType::Left_Parenthesis){
-            parenthesisCounter++;
-        }
-    }
-    if(foundMatch){
-        std::vector<Token> subExpressionTokens(
-            tokens.begin() + i,
-            tokens.begin() + j + 1
-        );
-        i = j;
-        return subExpressionTokens;
+inline void placeExpression(sExpression&& expression,
+                            std::vector<sExpression>& openLists,
+                            sExpression& result, bool& finished){
+    if(!openLists.empty()){
+        openLists.back().members.push_back(std::move(expression));
+    }else if(finished){
+        throw std::runtime_error("S-Expression parsing error: unexpected "
+                                 "tokens after the end of the expression");
     }else{
-        throw std::runtime_error("S-Expression parsing error: "
-                                 "could not find matching parenthesis");
-    }
-}
-
-
-inline void parserBaseCase(const std::vector<Token>& tokens,
-                           sExpression& expression){
-    Token token = tokens[0];
-    //Make sure the token type is also a valid s-expression type
-    if(!(token.type >= TokenType::Keyword && token.type <= TokenType::Symbol)){ 
-        throw std::runtime_error("S-Expression parsing error: invalid token"
-              " type for conversion " + std::to_string((int)token.type));
-    }
-    expression.type = static_cast<sExpression::Type>(token.type);
-    expression.value = token.value;
-}
-
-sExpression parseTokens(const std::vector<Token>& tokens);
-
-inline void parserRecursiveCase(const std::vector<Token>& tokens,
-                                sExpression& expression){
-    if(tokens[0].type != TokenType::Left_Parenthesis ||
-        tokens[tokens.size()-1].type != TokenType::Right_Parenthesis
-    ){
-        throw std::runtime_error("S-Expression parsing error: Expected list to"
-                                 "be wrapped by Parenthesis");
-    }
-    expression.type = sExpression::Type::List;
-    expression.members = std::vector<sExpression>();
-    std::vector<Token> subTokens;
-    for(int i = 1; static_cast<size_t>(i) < tokens.size()-1; i++){
-        if(tokens[i].type == TokenType::Left_Parenthesis){
-            subTokens = grabSubExpression(tokens, i);
-        }else{
-            subTokens.clear();
-            subTokens.push_back(tokens[i]);
-        }
-        sExpression child = parseTokens(subTokens);
-        expression.members.push_back(child);
+        result = std::move(expression);
+        finished = true;
     }
 }
 
 // Parser ======================================================================
 
-//Recursive s-expression parser
+/**
+ * @brief Parses a token list into an s-expression in a single pass.
+ * @details Lists that have been opened but not yet closed are kept on an 
+ * explicit stack rather than the call stack, so arbitrarily deep expressions
+ * can be parsed.
+ */
 sExpression parseTokens(const std::vector<Token>& tokens){
-    sExpression expression; 
     if(tokens.size() == 0){
         throw std::runtime_error(
             "S-Expression parsing error: Nothing to parse"
         );
-    }else if(tokens.size() == 1){     
-        //Base case, only passing a list with a single token  
-        parserBaseCase(tokens, expression); 
-    }else{
-        //Recursive case, passing token list                                  
-        parserRecursiveCase(tokens, expression); 
     }
-    return expression;
+    sExpression result;
+    bool finished = false;
+    std::vector<sExpression> openLists;
+    for(const Token& token : tokens){
+        if(token.type == TokenType::Left_Parenthesis){
+            openLists.emplace_back();
+            openLists.back().type = sExpression::Type::List;
+        }else if(token.type == TokenType::Right_Parenthesis){
+            if(openLists.empty()){
+                throw std::runtime_error("S-Expression parsing error: "
+                                         "unmatched closing parenthesis");
+            }
+            sExpression list = std::move(openLists.back());
+            openLists.pop_back();
+            placeExpression(std::move(list), openLists, result, finished);
+        }else{
+            //Atom token types map directly onto s-expression types
+            sExpression atom;
+            atom.type = static_cast<sExpression::Type>(token.type);
+            atom.value = token.value;
+            placeExpression(std::move(atom), openLists, result, finished);
+        }
+    }
+    if(!openLists.empty()){
+        throw std::runtime_error("S-Expression parsing error: "
+                                 "could not find matching parenthesis");
+    }
+    return result;
 }
 
 //sExpression members ==========================================================
@@ -265,12 +229,12 @@ sExpression::sExpression()
 }
 
 //Initialize this s-expression object from an s-expression string
-sExpression::sExpression(const std::string sExpressionString){
+sExpression::sExpression(const std::string& sExpressionString){
     std::vector<Token> tokens = lex(sExpressionString);
     *this = parseTokens(tokens);
 }
 
-sExpression::sExpression(const sExpression&& expression){
+sExpression::sExpression(sExpression&& expression) noexcept{
     *this = std::move(expression);
 }
 
@@ -279,9 +243,24 @@ sExpression::sExpression(const sExpression& expression){
 }
 
 sExpression::~sExpression(){
+    if(members.empty()){
+        return;
+    }
+    //Flatten nested lists onto an explicit stack so destroying a deep 
+    //expression does not recurse through every level
+    std::vector<sExpression> stack = std::move(members);
+    members.clear();
+    while(!stack.empty()){
+        sExpression expression = std::move(stack.back());
+        stack.pop_back();
+        for(sExpression& member : expression.members){
+            stack.push_back(std::move(member));
+        }
+        expression.members.clear();
+    }
 }
 
-sExpression& sExpression::operator=(const sExpression&& expression){
+sExpression& sExpression::operator=(sExpression&& expression) noexcept{
     type = expression.type;
     if(expression.type == sExpression::Type::List)
         members = std::move(expression.members);
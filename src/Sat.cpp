@@ -0,0 +1,524 @@
+
+#include<vector>
+#include<cstdlib>
+#include<utility>
+#include<algorithm>
+
+#include "Sat.hpp"
+
+constexpr uint8_t VALUE_FALSE = 0;
+constexpr uint8_t VALUE_TRUE = 1;
+constexpr uint8_t VALUE_UNDEF = 2;
+
+inline SatSolver::Lit toLit(int literal){
+    return 2 * (std::abs(literal) - 1) + (literal < 0);
+}
+
+inline uint32_t variableOf(SatSolver::Lit literal){
+    return literal >> 1;
+}
+
+/**
+ * The Luby sequence 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ..., scales the number of
+ * conflicts between restarts.
+*/
+size_t luby(size_t i){
+    size_t size = 1;
+    size_t sequence = 0;
+    while(size < i + 1){
+        sequence++;
+        size = 2 * size + 1;
+    }
+    while(size - 1 != i){
+        size = (size - 1) >> 1;
+        sequence--;
+        i = i % size;
+    }
+    return (size_t)1 << sequence;
+}
+
+// Interface ===================================================================
+
+SatSolver::SatSolver(const ClauseSet& clauses){
+    this->addClauses(clauses);
+}
+
+void SatSolver::addClauses(const ClauseSet& clauses){
+    this->ensureVariables(clauses.variables());
+    for(size_t i = 0; i < clauses.size(); i++){
+        this->addClause(clauses.clause(i));
+    }
+}
+
+bool SatSolver::addClause(std::span<const int> clause){
+    if(this->inconsistent){
+        return false;
+    }
+    std::vector<Lit> literals;
+    literals.reserve(clause.size());
+    for(int literal : clause){
+        this->ensureVariables(std::abs(literal));
+        literals.push_back(toLit(literal));
+    }
+    //Clauses are only added at the root level, drop false literals and
+    //clauses that are already satisfied or tautological
+    std::sort(literals.begin(), literals.end());
+    size_t kept = 0;
+    for(size_t i = 0; i < literals.size(); i++){
+        Lit literal = literals[i];
+        if(this->values[literal] == VALUE_TRUE || (kept > 0 && literals[kept - 1] == (literal ^ 1))){
+            return true;
+        }
+        if(this->values[literal] != VALUE_FALSE && (kept == 0 || literals[kept - 1] != literal)){
+            literals[kept++] = literal;
+        }
+    }
+    literals.resize(kept);
+
+    if(literals.size() == 0){
+        this->inconsistent = true;
+        return false;
+    }
+    if(literals.size() == 1){
+        this->enqueue(literals[0], NO_CLAUSE);
+        return true;
+    }
+    this->clauses.push_back(Clause{std::move(literals)});
+    this->attach(this->clauses.size() - 1);
+    return true;
+}
+
+SatResult SatSolver::solve(size_t conflictLimit){
+    if(this->inconsistent){
+        return SatResult::UNSAT;
+    }
+    if(this->propagate() != NO_CLAUSE){
+        this->inconsistent = true;
+        return SatResult::UNSAT;
+    }
+    this->maxLearnts = std::max(this->maxLearnts, this->clauses.size() / 3.0 + 100);
+    for(size_t restarts = 0; ; restarts++){
+        SatResult result = this->search(luby(restarts) * 100, conflictLimit);
+        if(result != SatResult::UNKNOWN || (conflictLimit != 0 && this->conflicts >= conflictLimit)){
+            return result;
+        }
+    }
+}
+
+bool SatSolver::value(int variable) const{
+    return this->model[variable - 1] == VALUE_TRUE;
+}
+
+size_t SatSolver::variables() const{
+    return this->levels.size();
+}
+
+// Search ======================================================================
+
+void SatSolver::ensureVariables(size_t count){
+    size_t old = this->variables();
+    if(count <= old){
+        return;
+    }
+    this->watches.resize(2 * count);
+    this->values.resize(2 * count, VALUE_UNDEF);
+    this->levels.resize(count, 0);
+    this->reasons.resize(count, NO_CLAUSE);
+    this->activity.resize(count, 0);
+    this->heapIndex.resize(count, UINT32_MAX);
+    //Branch negatively first, like most solvers
+    this->phases.resize(count, 1);
+    this->seen.resize(count, 0);
+    for(uint32_t v = old; v < count; v++){
+        this->heapInsert(v);
+    }
+}
+
+void SatSolver::attach(uint32_t clause){
+    const std::vector<Lit>& literals = this->clauses[clause].literals;
+    this->watches[literals[0]].push_back({clause, literals[1]});
+    this->watches[literals[1]].push_back({clause, literals[0]});
+}
+
+uint32_t SatSolver::decisionLevel() const{
+    return this->trailLimits.size();
+}
+
+void SatSolver::enqueue(Lit literal, uint32_t reason){
+    uint32_t variable = variableOf(literal);
+    this->values[literal] = VALUE_TRUE;
+    this->values[literal ^ 1] = VALUE_FALSE;
+    this->levels[variable] = this->decisionLevel();
+    this->reasons[variable] = reason;
+    this->trail.push_back(literal);
+}
+
+/**
+ * Propagates every literal on the trail, visiting only the clauses watching
+ * the literals made false.
+ * @return the index of a conflicting clause or NO_CLAUSE
+*/
+uint32_t SatSolver::propagate(){
+    uint32_t conflict = NO_CLAUSE;
+    while(this->propagated < this->trail.size() && conflict == NO_CLAUSE){
+        Lit falseLit = this->trail[this->propagated++] ^ 1;
+        this->propagations++;
+        std::vector<Watcher>& watchers = this->watches[falseLit];
+        size_t i = 0, j = 0;
+        while(i < watchers.size()){
+            Watcher watcher = watchers[i++];
+            //The clause is satisfied by the blocker, no need to look at it
+            if(this->values[watcher.blocker] == VALUE_TRUE){
+                watchers[j++] = watcher;
+                continue;
+            }
+            std::vector<Lit>& literals = this->clauses[watcher.clause].literals;
+            //Keep the false literal in position 1
+            if(literals[0] == falseLit){
+                std::swap(literals[0], literals[1]);
+            }
+            Lit first = literals[0];
+            if(first != watcher.blocker && this->values[first] == VALUE_TRUE){
+                watchers[j++] = {watcher.clause, first};
+                continue;
+            }
+            //Look for a new literal to watch
+            bool moved = false;
+            for(size_t k = 2; k < literals.size(); k++){
+                if(this->values[literals[k]] != VALUE_FALSE){
+                    std::swap(literals[1], literals[k]);
+                    this->watches[literals[1]].push_back({watcher.clause, first});
+                    moved = true;
+                    break;
+                }
+            }
+            if(moved){
+                continue;
+            }
+            //The clause is unit or conflicting
+            watchers[j++] = {watcher.clause, first};
+            if(this->values[first] == VALUE_FALSE){
+                conflict = watcher.clause;
+                while(i < watchers.size()){
+                    watchers[j++] = watchers[i++];
+                }
+            }else{
+                this->enqueue(first, watcher.clause);
+            }
+        }
+        watchers.resize(j);
+    }
+    return conflict;
+}
+
+/**
+ * First UIP conflict analysis, the asserting literal is placed first in the
+ * learnt clause and a literal of the backtrack level second.
+*/
+void SatSolver::analyze(uint32_t conflict, std::vector<Lit>& learnt, uint32_t& backtrackLevel){
+    learnt.clear();
+    learnt.push_back(0);
+    size_t pathCount = 0;
+    bool first = true;
+    Lit uip = 0;
+    size_t index = this->trail.size();
+    do{
+        Clause& clause = this->clauses[conflict];
+        if(clause.learnt){
+            this->bumpClause(clause);
+        }
+        //The implied literal of a reason clause is in position 0
+        for(size_t k = first ? 0 : 1; k < clause.literals.size(); k++){
+            Lit literal = clause.literals[k];
+            uint32_t variable = variableOf(literal);
+            if(!this->seen[variable] && this->levels[variable] > 0){
+                this->bumpVariable(variable);
+                this->seen[variable] = 1;
+                if(this->levels[variable] >= this->decisionLevel()){
+                    pathCount++;
+                }else{
+                    learnt.push_back(literal);
+                }
+            }
+        }
+        first = false;
+        //Walk back to the next marked literal of the conflict level
+        while(!this->seen[variableOf(this->trail[--index])]);
+        uip = this->trail[index];
+        conflict = this->reasons[variableOf(uip)];
+        this->seen[variableOf(uip)] = 0;
+        pathCount--;
+    }while(pathCount > 0);
+    learnt[0] = uip ^ 1;
+
+    //Drop literals implied by other literals of the clause
+    this->analyzeClear.assign(learnt.begin() + 1, learnt.end());
+    size_t kept = 1;
+    for(size_t i = 1; i < learnt.size(); i++){
+        uint32_t reason = this->reasons[variableOf(learnt[i])];
+        bool redundant = reason != NO_CLAUSE;
+        if(redundant){
+            const std::vector<Lit>& literals = this->clauses[reason].literals;
+            for(size_t k = 1; k < literals.size(); k++){
+                uint32_t variable = variableOf(literals[k]);
+                if(!this->seen[variable] && this->levels[variable] > 0){
+                    redundant = false;
+                    break;
+                }
+            }
+        }
+        if(!redundant){
+            learnt[kept++] = learnt[i];
+        }
+    }
+    learnt.resize(kept);
+    for(Lit literal : this->analyzeClear){
+        this->seen[variableOf(literal)] = 0;
+    }
+
+    backtrackLevel = 0;
+    if(learnt.size() > 1){
+        size_t highest = 1;
+        for(size_t i = 2; i < learnt.size(); i++){
+            if(this->levels[variableOf(learnt[i])] > this->levels[variableOf(learnt[highest])]){
+                highest = i;
+            }
+        }
+        std::swap(learnt[1], learnt[highest]);
+        backtrackLevel = this->levels[variableOf(learnt[1])];
+    }
+}
+
+void SatSolver::backtrack(uint32_t level){
+    if(this->decisionLevel() <= level){
+        return;
+    }
+    size_t limit = this->trailLimits[level];
+    for(size_t i = this->trail.size(); i-- > limit;){
+        Lit literal = this->trail[i];
+        uint32_t variable = variableOf(literal);
+        this->values[literal] = VALUE_UNDEF;
+        this->values[literal ^ 1] = VALUE_UNDEF;
+        this->reasons[variable] = NO_CLAUSE;
+        this->phases[variable] = literal & 1;
+        this->heapInsert(variable);
+    }
+    this->trail.resize(limit);
+    this->trailLimits.resize(level);
+    this->propagated = limit;
+}
+
+SatResult SatSolver::search(size_t restartConflicts, size_t conflictLimit){
+    std::vector<Lit> learnt;
+    size_t restartConflictCount = 0;
+    while(true){
+        uint32_t conflict = this->propagate();
+        if(conflict != NO_CLAUSE){
+            this->conflicts++;
+            restartConflictCount++;
+            if(this->decisionLevel() == 0){
+                this->inconsistent = true;
+                return SatResult::UNSAT;
+            }
+            uint32_t backtrackLevel;
+            this->analyze(conflict, learnt, backtrackLevel);
+            this->backtrack(backtrackLevel);
+            if(learnt.size() == 1){
+                this->enqueue(learnt[0], NO_CLAUSE);
+            }else{
+                this->clauses.push_back(Clause{learnt, true});
+                uint32_t index = this->clauses.size() - 1;
+                this->learnts.push_back(index);
+                this->attach(index);
+                this->bumpClause(this->clauses[index]);
+                this->enqueue(learnt[0], index);
+            }
+            //Decay by growing the increments
+            this->variableIncrement /= 0.95;
+            this->clauseIncrement /= 0.999;
+            //Let the learnt clause database grow geometrically slower over time
+            if(--this->learntAdjustCountdown == 0){
+                this->learntAdjustConflicts *= 1.5;
+                this->learntAdjustCountdown = this->learntAdjustConflicts;
+                this->maxLearnts *= 1.1;
+            }
+
+            if(restartConflictCount >= restartConflicts ||
+               (conflictLimit != 0 && this->conflicts >= conflictLimit)){
+                this->backtrack(0);
+                return SatResult::UNKNOWN;
+            }
+        }else{
+            if(this->learnts.size() >= this->maxLearnts + this->trail.size()){
+                this->reduceLearnts();
+            }
+            //Pick the most active unassigned variable with its saved phase
+            uint32_t variable = UINT32_MAX;
+            while(!this->heap.empty()){
+                uint32_t candidate = this->heapPop();
+                if(this->values[2 * candidate] == VALUE_UNDEF){
+                    variable = candidate;
+                    break;
+                }
+            }
+            if(variable == UINT32_MAX){
+                //Every variable is assigned without conflict
+                this->model.resize(this->variables());
+                for(uint32_t v = 0; v < this->variables(); v++){
+                    this->model[v] = this->values[2 * v];
+                }
+                this->backtrack(0);
+                return SatResult::SAT;
+            }
+            this->decisions++;
+            this->trailLimits.push_back(this->trail.size());
+            this->enqueue(2 * variable + this->phases[variable], NO_CLAUSE);
+        }
+    }
+}
+
+// Learnt Clause Database ======================================================
+
+void SatSolver::bumpClause(Clause& clause){
+    clause.activity += this->clauseIncrement;
+    if(clause.activity > 1e20){
+        for(uint32_t index : this->learnts){
+            this->clauses[index].activity *= 1e-20;
+        }
+        this->clauseIncrement *= 1e-20;
+    }
+}
+
+bool SatSolver::locked(uint32_t clause) const{
+    Lit first = this->clauses[clause].literals[0];
+    return this->values[first] == VALUE_TRUE && this->reasons[variableOf(first)] == clause;
+}
+
+/**
+ * Deletes the less active half of the learnt clauses, except binary clauses
+ * and the reasons of current assignments.
+*/
+void SatSolver::reduceLearnts(){
+    std::sort(this->learnts.begin(), this->learnts.end(), [this](uint32_t a, uint32_t b){
+        return this->clauses[a].activity < this->clauses[b].activity;
+    });
+    size_t half = this->learnts.size() / 2;
+    size_t kept = 0;
+    for(size_t i = 0; i < this->learnts.size(); i++){
+        Clause& clause = this->clauses[this->learnts[i]];
+        if(i < half && clause.literals.size() > 2 && !this->locked(this->learnts[i])){
+            clause.deleted = true;
+            clause.literals = std::vector<Lit>();
+        }else{
+            this->learnts[kept++] = this->learnts[i];
+        }
+    }
+    this->learnts.resize(kept);
+    for(std::vector<Watcher>& watchers : this->watches){
+        std::erase_if(watchers, [this](const Watcher& w){ return this->clauses[w.clause].deleted; });
+    }
+}
+
+// VSIDS =======================================================================
+
+void SatSolver::bumpVariable(uint32_t variable){
+    this->activity[variable] += this->variableIncrement;
+    if(this->activity[variable] > 1e100){
+        for(double& a : this->activity){
+            a *= 1e-100;
+        }
+        this->variableIncrement *= 1e-100;
+    }
+    if(this->heapIndex[variable] != UINT32_MAX){
+        this->heapUp(this->heapIndex[variable]);
+    }
+}
+
+void SatSolver::heapInsert(uint32_t variable){
+    if(this->heapIndex[variable] != UINT32_MAX){
+        return;
+    }
+    this->heapIndex[variable] = this->heap.size();
+    this->heap.push_back(variable);
+    this->heapUp(this->heap.size() - 1);
+}
+
+void SatSolver::heapUp(size_t i){
+    uint32_t variable = this->heap[i];
+    while(i > 0){
+        size_t parent = (i - 1) / 2;
+        if(this->activity[this->heap[parent]] >= this->activity[variable]){
+            break;
+        }
+        this->heap[i] = this->heap[parent];
+        this->heapIndex[this->heap[i]] = i;
+        i = parent;
+    }
+    this->heap[i] = variable;
+    this->heapIndex[variable] = i;
+}
+
+void SatSolver::heapDown(size_t i){
+    uint32_t variable = this->heap[i];
+    while(2 * i + 1 < this->heap.size()){
+        size_t child = 2 * i + 1;
+        if(child + 1 < this->heap.size() &&
+           this->activity[this->heap[child + 1]] > this->activity[this->heap[child]]){
+            child++;
+        }
+        if(this->activity[this->heap[child]] <= this->activity[variable]){
+            break;
+        }
+        this->heap[i] = this->heap[child];
+        this->heapIndex[this->heap[i]] = i;
+        i = child;
+    }
+    this->heap[i] = variable;
+    this->heapIndex[variable] = i;
+}
+
+uint32_t SatSolver::heapPop(){
+    uint32_t top = this->heap[0];
+    this->heapIndex[top] = UINT32_MAX;
+    uint32_t last = this->heap.back();
+    this->heap.pop_back();
+    if(!this->heap.empty()){
+        this->heap[0] = last;
+        this->heapIndex[last] = 0;
+        this->heapDown(0);
+    }
+    return top;
+}
+
+// Formula Checks ==============================================================
+
+bool entails(const FormulaList& premises, const Formula* conclusion){
+    Tseitin tseitin;
+    std::vector<int> units;
+    for(const Formula* premise : premises){
+        units.push_back(tseitin.define(premise));
+    }
+    //The premises entail the conclusion iff they can't hold without it
+    units.push_back(-tseitin.define(conclusion));
+    for(int unit : units){
+        tseitin.clauses.addClause({unit});
+    }
+    SatSolver solver(tseitin.clauses);
+    return solver.solve() == SatResult::UNSAT;
+}
+
+bool entails(const Formula* premise, const Formula* conclusion){
+    return entails(FormulaList{(Formula*)premise}, conclusion);
+}
+
+bool isTautology(const Formula* formula){
+    return entails(FormulaList{}, formula);
+}
+
+bool equivalent(const Formula* a, const Formula* b){
+    Tseitin tseitin;
+    int iff = tseitin.connective(Formula::Type::IFF, tseitin.define(a), tseitin.define(b));
+    tseitin.clauses.addClause({-iff});
+    SatSolver solver(tseitin.clauses);
+    return solver.solve() == SatResult::UNSAT;
+}
@@ -0,0 +1,718 @@
+
+#include<array>
+#include<cctype>
+#include<string>
+#include<vector>
+#include<sstream>
+#include<utility>
+#include<algorithm>
+#include<cstdint>
+#include<stdexcept>
+
+#include "TPTP.hpp"
+#include "FormulaVisitor.hpp"
+
+using Token = TPTPReader::Token;
+
+/** Character classes of the lexer, without the locale lookups of <cctype> */
+constexpr uint8_t WORD_CHAR = 1, SPACE_CHAR = 2;
+constexpr auto CHAR_CLASSES = [](){
+    std::array<uint8_t, 256> rv{};
+    for(int c = 0; c < 256; c++){
+        if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'){
+            rv[c] = WORD_CHAR;
+        }else if(c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'){
+            rv[c] = SPACE_CHAR;
+        }
+    }
+    return rv;
+}();
+
+inline bool isWordChar(int c){
+    return c >= 0 && CHAR_CLASSES[c] == WORD_CHAR;
+}
+
+inline bool isDigit(int c){
+    return c >= '0' && c <= '9';
+}
+
+inline bool isSpaceChar(int c){
+    return c >= 0 && CHAR_CLASSES[c] == SPACE_CHAR;
+}
+
+/**
+ * @return the length of the run of characters satisfying a predicate
+ * starting offset characters ahead, reading more input as needed.
+*/
+template<typename Predicate>
+size_t scanWhile(TPTPReader& reader, size_t offset, Predicate predicate){
+    for(;;){
+        size_t i = reader.position + offset;
+        while(i < reader.buffer.size() && predicate((unsigned char)reader.buffer[i])){
+            i++;
+        }
+        offset = i - reader.position;
+        //Stop at the first other character or the end of the input
+        if(i < reader.buffer.size() || reader.peek(offset) == -1){
+            return offset;
+        }
+    }
+}
+
+// Lexer =======================================================================
+
+TPTPReader::TPTPReader(std::istream& input, size_t chunkSize)
+:input(input), chunkSize(std::max<size_t>(chunkSize, 1))
+{
+    this->lex();
+}
+
+void TPTPReader::error(const std::string& message) const{
+    throw std::runtime_error("TPTP parse error on line " + std::to_string(this->tokenLine) + ": " + message);
+}
+
+/** @return the character ahead of the current one, or -1 past the end of the input */
+inline int TPTPReader::peek(size_t ahead){
+    if(this->position + ahead < this->buffer.size()){
+        return (unsigned char)this->buffer[this->position + ahead];
+    }
+    return this->refill(ahead);
+}
+
+int TPTPReader::refill(size_t ahead){
+    while(this->position + ahead >= this->buffer.size()){
+        //Drop the consumed prefix before reading the next chunk
+        this->buffer.erase(0, this->position);
+        this->position = 0;
+        size_t size = this->buffer.size();
+        this->buffer.resize(size + this->chunkSize);
+        this->input.read(&this->buffer[size], this->chunkSize);
+        this->buffer.resize(size + this->input.gcount());
+        if(this->input.gcount() == 0){
+            return -1;
+        }
+    }
+    return (unsigned char)this->buffer[this->position + ahead];
+}
+
+void TPTPReader::advance(size_t count){
+    const char* start = this->buffer.data() + this->position;
+    this->line += std::count(start, start + count, '\n');
+    this->position += count;
+    this->bytes += count;
+}
+
+void TPTPReader::lex(){
+    //Skip whitespace and comments
+    int c = this->peek();
+    while(c != -1){
+        if(isSpaceChar(c)){
+            this->advance(scanWhile(*this, 0, isSpaceChar));
+        }else if(c == '%'){
+            this->advance(scanWhile(*this, 0, [](int w){ return w != '\n'; }));
+        }else if(c == '/' && this->peek(1) == '*'){
+            this->tokenLine = this->line;
+            this->advance(2);
+            while(!(this->peek() == '*' && this->peek(1) == '/')){
+                if(this->peek() == -1){
+                    this->error("unterminated comment");
+                }
+                this->advance();
+            }
+            this->advance(2);
+        }else{
+            break;
+        }
+        c = this->peek();
+    }
+
+    this->tokenLine = this->line;
+    this->text.clear();
+    auto word = [this](Token kind){
+        size_t length = scanWhile(*this, 0, isWordChar);
+        this->text.append(this->buffer, this->position, length);
+        this->advance(length);
+        this->token = kind;
+    };
+    auto punctuation = [this](Token kind, size_t length){
+        this->text.assign(this->buffer, this->position, length);
+        this->advance(length);
+        this->token = kind;
+    };
+
+    if(c == -1){
+        this->token = Token::END;
+    }else if(c >= 'a' && c <= 'z'){
+        word(Token::LOWER_WORD);
+    }else if(c >= 'A' && c <= 'Z'){
+        word(Token::UPPER_WORD);
+    }else if(c == '$'){
+        this->text += '$';
+        this->advance();
+        if(this->peek() == '$'){
+            this->text += '$';
+            this->advance();
+        }
+        word(Token::DOLLAR_WORD);
+    }else if(isDigit(c) || ((c == '+' || c == '-') && isDigit(this->peek(1)))){
+        //Integers, rationals and reals are all kept as their text
+        this->text += (char)c;
+        this->advance();
+        auto digits = [this](){
+            size_t length = scanWhile(*this, 0, isDigit);
+            this->text.append(this->buffer, this->position, length);
+            this->advance(length);
+        };
+        digits();
+        if((this->peek() == '.' || this->peek() == '/') && isDigit(this->peek(1))){
+            this->text += (char)this->peek();
+            this->advance();
+            digits();
+        }
+        if((this->peek() == 'e' || this->peek() == 'E') &&
+           (isDigit(this->peek(1)) || ((this->peek(1) == '+' || this->peek(1) == '-') && isDigit(this->peek(2))))){
+            this->text += (char)this->peek();
+            this->text += (char)this->peek(1);
+            this->advance(2);
+            digits();
+        }
+        this->token = Token::NUMBER;
+    }else if(c == '\'' || c == '"'){
+        this->advance();
+        for(;;){
+            size_t length = scanWhile(*this, 0, [c](int q){ return q != c && q != '\\'; });
+            this->text.append(this->buffer, this->position, length);
+            this->advance(length);
+            int q = this->peek();
+            if(q == c){
+                break;
+            }else if(q == -1 || this->peek(1) == -1){
+                this->error("unterminated quoted name");
+            }
+            //Backslashes escape the next character
+            this->text += (char)this->peek(1);
+            this->advance(2);
+        }
+        this->advance();
+        this->token = c == '"' ? Token::DISTINCT : Token::QUOTED;
+    }else{
+        switch(c){
+            case '(': punctuation(Token::LEFT_PAREN, 1); break;
+            case ')': punctuation(Token::RIGHT_PAREN, 1); break;
+            case '[': punctuation(Token::LEFT_BRACKET, 1); break;
+            case ']': punctuation(Token::RIGHT_BRACKET, 1); break;
+            case ',': punctuation(Token::COMMA, 1); break;
+            case ':': punctuation(Token::COLON, 1); break;
+            case '.': punctuation(Token::PERIOD, 1); break;
+            case '&': punctuation(Token::AND, 1); break;
+            case '|': punctuation(Token::OR, 1); break;
+            case '?': punctuation(Token::EXISTS, 1); break;
+            case '~':
+                if(this->peek(1) == '|'){
+                    punctuation(Token::NOR, 2);
+                }else if(this->peek(1) == '&'){
+                    punctuation(Token::NAND, 2);
+                }else{
+                    punctuation(Token::NOT, 1);
+                }
+                break;
+            case '=':
+                if(this->peek(1) == '>'){
+                    punctuation(Token::IF, 2);
+                }else{
+                    punctuation(Token::EQUALS, 1);
+                }
+                break;
+            case '!':
+                if(this->peek(1) == '='){
+                    punctuation(Token::NOT_EQUALS, 2);
+                }else{
+                    punctuation(Token::FORALL, 1);
+                }
+                break;
+            case '<':
+                if(this->peek(1) == '=' && this->peek(2) == '>'){
+                    punctuation(Token::IFF, 3);
+                    break;
+                }else if(this->peek(1) == '='){
+                    punctuation(Token::IF_REVERSED, 2);
+                    break;
+                }else if(this->peek(1) == '~' && this->peek(2) == '>'){
+                    punctuation(Token::XOR, 3);
+                    break;
+                }
+                [[fallthrough]];
+            default:
+                this->error(std::string("unexpected character '") + (char)c + "'");
+        }
+    }
+}
+
+void TPTPReader::expect(Token expected, const char* description){
+    if(this->token != expected){
+        this->error(std::string("expected ") + description + " but found '" + this->text + "'");
+    }
+    this->lex();
+}
+
+// Parser ======================================================================
+
+Term* TPTPReader::parseTerm(){
+    pTerm root;
+    //Terms whose argument lists are still open
+    std::vector<Term*> open;
+    for(;;){
+        Token kind = this->token;
+        if(kind != Token::LOWER_WORD && kind != Token::UPPER_WORD && kind != Token::DOLLAR_WORD &&
+           kind != Token::QUOTED && kind != Token::DISTINCT && kind != Token::NUMBER){
+            this->error("expected a term but found '" + this->text + "'");
+        }
+        Term* term = new Term;
+        if(open.empty()){
+            root.reset(term);
+        }else{
+            open.back()->args.push_back(term);
+        }
+        term->name = this->text;
+        if(kind == Token::UPPER_WORD && this->collectVariables &&
+           std::find(this->freeVariables.begin(), this->freeVariables.end(), term->name) == this->freeVariables.end()){
+            this->freeVariables.push_back(term->name);
+        }
+        this->lex();
+        if(this->token == Token::LEFT_PAREN && kind != Token::UPPER_WORD){
+            this->lex();
+            open.push_back(term);
+            continue;
+        }
+        //Close every argument list this term ends
+        while(!open.empty() && this->token != Token::COMMA){
+            this->expect(Token::RIGHT_PAREN, "',' or ')'");
+            open.pop_back();
+        }
+        if(open.empty()){
+            return root.release();
+        }
+        this->lex();
+    }
+}
+
+Formula* TPTPReader::parseAtom(){
+    if(this->token == Token::DOLLAR_WORD && (this->text == "$true" || this->text == "$false")){
+        Formula* rv = Prop(this->text.substr(1));
+        this->lex();
+        return rv;
+    }
+    bool variable = this->token == Token::UPPER_WORD;
+    pTerm left (this->parseTerm());
+    if(this->token == Token::EQUALS || this->token == Token::NOT_EQUALS){
+        bool negated = this->token == Token::NOT_EQUALS;
+        this->lex();
+        Term* right = this->parseTerm();
+        Formula* rv = Pred("eq", {left.release(), right});
+        return negated ? Not(rv) : rv;
+    }
+    if(variable){
+        this->error("the variable " + left->name + " is used as a formula");
+    }
+    return Pred(std::move(left->name), std::move(left->args));
+}
+
+/** @return the formula for a binary connective token */
+Formula* combine(Token op, Formula* left, Formula* right){
+    switch(op){
+        case Token::AND: return And(left, right);
+        case Token::OR: return Or(left, right);
+        case Token::IF: return If(left, right);
+        case Token::IF_REVERSED: return If(right, left);
+        case Token::IFF: return Iff(left, right);
+        case Token::XOR: return Not(Iff(left, right));
+        case Token::NOR: return Not(Or(left, right));
+        default: return Not(And(left, right));
+    }
+}
+
+inline bool isBinaryConnective(Token token){
+    return token >= Token::AND && token <= Token::NAND;
+}
+
+/**
+ * Parses a formula with an explicit stack. Prefix operators (negations and
+ * quantifiers) wait on the stack for their unitary formula, parentheses and
+ * the formula itself are contexts folding their operands as they are read.
+*/
+Formula* TPTPReader::parseFormula(){
+    struct Frame{
+        Token kind;                         ///< NOT, FORALL, EXISTS, LEFT_PAREN or END for the root
+        std::vector<std::string> variables = {};
+        pFormula left = nullptr;            ///< the operands folded so far
+        Token op = Token::END;              ///< the connective waiting on its right operand
+        Token chain = Token::END;           ///< the connective of this context, if any
+    };
+    std::vector<Frame> stack;
+    stack.reserve(16);
+    stack.push_back({Token::END});
+    for(;;){
+        //Read prefix operators up to a unitary formula
+        if(this->token == Token::NOT){
+            stack.push_back({Token::NOT});
+            this->lex();
+            continue;
+        }
+        if(this->token == Token::FORALL || this->token == Token::EXISTS){
+            Frame quantifier{this->token};
+            this->lex();
+            this->expect(Token::LEFT_BRACKET, "'['");
+            for(;;){
+                if(this->token != Token::UPPER_WORD){
+                    this->error("expected a variable but found '" + this->text + "'");
+                }
+                quantifier.variables.push_back(this->text);
+                this->lex();
+                if(this->token != Token::COMMA){
+                    break;
+                }
+                this->lex();
+            }
+            this->expect(Token::RIGHT_BRACKET, "']'");
+            this->expect(Token::COLON, "':'");
+            stack.push_back(std::move(quantifier));
+            continue;
+        }
+        if(this->token == Token::LEFT_PAREN){
+            stack.push_back({Token::LEFT_PAREN});
+            this->lex();
+            continue;
+        }
+        pFormula unit (this->parseAtom());
+
+        //Reduce until a connective needs another operand
+        for(;;){
+            while(stack.back().kind == Token::NOT || stack.back().kind == Token::FORALL ||
+                  stack.back().kind == Token::EXISTS){
+                Frame& prefix = stack.back();
+                if(prefix.kind == Token::NOT){
+                    unit = pFormula(Not(unit.release()));
+                }
+                for(auto itr = prefix.variables.rbegin(); itr != prefix.variables.rend(); itr++){
+                    unit = pFormula(prefix.kind == Token::FORALL ? Forall(*itr, unit.release()) :
+                                                                   Exists(*itr, unit.release()));
+                }
+                stack.pop_back();
+            }
+            Frame& context = stack.back();
+            if(context.op != Token::END){
+                unit = pFormula(combine(context.op, context.left.release(), unit.release()));
+                context.op = Token::END;
+            }
+            context.left = std::move(unit);
+            if(isBinaryConnective(this->token)){
+                //Only & and | chain without parentheses
+                if(context.chain != Token::END && (context.chain != this->token ||
+                   (this->token != Token::AND && this->token != Token::OR))){
+                    this->error("connectives '" + this->text + "' must be parenthesized");
+                }
+                context.op = context.chain = this->token;
+                this->lex();
+                break;
+            }
+            if(context.kind == Token::END){
+                return context.left.release();
+            }
+            this->expect(Token::RIGHT_PAREN, "a connective or ')'");
+            unit = std::move(context.left);
+            stack.pop_back();
+        }
+    }
+}
+
+void TPTPReader::skipAnnotations(){
+    size_t depth = 0;
+    while(depth > 0 || this->token != Token::RIGHT_PAREN){
+        if(this->token == Token::END){
+            this->error("unterminated annotations");
+        }
+        if(this->token == Token::LEFT_PAREN || this->token == Token::LEFT_BRACKET){
+            depth++;
+        }else if(this->token == Token::RIGHT_PAREN || this->token == Token::RIGHT_BRACKET){
+            depth--;
+        }
+        this->lex();
+    }
+}
+
+bool TPTPReader::next(TPTPInput& input){
+    if(this->token == Token::END){
+        return false;
+    }
+    if(this->token != Token::LOWER_WORD){
+        this->error("expected an annotated formula but found '" + this->text + "'");
+    }
+    if(this->text == "include"){
+        this->error("include directives are not supported");
+    }
+    if(this->text != "fof" && this->text != "cnf"){
+        this->error("the " + this->text + " language is not supported");
+    }
+    input.language = this->text;
+    this->lex();
+    this->expect(Token::LEFT_PAREN, "'('");
+    if(this->token != Token::LOWER_WORD && this->token != Token::QUOTED && this->token != Token::NUMBER){
+        this->error("expected a formula name but found '" + this->text + "'");
+    }
+    input.name = this->text;
+    this->lex();
+    this->expect(Token::COMMA, "','");
+    if(this->token != Token::LOWER_WORD){
+        this->error("expected a formula role but found '" + this->text + "'");
+    }
+    input.role = this->text;
+    this->lex();
+    this->expect(Token::COMMA, "','");
+
+    this->collectVariables = input.language == "cnf";
+    this->freeVariables.clear();
+    pFormula formula (this->parseFormula());
+    for(auto itr = this->freeVariables.rbegin(); itr != this->freeVariables.rend(); itr++){
+        formula = pFormula(Forall(*itr, formula.release()));
+    }
+    if(this->token == Token::COMMA){
+        this->lex();
+        this->skipAnnotations();
+    }
+    this->expect(Token::RIGHT_PAREN, "')'");
+    if(this->token != Token::PERIOD){
+        this->error("expected '.' but found '" + this->text + "'");
+    }
+    //Read ahead only once the formula is complete
+    input.formula = std::move(formula);
+    this->lex();
+    return true;
+}
+
+std::vector<TPTPInput> parseTPTP(const std::string& problem){
+    std::istringstream stream(problem);
+    TPTPReader reader(stream);
+    std::vector<TPTPInput> rv;
+    TPTPInput input;
+    while(reader.next(input)){
+        rv.push_back(std::move(input));
+    }
+    return rv;
+}
+
+// Writer ======================================================================
+
+/**
+ *  Converts an arbitrary eminence prover identifier to an TPTP identifier
+ *  All TPTP identifiers start with a letter followed by any length of letters
+ *  and numbers Functions and Predicates are use lowercase letters 
+ *  Quantified variables are forced to use upper case letters
+ *  @param epIdentifier the identifier string provided by eminence prover
+ *  @param upper if the identifier should be upper cased, I.E. is a 
+ *  @return a legal TPTP Identifier 
+*/
+std::string makeLegalTPTPIdentifier(const std::string& epIdentifier,
+                                    bool upper){
+    std::string rv = "";
+    //Ensure first char is a letter; if not, append an S on front
+    if (epIdentifier.size() == 0 || !std::isalpha(epIdentifier[0])){
+        rv = (upper ? "S" : "s") + rv; 
+    }
+    for(char c : epIdentifier){ //append all legal chars
+        if(std::isalnum(c)){ 
+            rv += (char)(upper ? std::toupper(c) : std::tolower(c));
+        }
+    }
+    return rv;
+}
+
+/** @return true iff makeLegalTPTPIdentifier would return the identifier unchanged */
+inline bool isLegalTPTPIdentifier(const std::string& identifier, bool upper){
+    if(identifier.empty() || !std::isalpha(identifier[0])){
+        return false;
+    }
+    for(char c : identifier){
+        if(!std::isalnum(c) || (upper ? std::islower(c) : std::isupper(c))){
+            return false;
+        }
+    }
+    return true;
+}
+
+const std::string& TPTPFormatter::identifier(const std::string& name, bool upper){
+    if(isLegalTPTPIdentifier(name, upper)){
+        return name;
+    }
+    auto& cache = upper ? this->upperIdentifiers : this->lowerIdentifiers;
+    auto itr = cache.find(name);
+    if(itr == cache.end()){
+        itr = cache.emplace(name, makeLegalTPTPIdentifier(name, upper)).first;
+    }
+    return itr->second;
+}
+
+bool TPTPFormatter::isBound(const std::string& name) const{
+    return this->binders.contains(name);
+}
+
+const std::unordered_map<Formula::Type, std::string> TPTPStringMap = {      
+    {Formula::Type::NOT, "~"},          
+    {Formula::Type::AND, "&"},           
+    {Formula::Type::OR, "|"},            
+    {Formula::Type::IF, "=>"},            
+    {Formula::Type::IFF, "<=>"},           
+    {Formula::Type::FORALL, "!"},        
+    {Formula::Type::EXISTS, "?"},        
+};
+
+void throwNotFirstOrder(){
+    throw std::runtime_error("Trying to convert a non-first order formula to first order TPTP");
+}
+
+/**
+ * Visitor printing a formula in TPTP syntax while legalizing its identifiers,
+ * binary connectives and quantifiers are fully parenthesized. Quantifying
+ * over a predicate or function makes the formula second order, which is
+ * reported as soon as the predicate or function is reached.
+*/
+struct TPTPPrinter{
+    TPTPFormatter& formatter;
+    std::string& rv;
+
+    /** @brief Appends a constant, or a function name and opens its arguments */
+    void term(const Term* term){
+        if(term->args.size() == 0){
+            if(formatter.isBound(term->name)){
+                rv += formatter.identifier(term->name, true);
+            }else{
+                rv += '"';
+                rv += term->name;
+                rv += '"';
+            }
+        }else{
+            if(formatter.isBound(term->name)){
+                throwNotFirstOrder();
+            }
+            rv += formatter.identifier(term->name, false);
+            rv += '(';
+        }
+    }
+
+    /**
+     * Uses an explicit stack where a null entry closes the innermost open
+     * argument list, every argument is followed by a separator and the
+     * separator after the last argument of a list is replaced with ')'.
+    */
+    void onPred(const Formula* f){
+        if(formatter.isBound(f->pred->name)){
+            throwNotFirstOrder();
+        }
+        rv += formatter.identifier(f->pred->name, false);
+        const TermList& args = f->pred->args;
+        if(args.size() == 0){
+            return;
+        }
+        rv += '(';
+        std::vector<const Term*>& stack = formatter.terms;
+        stack.assign({nullptr});
+        stack.insert(stack.end(), args.rbegin(), args.rend());
+        while(!stack.empty()){
+            const Term* t = stack.back();
+            stack.pop_back();
+            if(t == nullptr){
+                rv.pop_back();
+                rv.back() = ')';
+                rv += ", ";
+                continue;
+            }
+            term(t);
+            if(t->args.size() == 0){
+                rv += ", ";
+            }else{
+                stack.push_back(nullptr);
+                stack.insert(stack.end(), t->args.rbegin(), t->args.rend());
+            }
+        }
+        rv.resize(rv.size() - 2);
+    }
+    void onUnary(const Formula* f){
+        rv += TPTPStringMap.at(f->type);
+    }
+    void onBinary(const Formula*){
+        rv += '(';
+    }
+    void betweenBinary(const Formula* f){
+        rv += TPTPStringMap.at(f->type);
+    }
+    void leaveBinary(const Formula*){
+        rv += ')';
+    }
+    void onQuant(const Formula* f){
+        rv += '(';
+        rv += TPTPStringMap.at(f->type);
+        rv += " [";
+        rv += formatter.identifier(f->quantifier->var, true);
+        rv += "] : ";
+        formatter.binders[f->quantifier->var]++;
+    }
+    void leaveQuant(const Formula* f){
+        rv += ')';
+        //Keys view the variable of the outermost open binder, so they must not outlive it
+        auto itr = formatter.binders.find(f->quantifier->var);
+        if(--itr->second == 0){
+            formatter.binders.erase(itr);
+        }
+    }
+};
+
+void TPTPFormatter::append(std::string& out, const std::string& name, const std::string& role,
+                           const Formula* formula){
+    size_t start = out.size();
+    try{
+        out += "fof(";
+        out += name;
+        out += ',';
+        out += role;
+        out += ',';
+        visit(formula, TPTPPrinter{*this, out});
+        out += ").";
+    }catch(...){
+        out.resize(start);
+        this->binders.clear();
+        throw;
+    }
+}
+
+std::string toFirstOrderTPTP(std::string name, std::string type, const Formula* formula){
+    std::string rv;
+    TPTPFormatter().append(rv, name, type, formula);
+    return rv;
+}
+
+std::string toFirstOrderTPTP(std::string name, std::string type, pFormula formula){
+    return toFirstOrderTPTP(std::move(name), std::move(type), formula.get());
+}
+
+TPTPWriter::TPTPWriter(std::ostream& output, size_t bufferSize)
+:output(output), bufferSize(bufferSize)
+{
+    this->buffer.reserve(bufferSize);
+}
+
+TPTPWriter::~TPTPWriter(){
+    this->flush();
+}
+
+void TPTPWriter::write(const std::string& name, const std::string& role, const Formula* formula){
+    this->formatter.append(this->buffer, name, role, formula);
+    this->buffer += '\n';
+    this->formulae++;
+    if(this->buffer.size() >= this->bufferSize){
+        this->flush();
+    }
+}
+
+void TPTPWriter::flush(){
+    this->output.write(this->buffer.data(), this->buffer.size());
+    this->buffer.clear();
+}
@@ -1,18 +1,68 @@
 
+#include<vector>
+#include<utility>
+
 #include "Term.hpp"
 
+/**
+ * Frees a list of term trees using an explicit stack, so that arbitrarily deep
+ * terms can not overflow the call stack.
+ * @param args the term trees to free, left empty
+*/
+void deleteTermList(TermList& args){
+    std::vector<Term*> stack(args.begin(), args.end());
+    args.clear();
+    while(!stack.empty()){
+        Term* term = stack.back();
+        stack.pop_back();
+        stack.insert(stack.end(), term->args.begin(), term->args.end());
+        //Detach the args so the destructor has nothing left to free
+        term->args.clear();
+        delete term;
+    }
+}
+
 Term::~Term(){
-    for(Term* arg : args){
-        delete arg;
+    deleteTermList(this->args);
+}
+
+Term::Term(Term&& other) noexcept
+:name(std::move(other.name)), args(std::move(other.args)){
+    other.args.clear();
+}
+
+Term& Term::operator=(Term&& other) noexcept{
+    if(this != &other){
+        deleteTermList(this->args);
+        this->name = std::move(other.name);
+        this->args = std::move(other.args);
+        other.args.clear();
     }
+    return *this;
 }
 
 Term* Term::copy() const{
     Term* rv = new Term;
     rv->name = this->name;
-    rv->args = TermList();
-    for(Term* arg : this->args){
-        rv->args.push_back(arg->copy());
+    //Constants are by far the most common terms, skip the stack for them
+    if(this->args.size() == 0){
+        return rv;
+    }
+    //Stack of source terms and the slots their copies are written to
+    std::vector<std::pair<const Term*, Term*>> stack;
+    stack.reserve(16);
+    for(const Term* arg : this->args){
+        rv->args.push_back(new Term);
+        stack.emplace_back(arg, rv->args.back());
+    }
+    while(!stack.empty()){
+        auto [source, target] = stack.back();
+        stack.pop_back();
+        target->name = source->name;
+        for(const Term* arg : source->args){
+            target->args.push_back(new Term);
+            stack.emplace_back(arg, target->args.back());
+        }
     }
     return rv;
 }
@@ -22,18 +72,21 @@ Term* Term::copy() const{
  * if they share the same arguments.
  * @return if the terms are semantically equivelent 
 */
-bool Term::operator==(const Term& term){
-    //Name and argument size are the same.
-    if(this->name != term.name || this->args.size() != term.args.size()){
-        return false;
-    }
-    //Arguments are the same
-    TermList::const_iterator itr1 = this->args.begin();
-    TermList::const_iterator itr2 = term.args.begin();
-    for(; itr1 == this->args.end(); itr1++, itr2++){
-        if(!(**itr1 == **itr2)){
+bool Term::operator==(const Term& term) const{
+    std::vector<std::pair<const Term*, const Term*>> stack = {{this, &term}};
+    while(!stack.empty()){
+        auto [a, b] = stack.back();
+        stack.pop_back();
+        //Name and argument size are the same.
+        if(a->name != b->name || a->args.size() != b->args.size()){
             return false;
         }
+        //Arguments are compared later
+        TermList::const_iterator itr1 = a->args.begin();
+        TermList::const_iterator itr2 = b->args.begin();
+        for(; itr1 != a->args.end(); itr1++, itr2++){
+            stack.emplace_back(*itr1, *itr2);
+        }
     }
     return true;
 }
@@ -48,12 +101,26 @@ TermList Term::subconstants() const{
     return rv;
 }
 
+/**
+ * Pushes the args of a term onto a traversal stack such that they are popped
+ * in left to right order.
+*/
+inline void pushArgsReversed(const Term* base, std::vector<Term*>& stack){
+    for(auto itr = base->args.rbegin(); itr != base->args.rend(); itr++){
+        stack.push_back(*itr);
+    }
+}
+
 void inOrderConstantTraversal(Term* base, TermList& constants){
-    for(Term* arg : base->args){
-        if(arg->args.size() == 0){
-            constants.push_back(arg);
-        }else if(arg->args.size() > 0){
-            inOrderConstantTraversal(arg, constants);
+    std::vector<Term*> stack;
+    pushArgsReversed(base, stack);
+    while(!stack.empty()){
+        Term* term = stack.back();
+        stack.pop_back();
+        if(term->args.size() == 0){
+            constants.push_back(term);
+        }else{
+            pushArgsReversed(term, stack);
         }
     }
 }
@@ -73,11 +140,15 @@ TermList Term::allConstants() const{
 }
 
 void inOrderFunctionTraversal(Term* base, TermList& functions){
-    for(Term* arg : base->args){
-        if(arg->args.size() != 0){
-            functions.push_back(arg);
+    std::vector<Term*> stack;
+    pushArgsReversed(base, stack);
+    while(!stack.empty()){
+        Term* term = stack.back();
+        stack.pop_back();
+        if(term->args.size() != 0){
+            functions.push_back(term);
+            pushArgsReversed(term, stack);
         }
-        inOrderFunctionTraversal(arg, functions);
     }
 }
 
@@ -96,20 +167,33 @@ TermList Term::allFunctions() const {
 }
 
 size_t Term::depth() const{
-    size_t termDepth = 0;
-    for(Term* arg : this->args){
-        size_t argDepth = arg->depth();
-        if(argDepth > termDepth){
-            termDepth = argDepth;
+    //Constants are by far the most common args, skip the stack for them
+    if(this->args.size() == 0){
+        return 1;
+    }
+    size_t maxDepth = 0;
+    std::vector<std::pair<const Term*, size_t>> stack = {{this, 1}};
+    while(!stack.empty()){
+        auto [term, termDepth] = stack.back();
+        stack.pop_back();
+        if(termDepth > maxDepth){
+            maxDepth = termDepth;
+        }
+        for(const Term* arg : term->args){
+            stack.emplace_back(arg, termDepth + 1);
         }
     }
-    return 1 + termDepth;
+    return maxDepth;
 }
 
 std::unordered_set<std::string> Term::identifiers() const{
-    std::unordered_set<std::string> rv = {this->name};
-    for(Term* arg : args){
-        rv.merge(arg->identifiers());
+    std::unordered_set<std::string> rv;
+    std::vector<const Term*> stack = {this};
+    while(!stack.empty()){
+        const Term* term = stack.back();
+        stack.pop_back();
+        rv.insert(term->name);
+        stack.insert(stack.end(), term->args.begin(), term->args.end());
     }
     return rv;
 }
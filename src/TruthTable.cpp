@@ -0,0 +1,217 @@
+
+#include<bit>
+#include<string>
+#include<vector>
+#include<algorithm>
+#include<stdexcept>
+#include<unordered_map>
+#include<unordered_set>
+#include<initializer_list>
+
+#include "TruthTable.hpp"
+#include "FormulaVisitor.hpp"
+
+/** Assignments are evaluated in blocks of this many words */
+constexpr size_t BLOCK_WORDS = 8;
+
+/** Bit patterns of the atoms that change within a word */
+constexpr uint64_t WORD_PATTERNS[6] = {
+    0xAAAAAAAAAAAAAAAAULL,
+    0xCCCCCCCCCCCCCCCCULL,
+    0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL,
+    0xFFFF0000FFFF0000ULL,
+    0xFFFFFFFF00000000ULL,
+};
+
+/** @return a mask of the valid bits of a word in a table over n atoms */
+inline uint64_t validBits(size_t atoms){
+    return atoms >= 6 ? ~0ULL : (1ULL << (1ULL << atoms)) - 1;
+}
+
+// Truth Tables ================================================================
+
+size_t TruthTable::assignments() const{
+    return (size_t)1 << this->atoms.size();
+}
+
+bool TruthTable::value(size_t assignment) const{
+    return (this->bits[assignment / 64] >> (assignment % 64)) & 1;
+}
+
+size_t TruthTable::models() const{
+    size_t rv = 0;
+    for(uint64_t word : this->bits){
+        rv += std::popcount(word);
+    }
+    return rv;
+}
+
+bool TruthTable::isTautology() const{
+    uint64_t mask = validBits(this->atoms.size());
+    return std::all_of(this->bits.begin(), this->bits.end(), [mask](uint64_t word){ return word == mask; });
+}
+
+bool TruthTable::isSatisfiable() const{
+    return std::any_of(this->bits.begin(), this->bits.end(), [](uint64_t word){ return word != 0; });
+}
+
+bool TruthTable::operator==(const TruthTable& other) const{
+    return this->atoms == other.atoms && this->bits == other.bits;
+}
+
+// Compilation =================================================================
+
+/**
+ * Post-order visitor emitting one instruction per distinct subformula, the
+ * index of the instruction computing each subformula is kept on a stack.
+*/
+struct PropositionalCompiler{
+    CompiledFormula& compiled;
+    std::unordered_map<std::string, uint32_t> atomIndices = {};
+    std::unordered_map<uint64_t, uint32_t> emitted = {};
+    std::vector<uint32_t> stack = {};
+
+    uint32_t emit(CompiledFormula::Op op, uint32_t left, uint32_t right){
+        //Operands are earlier instructions, so equal keys compute equal values
+        uint64_t key = ((uint64_t)op << 56) | ((uint64_t)left << 28) | right;
+        auto [itr, inserted] = emitted.try_emplace(key, compiled.program.size());
+        if(inserted){
+            compiled.program.push_back({op, left, right});
+        }
+        return itr->second;
+    }
+
+    void onPred(const Formula* formula){
+        auto itr = atomIndices.find(formula->pred->name);
+        if(itr == atomIndices.end()){
+            throw std::runtime_error("Proposition " + formula->pred->name + " is not in the atom list");
+        }
+        stack.push_back(emit(CompiledFormula::Op::ATOM, itr->second, 0));
+    }
+    void onUnary(const Formula*){
+        stack.back() = emit(CompiledFormula::Op::NOT, stack.back(), 0);
+    }
+    void onBinary(const Formula* formula){
+        static const std::unordered_map<Formula::Type, CompiledFormula::Op> ops = {
+            {Formula::Type::AND, CompiledFormula::Op::AND},
+            {Formula::Type::OR, CompiledFormula::Op::OR},
+            {Formula::Type::IF, CompiledFormula::Op::IF},
+            {Formula::Type::IFF, CompiledFormula::Op::IFF},
+        };
+        uint32_t right = stack.back();
+        stack.pop_back();
+        stack.back() = emit(ops.at(formula->type), stack.back(), right);
+    }
+};
+
+CompiledFormula compilePropositional(const Formula* formula, const std::vector<std::string>& atoms){
+    if(!formula->isPropositional()){
+        throw std::runtime_error("Truth tables can only be built for propositional formulae");
+    }
+    if(atoms.size() > MAX_TRUTH_TABLE_ATOMS){
+        throw std::runtime_error("Truth tables are limited to " +
+                                 std::to_string(MAX_TRUTH_TABLE_ATOMS) + " propositions");
+    }
+    CompiledFormula rv;
+    rv.atoms = atoms;
+    PropositionalCompiler compiler{rv};
+    for(uint32_t i = 0; i < atoms.size(); i++){
+        compiler.atomIndices.emplace(atoms[i], i);
+    }
+    visitPostOrder(formula, compiler);
+    //The result must be the last instruction, it may have been emitted earlier
+    uint32_t result = compiler.stack.back();
+    if(result != rv.program.size() - 1){
+        rv.program.push_back(rv.program[result]);
+    }
+    return rv;
+}
+
+/** @return the distinct proposition names of formulae in order of first appearance */
+std::vector<std::string> propositionNames(std::initializer_list<const Formula*> formulae){
+    std::vector<std::string> rv;
+    std::unordered_set<std::string> seen;
+    for(const Formula* formula : formulae){
+        for(Formula* proposition : formula->allPropositions()){
+            if(seen.insert(proposition->pred->name).second){
+                rv.push_back(proposition->pred->name);
+            }
+        }
+    }
+    return rv;
+}
+
+CompiledFormula compilePropositional(const Formula* formula){
+    return compilePropositional(formula, propositionNames({formula}));
+}
+
+// Evaluation ==================================================================
+
+TruthTable CompiledFormula::evaluate() const{
+    TruthTable rv;
+    rv.atoms = this->atoms;
+    size_t words = std::max<size_t>(1, rv.assignments() / 64);
+    rv.bits.resize(words);
+
+    std::vector<uint64_t> registers(this->program.size() * BLOCK_WORDS);
+    for(size_t base = 0; base < words; base += BLOCK_WORDS){
+        for(size_t i = 0; i < this->program.size(); i++){
+            const Instruction& instruction = this->program[i];
+            uint64_t* out = &registers[i * BLOCK_WORDS];
+            const uint64_t* left = &registers[instruction.left * BLOCK_WORDS];
+            const uint64_t* right = &registers[instruction.right * BLOCK_WORDS];
+            //Fixed length loops over a block so each one is vectorized
+            switch(instruction.op){
+                case Op::ATOM:
+                    if(instruction.left < 6){
+                        std::fill(out, out + BLOCK_WORDS, WORD_PATTERNS[instruction.left]);
+                    }else{
+                        //Atoms past the 6th are constant over a word
+                        for(size_t w = 0; w < BLOCK_WORDS; w++){
+                            out[w] = -(((base + w) >> (instruction.left - 6)) & 1);
+                        }
+                    }
+                    break;
+                case Op::NOT:
+                    for(size_t w = 0; w < BLOCK_WORDS; w++){
+                        out[w] = ~left[w];
+                    }
+                    break;
+                case Op::AND:
+                    for(size_t w = 0; w < BLOCK_WORDS; w++){
+                        out[w] = left[w] & right[w];
+                    }
+                    break;
+                case Op::OR:
+                    for(size_t w = 0; w < BLOCK_WORDS; w++){
+                        out[w] = left[w] | right[w];
+                    }
+                    break;
+                case Op::IF:
+                    for(size_t w = 0; w < BLOCK_WORDS; w++){
+                        out[w] = ~left[w] | right[w];
+                    }
+                    break;
+                case Op::IFF:
+                    for(size_t w = 0; w < BLOCK_WORDS; w++){
+                        out[w] = ~(left[w] ^ right[w]);
+                    }
+                    break;
+            }
+        }
+        const uint64_t* result = &registers[(this->program.size() - 1) * BLOCK_WORDS];
+        std::copy(result, result + std::min(BLOCK_WORDS, words - base), rv.bits.begin() + base);
+    }
+    rv.bits[0] &= validBits(rv.atoms.size());
+    return rv;
+}
+
+TruthTable truthTable(const Formula* formula){
+    return compilePropositional(formula).evaluate();
+}
+
+bool truthTableEquivalent(const Formula* a, const Formula* b){
+    std::vector<std::string> atoms = propositionNames({a, b});
+    return compilePropositional(a, atoms).evaluate() == compilePropositional(b, atoms).evaluate();
+}
@@ -1,9 +1,25 @@
 
 
-#include<set>
+#include<initializer_list>
+#include<algorithm>
 #include<string>
 #include<vector>
+#include<cstdint>
+#include<deque>
+#include<mutex>
+#include<condition_variable>
+#include<queue>
+#include<tuple>
+#include<atomic>
+#include<memory>
+#include<thread>
+#include<exception>
 #include<optional>
+#include<unordered_map>
+#include<unordered_set>
+
+#include<rapidjson/writer.h>
+#include<rapidjson/stringbuffer.h>
 
 #include"Formula.hpp"
 #include"verify.hpp"
@@ -16,104 +32,428 @@
 struct VerifyResult{
     bool verified;
     size_t depth;
-    std::string errMsg;
+    std::optional<VerifyError> error;
 };
 
+/** @brief The parents of a node in the order of the premise roles of its rule */
+using Premises = std::vector<ProofNode*>;
+
 // Assumption Builders =========================================================
 
 /**
  * @returns the union of the node's parents assumptions
 */
-std::set<ProofNode*> parentAssumptionUnion(const ProofNode* node){
-    std::set<ProofNode*> rv;
+AssumptionSet parentAssumptionUnion(const ProofNode* node){
+    AssumptionSet rv;
     for(const ProofNode* parent : node->parents)
-        for(ProofNode* assumption : parent->assumptions)
-            rv.insert(assumption);
+        rv = rv.unite(parent->assumptions);
     return rv;
 }
 
 /**
- * @returns the union of the node's parents assumptions, excluding any formulae
- *          in the exclude set.
+ * @returns the union of the node's parents assumptions, excluding any
+ *          assumption equal to some formula in excludes.
+ * @details only assumptions under the hash of an excluded formula are
+ * compared, the others are found by intersecting with the universe's index.
 */
-std::set<ProofNode*> parentAssumptionUnionExcluding(
+AssumptionSet parentAssumptionUnionExcluding(
     const ProofNode* node,
-    std::set<Formula*> excludeSet
+    std::initializer_list<const Formula*> excludes
 ){
-    std::set<ProofNode*> rv;
-    for(ProofNode* assumption : parentAssumptionUnion(node)){
-        for(Formula* exclude: excludeSet){
-            if(!(*assumption->formula == *exclude)){
-                rv.insert(assumption);
-            }
+    AssumptionSet rv = parentAssumptionUnion(node);
+    AssumptionSet discharged;
+    for(const Formula* exclude : excludes){
+        const AssumptionSet& candidates = node->universe->withFormulaHash(std::hash<Formula>()(*exclude));
+        discharged = discharged.unite(rv.intersect(candidates).filter([&](const ProofNode* assumption){
+            return *assumption->formula == *exclude;
+        }));
+    }
+    return rv.minus(discharged);
+}
+
+// Error Messages ==============================================================
+
+const std::string CYCLE_ERROR = "node is on or depends on a cycle";
+
+VerifyError cycleError(const ProofNode* node){
+    return {node->justification, VerifyCondition{VerifyErrorCode::CYCLE}};
+}
+
+std::string VerifyCondition::message() const{
+    switch(code){
+        case VerifyErrorCode::PARENT_COUNT:
+            return "expected " + toSExpression(formulas[0]) + " to have " + std::to_string(expected) +
+                   " parents but it has " + std::to_string(actual) + " parents";
+        case VerifyErrorCode::CONNECTIVE:
+            return "expected " + toSExpression(formulas[0]) + " to have top level connective " +
+                   TYPE_STRING_MAP.at(connective) + " but it has " + TYPE_STRING_MAP.at(formulas[0]->type);
+        case VerifyErrorCode::BINARY_CONNECTIVE:
+            return "expected " + toSExpression(formulas[0]) +
+                   " to have a binary top level connective but it has " + TYPE_STRING_MAP.at(formulas[0]->type);
+        case VerifyErrorCode::NOT_EQUAL:
+            return "expected " + toSExpression(formulas[0]) + " to equal " + toSExpression(formulas[1]);
+        case VerifyErrorCode::MISSING_ASSUMPTION:
+            return "expected " + toSExpression(formulas[0]) + " to have " + toSExpression(formulas[1]) +
+                   " as an assumption";
+        case VerifyErrorCode::NOT_INSTANCE:
+            return "expected " + toSExpression(formulas[0]) + " to be an instance of " + toSExpression(formulas[1]);
+        case VerifyErrorCode::MISSING_INSTANCE:
+            return "expected " + toSExpression(formulas[0]) + " to have an instance of " +
+                   toSExpression(formulas[1]) + " as an assumption";
+        case VerifyErrorCode::NOT_CONSTANT:
+            return "expected " + toSExpression(term) + " to be a constant";
+        case VerifyErrorCode::EIGENVARIABLE:
+            return "expected eigenvariable " + term->name + " of " + toSExpression(formulas[0]) +
+                   " to not occur in " + toSExpression(formulas[1]);
+        case VerifyErrorCode::PARENT_FAILED:
+            return "parent " + std::to_string(parent) + " did not verify";
+        case VerifyErrorCode::CYCLE:
+            return CYCLE_ERROR;
+    }
+    return "";
+}
+
+std::string VerifyError::message() const{
+    if(alternative){
+        return "Either " + condition.message() + " or " + alternative->message() + ".";
+    }
+    //Failed rules end in a full stop, failed graphs do not
+    bool graph = condition.code == VerifyErrorCode::PARENT_FAILED || condition.code == VerifyErrorCode::CYCLE;
+    return condition.message() + (graph ? "" : ".");
+}
+
+// Instances ===================================================================
+
+/**
+ * Matches a formula against the body of a quantifier. The formula is an
+ * instance if it is the body with every free occurrence of the variable
+ * replaced by the same term, and no quantifier of the body captures a name
+ * of that term. Both are walked together once, no substitution is built.
+ * Only term variables are instantiated, quantifiers over predicates and
+ * functions only have identical instances.
+ * @param witness set to the term replacing the variable, null if the
+ * variable does not occur free in the body
+ * @return true iff instance is an instance of body
+*/
+bool isInstance(const Formula* body, const std::string& var, const Formula* instance, const Term*& witness){
+    witness = nullptr;
+    std::unordered_set<std::string> witnessNames;
+    //Names bound by the quantifiers above the formulae on the stack
+    std::vector<const std::string*> bound;
+    struct Frame{
+        const Formula* body;
+        const Formula* instance;
+        size_t bound;
+    };
+    std::vector<Frame> stack = {{body, instance, 0}};
+    std::vector<std::pair<const Term*, const Term*>> terms;
+    while(!stack.empty()){
+        auto [b, i, depth] = stack.back();
+        stack.pop_back();
+        bound.resize(depth);
+        if(b->type != i->type){
+            return false;
+        }
+        switch(b->connectiveType){
+            case Formula::ConnectiveType::PRED:
+                if(b->pred->name != i->pred->name || b->pred->args.size() != i->pred->args.size()){
+                    return false;
+                }
+                terms.clear();
+                for(auto bt = b->pred->args.begin(), it = i->pred->args.begin(); bt != b->pred->args.end(); bt++, it++){
+                    terms.emplace_back(*bt, *it);
+                }
+                while(!terms.empty()){
+                    auto [bt, it] = terms.back();
+                    terms.pop_back();
+                    if(bt->args.empty() && bt->name == var){
+                        if(witness == nullptr){
+                            witness = it;
+                            witnessNames = it->identifiers();
+                        }else if(!(*witness == *it)){
+                            return false;
+                        }
+                        for(const std::string* name : bound){
+                            if(witnessNames.contains(*name)){
+                                return false;
+                            }
+                        }
+                        continue;
+                    }
+                    if(bt->name != it->name || bt->args.size() != it->args.size()){
+                        return false;
+                    }
+                    for(auto ba = bt->args.begin(), ia = it->args.begin(); ba != bt->args.end(); ba++, ia++){
+                        terms.emplace_back(*ba, *ia);
+                    }
+                }
+                break;
+            case Formula::ConnectiveType::UNARY:
+                stack.push_back({b->unary->arg, i->unary->arg, depth});
+                break;
+            case Formula::ConnectiveType::BINARY:
+                stack.push_back({b->binary->left, i->binary->left, depth});
+                stack.push_back({b->binary->right, i->binary->right, depth});
+                break;
+            case Formula::ConnectiveType::QUANT:
+                if(b->quantifier->var != i->quantifier->var){
+                    return false;
+                }
+                //The variable is shadowed, nothing below is replaced
+                if(b->quantifier->var == var){
+                    if(!(*b->quantifier->arg == *i->quantifier->arg)){
+                        return false;
+                    }
+                    break;
+                }
+                bound.push_back(&b->quantifier->var);
+                stack.push_back({b->quantifier->arg, i->quantifier->arg, depth + 1});
+                break;
         }
     }
-    return rv;
+    return true;
 }
 
 //Conditions ===================================================================
 
+/*
+ * Conditions return the failed condition when they fail. It only borrows
+ * the formulae involved, its message is built on demand, so checking an
+ * assignment allocates nothing.
+*/
+
+constexpr int8_t CONCLUSION = VerifyCondition::CONCLUSION;
+
 /**
  *  @param p proof node to check
- *  @param t what top level connective should this node have? 
- *           nullopt if we don't care.
- *  @returns an optional error string if the connectives don't match
+ *  @param t what top level connective should this node have?
+ *  @param role the premise role of p, CONCLUSION for the node itself
+ *  @returns the failed condition if the connectives don't match
 */
-std::optional<std::string> hasConnective(const ProofNode* p, Formula::Type t){
+std::optional<VerifyCondition> hasConnective(const ProofNode* p, Formula::Type t, int8_t role){
     if(p->formula->type == t){
         return std::nullopt;
-    }else{
-        return std::make_optional("expected " + toSExpression(p->formula) +
-        " to have top level connective " + TYPE_STRING_MAP.at(t) + 
-        " but it has " + TYPE_STRING_MAP.at(p->formula->type));
+    }
+    VerifyCondition rv{VerifyErrorCode::CONNECTIVE};
+    rv.formulas[0] = p->formula.get();
+    rv.roles[0] = role;
+    rv.connective = t;
+    return rv;
+}
+
+/**
+ * @returns the failed condition if the node's top level connective is not
+ * binary
+*/
+std::optional<VerifyCondition> hasBinaryConnective(const ProofNode* p, int8_t role){
+    switch(p->formula->type){
+        case Formula::Type::AND:
+        case Formula::Type::OR:
+        case Formula::Type::IF:
+        case Formula::Type::IFF:
+            return std::nullopt;
+        default:
+            VerifyCondition rv{VerifyErrorCode::BINARY_CONNECTIVE};
+            rv.formulas[0] = p->formula.get();
+            rv.roles[0] = role;
+            return rv;
     }
 }
 
-std::optional<std::string> hasParents(const ProofNode* p, size_t n){
+std::optional<VerifyCondition> hasParents(const ProofNode* p, size_t n){
     if(p->parents.size() == n){
         return std::nullopt;
-    }else{
-        return std::make_optional("expected " + toSExpression(p->formula) +
-        " to have " + std::to_string(n) + " parents but it has " +
-        std::to_string(p->parents.size()) + " parents");
     }
+    VerifyCondition rv{VerifyErrorCode::PARENT_COUNT};
+    rv.formulas[0] = p->formula.get();
+    rv.expected = n;
+    rv.actual = p->parents.size();
+    return rv;
 }
 
-std::optional<std::string> equalFormula(
-    const Formula* a,
-    const Formula* b
+/** @param roleA, roleB the premise roles a and b are or are part of */
+std::optional<VerifyCondition> equalFormula(
+    const Formula* a, int8_t roleA,
+    const Formula* b, int8_t roleB
 ){
     if(*a == *b){
         return std::nullopt;
-    }else{
-        return std::make_optional("expected " + toSExpression(a) + " to equal "
-        + toSExpression(b));
     }
+    VerifyCondition rv{VerifyErrorCode::NOT_EQUAL};
+    rv.formulas[0] = a;
+    rv.formulas[1] = b;
+    rv.roles[0] = roleA;
+    rv.roles[1] = roleB;
+    return rv;
 }
 
 /**
- * @return iff proof node p has f in it's set of assumptions
+ * @param role, formulaRole the premise roles of p and the one f is part of
+ * @return the failed condition unless proof node p has f in it's set of
+ * assumptions
 */
-std::optional<std::string> hasAssumption(const ProofNode* p, const Formula* f){
-    for(ProofNode* assumption : p->assumptions){
-        if (*assumption->formula == *f){
-            return std::nullopt;
+std::optional<VerifyCondition> hasAssumption(const ProofNode* p, int8_t role, const Formula* f, int8_t formulaRole){
+    const AssumptionSet& candidates = p->universe->withFormulaHash(std::hash<Formula>()(*f));
+    bool found = p->assumptions.anyCommon(candidates, [&](const ProofNode* assumption){
+        return *assumption->formula == *f;
+    });
+    if(found){
+        return std::nullopt;
+    }
+    VerifyCondition rv{VerifyErrorCode::MISSING_ASSUMPTION};
+    rv.formulas[0] = p->formula.get();
+    rv.formulas[1] = f;
+    rv.roles[0] = role;
+    rv.roles[1] = formulaRole;
+    return rv;
+}
+
+/**
+ * @param instance the formula of role `role`, an instance of quantified
+ * @param witness set to the term the quantified variable is replaced by
+ * @return the failed condition unless instance is an instance of the body of
+ * the quantifier formula quantified
+*/
+std::optional<VerifyCondition> isInstanceOf(
+    const Formula* instance, int8_t role,
+    const Formula* quantified, int8_t quantifiedRole,
+    const Term*& witness
+){
+    if(isInstance(quantified->quantifier->arg, quantified->quantifier->var, instance, witness)){
+        return std::nullopt;
+    }
+    VerifyCondition rv{VerifyErrorCode::NOT_INSTANCE};
+    rv.formulas[0] = instance;
+    rv.formulas[1] = quantified;
+    rv.roles[0] = role;
+    rv.roles[1] = quantifiedRole;
+    return rv;
+}
+
+/**
+ * @param eigenvariable the term a quantified variable is replaced by in instance
+ * @param quantified the node with the quantifier formula, checked by its
+ * summary of free identifiers
+ * @return the failed condition unless the term is a constant that is not
+ * free in the formula of quantified
+*/
+std::optional<VerifyCondition> isEigenvariable(
+    const Term* eigenvariable, const Formula* instance, int8_t role,
+    const ProofNode* quantified, int8_t quantifiedRole
+){
+    if(!eigenvariable->args.empty()){
+        VerifyCondition rv{VerifyErrorCode::NOT_CONSTANT};
+        rv.term = eigenvariable;
+        return rv;
+    }
+    uint32_t number = quantified->universe->identifierNumber(eigenvariable->name);
+    if(!std::binary_search(quantified->identifiers.begin(), quantified->identifiers.end(), number)){
+        return std::nullopt;
+    }
+    VerifyCondition rv{VerifyErrorCode::EIGENVARIABLE};
+    rv.term = eigenvariable;
+    rv.formulas[0] = instance;
+    rv.formulas[1] = quantified->formula.get();
+    rv.roles[0] = role;
+    rv.roles[1] = quantifiedRole;
+    return rv;
+}
+
+/**
+ * @return the failed condition if the eigenvariable is free in any of the
+ * assumptions, found by intersecting them with the universe's index rather
+ * than walking their formulae
+*/
+std::optional<VerifyCondition> notAssumed(
+    const Term* eigenvariable, const Formula* instance, int8_t role,
+    const AssumptionSet& assumptions, const AssumptionUniverse& universe
+){
+    uint32_t number = universe.identifierNumber(eigenvariable->name);
+    const ProofNode* assumption = nullptr;
+    if(number != UINT32_MAX){
+        assumptions.anyCommon(universe.withIdentifier(number), [&](const ProofNode* node){
+            assumption = node;
+            return true;
+        });
+    }
+    if(assumption == nullptr){
+        return std::nullopt;
+    }
+    VerifyCondition rv{VerifyErrorCode::EIGENVARIABLE};
+    rv.term = eigenvariable;
+    rv.formulas[0] = instance;
+    rv.formulas[1] = assumption->formula.get();
+    rv.roles[0] = role;
+    rv.roles[1] = VerifyCondition::ASSUMPTION;
+    return rv;
+}
+
+/**
+ * Finds the assumption the case of an existential elimination discharges, an
+ * instance of the existential's body whose eigenvariable is free in neither
+ * the existential, the conclusion nor the assumptions left after the
+ * discharge. Every instance has the free identifiers of the existential, so
+ * only the case's assumptions indexed under one of them are matched.
+ * @param witness set to the discharged assumption
+ * @return the failed condition of the last instance found, or of there being none
+*/
+std::optional<VerifyCondition> hasWitnessAssumption(
+    const ProofNode* node, const Premises& premises, const ProofNode*& witness
+){
+    const ProofNode* existential = premises[0];
+    const ProofNode* caseNode = premises[1];
+    const Formula* quantified = existential->formula.get();
+    const AssumptionUniverse& universe = *node->universe;
+    AssumptionSet candidates = caseNode->assumptions;
+    if(!existential->identifiers.empty()){
+        candidates = candidates.intersect(universe.withIdentifier(existential->identifiers.front()));
+    }
+    std::optional<VerifyCondition> rv;
+    for(const ProofNode* assumption : candidates){
+        const Formula* instance = assumption->formula.get();
+        const Term* eigenvariable;
+        if(!isInstance(quantified->quantifier->arg, quantified->quantifier->var, instance, eigenvariable)){
+            continue;
         }
+        //Without the variable in the body there is no eigenvariable to check
+        if(eigenvariable != nullptr){
+            constexpr int8_t ASSUMPTION = VerifyCondition::ASSUMPTION;
+            rv = isEigenvariable(eigenvariable, instance, ASSUMPTION, existential, 0);
+            if(!rv){
+                rv = isEigenvariable(eigenvariable, instance, ASSUMPTION, node, CONCLUSION);
+            }
+            if(!rv){
+                AssumptionSet rest = parentAssumptionUnionExcluding(node, {instance});
+                rv = notAssumed(eigenvariable, instance, ASSUMPTION, rest, universe);
+            }
+            if(rv){
+                continue;
+            }
+        }
+        witness = assumption;
+        return std::nullopt;
+    }
+    if(rv){
+        return rv;
     }
-    return std::make_optional("expected " + toSExpression(p->formula) + 
-        " to have " + toSExpression(f) + " as an assumption");
+    rv = VerifyCondition{VerifyErrorCode::MISSING_INSTANCE};
+    rv->formulas[0] = caseNode->formula.get();
+    rv->formulas[1] = quantified;
+    rv->roles[0] = 1;
+    rv->roles[1] = 0;
+    return rv;
 }
 
 // Error Helper Macros =========================================================
 #define RULE_START()\
 size_t depth = 0;\
-std::optional<std::string> err, err1, err2;
+std::optional<VerifyCondition> err, err1, err2;
 
 #define EXPECT(COND)\
 err = COND;\
 depth++;\
 if(err){\
-    return {false, depth++, err.value() + "."};\
+    return {false, depth++, VerifyError{node->justification, *err}};\
 }\
 
 #define EXPECT_EITHER(COND1, COND2)\
@@ -121,197 +461,1255 @@ err1 = COND1;\
 err2 = COND2;\
 depth++;\
 if(err1 && err2){\
-    return {false, depth, "Either " + err1.value() +\
-                            " or " + err2.value() + "."};\
+    return {false, depth, VerifyError{node->justification, *err1, err2}};\
 }\
 
 #define RULE_END()\
-return {true, depth++, ""};
+return {true, depth++, std::nullopt};
 
 // Rules =======================================================================
 
+/*
+ * A rule checks a node against an assignment of its parents to the rule's
+ * premise roles, it does not modify the node.
+*/
+
 VerifyResult verifyAssumption(ProofNode* node){
     RULE_START();
     EXPECT(hasParents(node, 0));
-    node->assumptions = {node};
+    node->assumptions = AssumptionSet::of(node);
     RULE_END();
 }
 
-VerifyResult verifyAndIntro(ProofNode* node){
+VerifyResult verifyAndIntro(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 2));
-    EXPECT(hasConnective(node, Formula::Type::AND));
-    EXPECT(equalFormula(node->formula->binary->left, node->parents[0]->formula));
-    EXPECT(equalFormula(node->formula->binary->right, node->parents[1]->formula));
-    node->assumptions = parentAssumptionUnion(node);
+    EXPECT(hasConnective(node, Formula::Type::AND, CONCLUSION));
+    EXPECT(equalFormula(node->formula->binary->left, CONCLUSION, premises[0]->formula.get(), 0));
+    EXPECT(equalFormula(node->formula->binary->right, CONCLUSION, premises[1]->formula.get(), 1));
     RULE_END();
 }
 
-VerifyResult verifyAndElim(ProofNode* node){
+VerifyResult verifyAndElim(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 1));
-    ProofNode* parent = node->parents[0];
-    EXPECT(hasConnective(parent, Formula::Type::AND));
+    ProofNode* parent = premises[0];
+    EXPECT(hasConnective(parent, Formula::Type::AND, 0));
     EXPECT_EITHER(
-        equalFormula(node->formula, parent->formula->binary->left),
-        equalFormula(node->formula, parent->formula->binary->right)
+        equalFormula(node->formula.get(), CONCLUSION, parent->formula->binary->left, 0),
+        equalFormula(node->formula.get(), CONCLUSION, parent->formula->binary->right, 0)
     );
-    node->assumptions = parentAssumptionUnion(node);
     RULE_END();
 }
 
-VerifyResult verifyOrIntro(ProofNode* node){
+VerifyResult verifyOrIntro(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 1));
-    EXPECT(hasConnective(node, Formula::Type::OR));
-    ProofNode* parent = node->parents[0];
+    EXPECT(hasConnective(node, Formula::Type::OR, CONCLUSION));
+    ProofNode* parent = premises[0];
     EXPECT_EITHER(
-        equalFormula(parent->formula, node->formula->binary->left),
-        equalFormula(parent->formula, node->formula->binary->right)
+        equalFormula(parent->formula.get(), 0, node->formula->binary->left, CONCLUSION),
+        equalFormula(parent->formula.get(), 0, node->formula->binary->right, CONCLUSION)
     );
-    node->assumptions = parentAssumptionUnion(node);
     RULE_END();
 }
 
-VerifyResult verifyOrElim(ProofNode* node){
+VerifyResult verifyOrElim(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 3));
-    ProofNode* disjunction = node->parents[0];
+    ProofNode* disjunction = premises[0];
+    ProofNode* leftCase = premises[1];
+    ProofNode* rightCase = premises[2];
+    EXPECT(hasConnective(disjunction, Formula::Type::OR, 0));
     Formula* leftAssumption = disjunction->formula->binary->left;
     Formula* rightAssumption = disjunction->formula->binary->right;
-    ProofNode* leftCase = node->parents[1];
-    ProofNode* rightCase = node->parents[2];
-    EXPECT(hasConnective(disjunction, Formula::Type::OR));
-    EXPECT(equalFormula(node->formula, leftCase->formula));
-    EXPECT(equalFormula(node->formula, rightCase->formula));
-    EXPECT(hasAssumption(leftCase, leftAssumption));
-    EXPECT(hasAssumption(rightCase, rightAssumption));
-    node->assumptions = parentAssumptionUnionExcluding(node, {leftAssumption, rightAssumption});
+    EXPECT(equalFormula(node->formula.get(), CONCLUSION, leftCase->formula.get(), 1));
+    EXPECT(equalFormula(node->formula.get(), CONCLUSION, rightCase->formula.get(), 2));
+    EXPECT(hasAssumption(leftCase, 1, leftAssumption, 0));
+    EXPECT(hasAssumption(rightCase, 2, rightAssumption, 0));
     RULE_END();
 }
 
-VerifyResult verifyNotIntro(ProofNode* node){
+VerifyResult verifyNotIntro(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 2));
-    EXPECT(hasConnective(node, Formula::Type::NOT));
-    ProofNode* negatedParent = node->parents[0];
-    ProofNode* nonNegatedParent = node->parents[1];
+    EXPECT(hasConnective(node, Formula::Type::NOT, CONCLUSION));
+    ProofNode* negatedParent = premises[0];
+    ProofNode* nonNegatedParent = premises[1];
     Formula* assumption = node->formula->unary->arg;
-    EXPECT(hasConnective(negatedParent, Formula::Type::NOT));
-    EXPECT(equalFormula(nonNegatedParent->formula, negatedParent->formula->unary->arg));
+    EXPECT(hasConnective(negatedParent, Formula::Type::NOT, 0));
+    EXPECT(equalFormula(nonNegatedParent->formula.get(), 1, negatedParent->formula->unary->arg, 0));
     EXPECT_EITHER(
-        hasAssumption(negatedParent, assumption),
-        hasAssumption(nonNegatedParent, assumption)
+        hasAssumption(negatedParent, 0, assumption, CONCLUSION),
+        hasAssumption(nonNegatedParent, 1, assumption, CONCLUSION)
     );
-    //TODO: its possible that removing assumption after the union is
-    //problematic. If it is, write a new parentAssumptionUnionExcluding
-    //that removes from each branch before union.
-    node->assumptions = parentAssumptionUnionExcluding(node, {assumption});
     RULE_END();
 }
 
-VerifyResult verifyNotElim(ProofNode* node){
+VerifyResult verifyNotElim(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 2));
-    EXPECT(hasConnective(node, Formula::Type::NOT));
-    ProofNode* negatedParent = node->parents[0];
-    ProofNode* nonNegatedParent = node->parents[1];
+    EXPECT(hasConnective(node, Formula::Type::NOT, CONCLUSION));
+    ProofNode* negatedParent = premises[0];
+    ProofNode* nonNegatedParent = premises[1];
     Formula* assumption = node->formula->unary->arg;
-    EXPECT(hasConnective(negatedParent, Formula::Type::NOT));
-    EXPECT(equalFormula(nonNegatedParent->formula, negatedParent->formula->unary->arg));
+    EXPECT(hasConnective(negatedParent, Formula::Type::NOT, 0));
+    EXPECT(equalFormula(nonNegatedParent->formula.get(), 1, negatedParent->formula->unary->arg, 0));
     EXPECT_EITHER(
-        hasAssumption(negatedParent, assumption),
-        hasAssumption(nonNegatedParent, assumption)
+        hasAssumption(negatedParent, 0, assumption, CONCLUSION),
+        hasAssumption(nonNegatedParent, 1, assumption, CONCLUSION)
     );
-    node->assumptions = parentAssumptionUnionExcluding(node, {assumption});
     RULE_END();
 }
 
-VerifyResult verifyIfIntro(ProofNode* node){
+VerifyResult verifyIfIntro(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 1));
-    EXPECT(hasConnective(node, Formula::Type::IF));
+    EXPECT(hasConnective(node, Formula::Type::IF, CONCLUSION));
     Formula* antecedent = node->formula->binary->left;
     Formula* consequent = node->formula->binary->right;
-    EXPECT(hasAssumption(node->parents[0], antecedent));
-    EXPECT(equalFormula(consequent, node->parents[0]->formula));
-    node->assumptions = parentAssumptionUnionExcluding(node, {antecedent});
+    EXPECT(hasAssumption(premises[0], 0, antecedent, CONCLUSION));
+    EXPECT(equalFormula(consequent, CONCLUSION, premises[0]->formula.get(), 0));
     RULE_END();
 }
 
-VerifyResult verifyIfElim(ProofNode* node){
+VerifyResult verifyIfElim(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 2));
-    Formula* conditional = node->parents[0]->formula;
-    Formula* antecedent = node->parents[1]->formula;
-    EXPECT(equalFormula(conditional->binary->right, antecedent));
-    EXPECT(equalFormula(conditional->binary->left, node->formula));
-    node->assumptions = parentAssumptionUnion(node);
+    EXPECT(hasBinaryConnective(premises[0], 0));
+    Formula* conditional = premises[0]->formula.get();
+    Formula* antecedent = premises[1]->formula.get();
+    EXPECT(equalFormula(conditional->binary->right, 0, antecedent, 1));
+    EXPECT(equalFormula(conditional->binary->left, 0, node->formula.get(), CONCLUSION));
     RULE_END();
 }
 
-VerifyResult verifyIffIntro(ProofNode* node){
+VerifyResult verifyIffIntro(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 2));
-    EXPECT(hasConnective(node, Formula::Type::IF));
+    EXPECT(hasConnective(node, Formula::Type::IF, CONCLUSION));
     Formula* leftFormula = node->formula->binary->left;
     Formula* rightFormula = node->formula->binary->right;
-    ProofNode* leftPar = node->parents[0];
-    ProofNode* rightPar = node->parents[1];
-    EXPECT(equalFormula(leftPar->formula, leftFormula));
-    EXPECT(equalFormula(rightPar->formula, rightFormula));
-    EXPECT(hasAssumption(leftPar, rightFormula));
-    EXPECT(hasAssumption(rightPar, leftFormula));
-    node->assumptions = parentAssumptionUnionExcluding(node, {leftFormula, rightFormula});
+    ProofNode* leftPar = premises[0];
+    ProofNode* rightPar = premises[1];
+    EXPECT(equalFormula(leftPar->formula.get(), 0, leftFormula, CONCLUSION));
+    EXPECT(equalFormula(rightPar->formula.get(), 1, rightFormula, CONCLUSION));
+    EXPECT(hasAssumption(leftPar, 0, rightFormula, CONCLUSION));
+    EXPECT(hasAssumption(rightPar, 1, leftFormula, CONCLUSION));
     RULE_END();
 }
 
-VerifyResult verifyIffElim(ProofNode* node){
+VerifyResult verifyIffElim(const ProofNode* node, const Premises& premises){
     RULE_START();
     EXPECT(hasParents(node, 2));
-    EXPECT(hasConnective(node, Formula::Type::IF));
+    EXPECT(hasConnective(node, Formula::Type::IF, CONCLUSION));
     Formula* leftFormula = node->formula->binary->left;
     Formula* rightFormula = node->formula->binary->right;
-    ProofNode* leftPar = node->parents[0];
-    ProofNode* rightPar = node->parents[1];
-    EXPECT(equalFormula(leftPar->formula, leftFormula));
-    EXPECT(equalFormula(rightPar->formula, rightFormula));
-    EXPECT(hasAssumption(leftPar, rightFormula));
-    EXPECT(hasAssumption(rightPar, leftFormula));
-    node->assumptions = parentAssumptionUnionExcluding(node, {leftFormula, rightFormula});
+    ProofNode* leftPar = premises[0];
+    ProofNode* rightPar = premises[1];
+    EXPECT(equalFormula(leftPar->formula.get(), 0, leftFormula, CONCLUSION));
+    EXPECT(equalFormula(rightPar->formula.get(), 1, rightFormula, CONCLUSION));
+    EXPECT(hasAssumption(leftPar, 0, rightFormula, CONCLUSION));
+    EXPECT(hasAssumption(rightPar, 1, leftFormula, CONCLUSION));
+    RULE_END();
+}
+
+VerifyResult verifyForallIntro(const ProofNode* node, const Premises& premises){
+    RULE_START();
+    EXPECT(hasParents(node, 1));
+    EXPECT(hasConnective(node, Formula::Type::FORALL, CONCLUSION));
+    const Formula* instance = premises[0]->formula.get();
+    const Term* eigenvariable;
+    EXPECT(isInstanceOf(instance, 0, node->formula.get(), CONCLUSION, eigenvariable));
+    //Generalizing over a variable the body does not mention needs no eigenvariable
+    if(eigenvariable != nullptr){
+        EXPECT(isEigenvariable(eigenvariable, instance, 0, node, CONCLUSION));
+        EXPECT(notAssumed(eigenvariable, instance, 0, premises[0]->assumptions, *node->universe));
+    }
+    RULE_END();
+}
+
+VerifyResult verifyForallElim(const ProofNode* node, const Premises& premises){
+    RULE_START();
+    EXPECT(hasParents(node, 1));
+    EXPECT(hasConnective(premises[0], Formula::Type::FORALL, 0));
+    const Term* term;
+    EXPECT(isInstanceOf(node->formula.get(), CONCLUSION, premises[0]->formula.get(), 0, term));
     RULE_END();
 }
 
-const std::unordered_map<Justification, VerifyResult(*)(ProofNode*)> VERIFIERS =
+VerifyResult verifyExistsIntro(const ProofNode* node, const Premises& premises){
+    RULE_START();
+    EXPECT(hasParents(node, 1));
+    EXPECT(hasConnective(node, Formula::Type::EXISTS, CONCLUSION));
+    const Term* term;
+    EXPECT(isInstanceOf(premises[0]->formula.get(), 0, node->formula.get(), CONCLUSION, term));
+    RULE_END();
+}
+
+VerifyResult verifyExistsElim(const ProofNode* node, const Premises& premises){
+    RULE_START();
+    EXPECT(hasParents(node, 2));
+    EXPECT(hasConnective(premises[0], Formula::Type::EXISTS, 0));
+    EXPECT(equalFormula(node->formula.get(), CONCLUSION, premises[1]->formula.get(), 1));
+    const ProofNode* witness;
+    EXPECT(hasWitnessAssumption(node, premises, witness));
+    RULE_END();
+}
+
+// Rule Assumptions ============================================================
+
+AssumptionSet unionAssumptions(const ProofNode* node, const Premises&){
+    return parentAssumptionUnion(node);
+}
+
+AssumptionSet orElimAssumptions(const ProofNode* node, const Premises& premises){
+    const Formula* disjunction = premises[0]->formula.get();
+    return parentAssumptionUnionExcluding(node, {disjunction->binary->left, disjunction->binary->right});
+}
+
+AssumptionSet notIntroAssumptions(const ProofNode* node, const Premises&){
+    //TODO: its possible that removing assumption after the union is
+    //problematic. If it is, write a new parentAssumptionUnionExcluding
+    //that removes from each branch before union.
+    return parentAssumptionUnionExcluding(node, {node->formula->unary->arg});
+}
+
+AssumptionSet ifIntroAssumptions(const ProofNode* node, const Premises&){
+    return parentAssumptionUnionExcluding(node, {node->formula->binary->left});
+}
+
+AssumptionSet iffIntroAssumptions(const ProofNode* node, const Premises&){
+    return parentAssumptionUnionExcluding(node, {node->formula->binary->left, node->formula->binary->right});
+}
+
+AssumptionSet existsElimAssumptions(const ProofNode* node, const Premises& premises){
+    const ProofNode* witness;
+    hasWitnessAssumption(node, premises, witness);
+    return parentAssumptionUnionExcluding(node, {witness->formula.get()});
+}
+
+// Premise Roles ===============================================================
+
+/**
+ * @brief A premise of a rule and the necessary conditions a parent must meet
+ * to fill it. The conditions only prune assignments, the rule still checks
+ * every assignment, so they must never reject a parent the rule would accept.
+*/
+struct PremiseRole{
+    std::optional<Formula::Type> connective;            ///< top level connective of the premise
+    const Formula* (*expected)(const ProofNode* node);  ///< what the premise must equal, nullptr if unknown
+};
+
+/** @brief An inference rule, its premises, how it is checked and its assumptions */
+struct Rule{
+    std::vector<PremiseRole> roles;
+    VerifyResult (*check)(const ProofNode* node, const Premises& premises);
+    AssumptionSet (*assumptions)(const ProofNode* node, const Premises& premises);
+    bool readsAssumptions = false;      ///< whether check looks at the assumptions of premises
+};
+
+const Formula* conclusion(const ProofNode* node){
+    return node->formula.get();
+}
+
+/** @return the left operand of the conclusion if it has top level connective T */
+template<Formula::Type T>
+const Formula* conclusionLeft(const ProofNode* node){
+    return node->formula->type == T ? node->formula->binary->left : nullptr;
+}
+
+/** @return the right operand of the conclusion if it has top level connective T */
+template<Formula::Type T>
+const Formula* conclusionRight(const ProofNode* node){
+    return node->formula->type == T ? node->formula->binary->right : nullptr;
+}
+
+const std::unordered_map<Justification, Rule> RULES =
 {
-    {Justification::AndIntro, verifyAndIntro},
-    {Justification::AndElim, verifyAndElim},
-    {Justification::OrIntro, verifyOrIntro},
-    {Justification::OrElim, verifyOrElim},
-    {Justification::NotIntro, verifyNotIntro},
-    {Justification::NotElim, verifyNotElim},
-    {Justification::IfIntro, verifyIfIntro},
-    {Justification::IfElim, verifyIfElim},
-    {Justification::IffIntro, verifyIffIntro},
-    {Justification::IffElim, verifyIffElim}
+    {Justification::AndIntro, {
+        {{std::nullopt, conclusionLeft<Formula::Type::AND>}, {std::nullopt, conclusionRight<Formula::Type::AND>}},
+        verifyAndIntro, unionAssumptions}},
+    {Justification::AndElim, {
+        {{Formula::Type::AND, nullptr}},
+        verifyAndElim, unionAssumptions}},
+    {Justification::OrIntro, {
+        {{std::nullopt, nullptr}},
+        verifyOrIntro, unionAssumptions}},
+    {Justification::OrElim, {
+        {{Formula::Type::OR, nullptr}, {std::nullopt, conclusion}, {std::nullopt, conclusion}},
+        verifyOrElim, orElimAssumptions, true}},
+    {Justification::NotIntro, {
+        {{Formula::Type::NOT, nullptr}, {std::nullopt, nullptr}},
+        verifyNotIntro, notIntroAssumptions, true}},
+    {Justification::NotElim, {
+        {{Formula::Type::NOT, nullptr}, {std::nullopt, nullptr}},
+        verifyNotElim, notIntroAssumptions, true}},
+    {Justification::IfIntro, {
+        {{std::nullopt, conclusionRight<Formula::Type::IF>}},
+        verifyIfIntro, ifIntroAssumptions, true}},
+    {Justification::IfElim, {
+        {{std::nullopt, nullptr}, {std::nullopt, nullptr}},
+        verifyIfElim, unionAssumptions}},
+    {Justification::IffIntro, {
+        {{std::nullopt, conclusionLeft<Formula::Type::IF>}, {std::nullopt, conclusionRight<Formula::Type::IF>}},
+        verifyIffIntro, iffIntroAssumptions, true}},
+    {Justification::IffElim, {
+        {{std::nullopt, conclusionLeft<Formula::Type::IF>}, {std::nullopt, conclusionRight<Formula::Type::IF>}},
+        verifyIffElim, iffIntroAssumptions, true}},
+    {Justification::ForallIntro, {
+        {{std::nullopt, nullptr}},
+        verifyForallIntro, unionAssumptions, true}},
+    {Justification::ForallElim, {
+        {{Formula::Type::FORALL, nullptr}},
+        verifyForallElim, unionAssumptions}},
+    {Justification::ExistsIntro, {
+        {{std::nullopt, nullptr}},
+        verifyExistsIntro, unionAssumptions}},
+    {Justification::ExistsElim, {
+        {{Formula::Type::EXISTS, nullptr}, {std::nullopt, conclusion}},
+        verifyExistsElim, existsElimAssumptions, true}},
 };
 
-std::optional<std::string> verify(ProofNode* node){
+// Premise Matching ============================================================
+
+/**
+ * Assigns the parents of a node to the premise roles of its rule. Each role
+ * keeps the parents passing its connective and expected formula filters,
+ * comparing formula hashes before formulae, so the filters cost O(k^2) hash
+ * comparisons for k parents. Assignments of distinct candidates are then
+ * checked, most constrained role first, until one is accepted.
+ * @return true iff an assignment is accepted, premises holds it and
+ * assignment the index of the parent in each role
+*/
+bool matchPremises(const ProofNode* node, const Rule& rule, Premises& premises, std::vector<uint32_t>& assignment){
+    size_t k = rule.roles.size();
+    if(node->parents.size() != k){
+        return false;
+    }
+    std::vector<size_t> parentHashes;
+    std::vector<std::vector<uint32_t>> candidates(k);
+    for(size_t r = 0; r < k; r++){
+        const PremiseRole& role = rule.roles[r];
+        const Formula* expected = role.expected ? role.expected(node) : nullptr;
+        size_t expectedHash = 0;
+        if(expected != nullptr){
+            if(parentHashes.empty()){
+                for(const ProofNode* parent : node->parents){
+                    parentHashes.push_back(std::hash<Formula>()(*parent->formula));
+                }
+            }
+            expectedHash = std::hash<Formula>()(*expected);
+        }
+        for(uint32_t p = 0; p < k; p++){
+            const Formula* formula = node->parents[p]->formula.get();
+            if(role.connective && formula->type != *role.connective){
+                continue;
+            }
+            if(expected != nullptr && (parentHashes[p] != expectedHash || !(*formula == *expected))){
+                continue;
+            }
+            candidates[r].push_back(p);
+        }
+        if(candidates[r].empty()){
+            return false;
+        }
+    }
+
+    std::vector<uint32_t> order(k);
+    for(uint32_t r = 0; r < k; r++){
+        order[r] = r;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){
+        return candidates[a].size() < candidates[b].size();
+    });
+    //Depth first over the roles in order, choices[i] is the next candidate to try for order[i]
+    premises.assign(k, nullptr);
+    assignment.assign(k, 0);
+    std::vector<uint32_t> choices(k, 0);
+    std::vector<uint8_t> used(k, false);
+    size_t level = 0;
+    while(true){
+        if(level == k){
+            if(rule.check(node, premises).verified){
+                return true;
+            }
+            level--;
+        }
+        uint32_t role = order[level];
+        if(premises[role] != nullptr){
+            used[candidates[role][choices[level] - 1]] = false;
+            premises[role] = nullptr;
+        }
+        while(choices[level] < candidates[role].size() && used[candidates[role][choices[level]]]){
+            choices[level]++;
+        }
+        if(choices[level] == candidates[role].size()){
+            choices[level] = 0;
+            if(level == 0){
+                return false;
+            }
+            level--;
+            continue;
+        }
+        uint32_t parent = candidates[role][choices[level]++];
+        used[parent] = true;
+        premises[role] = node->parents[parent];
+        assignment[role] = parent;
+        level++;
+    }
+}
+
+/**
+ * @return the error of the assignment of parents to premises that fails
+ * deepest into the rule, the first in lexicographic order of assignments on
+ * a tie. assignment holds the index of the parent in each of its premises.
+*/
+VerifyError diagnose(const ProofNode* node, const Rule& rule, std::vector<uint32_t>& assignment){
+    Premises premises = node->parents;
+    std::vector<uint32_t> order(premises.size());
+    for(uint32_t i = 0; i < order.size(); i++){
+        order[i] = i;
+    }
+    //Every assignment fails the parent count alike
+    if(premises.size() != rule.roles.size()){
+        assignment = order;
+        return rule.check(node, premises).error.value();
+    }
+    VerifyResult best{false, 0, std::nullopt};
+    do{
+        for(size_t i = 0; i < order.size(); i++){
+            premises[i] = node->parents[order[i]];
+        }
+        VerifyResult result = rule.check(node, premises);
+        if(!best.error || result.depth > best.depth){
+            best = result;
+            assignment = order;
+        }
+    }while(std::next_permutation(order.begin(), order.end()));
+    return best.error.value();
+}
+
+// Memo Cache ==================================================================
+
+size_t VerifyCache::KeyHash::operator()(const Key& key) const{
+    size_t rv = key.conclusion;
+    hashCombine(rv, (size_t)key.justification);
+    for(size_t parent : key.parents){
+        hashCombine(rv, parent);
+    }
+    return rv;
+}
+
+VerifyCache::VerifyCache(size_t capacity, size_t shards) :
+    shardCapacity(std::max<size_t>(1, capacity / std::max<size_t>(1, shards))),
+    shards(std::max<size_t>(1, shards))
+{}
+
+VerifyCache::Shard& VerifyCache::shardOf(const Key& key){
+    //The low bits pick the bucket within a shard, so the shard takes the high ones
+    size_t hash = KeyHash()(key);
+    return shards[((hash >> 32) ^ (hash >> 48)) % shards.size()];
+}
+
+std::optional<VerifyCache::Entry> VerifyCache::find(const Key& key){
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto itr = shard.entries.find(key);
+    if(itr == shard.entries.end()){
+        return std::nullopt;
+    }
+    shard.order.splice(shard.order.begin(), shard.order, itr->second);
+    return itr->second->second;
+}
+
+void VerifyCache::insert(const Key& key, Entry entry){
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto itr = shard.entries.find(key);
+    if(itr != shard.entries.end()){
+        itr->second->second = std::move(entry);
+        shard.order.splice(shard.order.begin(), shard.order, itr->second);
+        return;
+    }
+    if(shard.entries.size() >= shardCapacity){
+        shard.entries.erase(shard.order.back().first);
+        shard.order.pop_back();
+        evictions++;
+    }
+    shard.order.emplace_front(key, std::move(entry));
+    shard.entries[key] = shard.order.begin();
+}
+
+VerifyCache::Stats VerifyCache::stats() const{
+    Stats rv{hits, misses, evictions, 0};
+    for(const Shard& shard : shards){
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        rv.entries += shard.entries.size();
+    }
+    return rv;
+}
+
+void VerifyCache::clear(){
+    for(Shard& shard : shards){
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+        shard.order.clear();
+    }
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
+
+VerifyCache::Key cacheKey(const ProofNode* node){
+    VerifyCache::Key key{node->justification, node->formulaHash, {}};
+    key.parents.reserve(node->parents.size());
+    for(const ProofNode* parent : node->parents){
+        key.parents.push_back(parent->formulaHash);
+    }
+    return key;
+}
+
+/**
+ * Verifies a node by the one assignment of a cache entry
+ * @return whether the rule reached the entry's verdict, if so the node's
+ * assumptions are set or err holds its error
+*/
+bool verifyFromEntry(ProofNode* node, const Rule& rule, const VerifyCache::Entry& entry,
+                     std::optional<VerifyError>& err){
+    Premises premises(entry.assignment.size());
+    for(size_t i = 0; i < premises.size(); i++){
+        premises[i] = node->parents[entry.assignment[i]];
+    }
+    VerifyResult result = rule.check(node, premises);
+    if(result.verified != entry.verified){
+        return false;
+    }
+    if(result.verified){
+        node->assumptions = rule.assumptions(node, premises);
+    }
+    err = std::move(result.error);
+    return true;
+}
+
+// Verification ================================================================
+
+std::optional<VerifyError> verifyNode(ProofNode* node, VerifyCache* cache){
     if(node->justification == Justification::Assumption){
-        VerifyResult result = verifyAssumption(node);
-        return result.verified ? std::nullopt : std::make_optional(result.errMsg);
+        return verifyAssumption(node).error;
+    }
+    const Rule& rule = RULES.at(node->justification);
+    std::optional<VerifyError> err;
+    VerifyCache::Key key;
+    if(cache != nullptr){
+        key = cacheKey(node);
+        std::optional<VerifyCache::Entry> entry = cache->find(key);
+        if(entry && verifyFromEntry(node, rule, *entry, err)){
+            cache->hits++;
+            return err;
+        }
+        cache->misses++;
+    }
+    Premises premises;
+    std::vector<uint32_t> assignment;
+    if(matchPremises(node, rule, premises, assignment)){
+        node->assumptions = rule.assumptions(node, premises);
+    }else{
+        err = diagnose(node, rule, assignment);
+    }
+    if(cache != nullptr && (!err || !rule.readsAssumptions)){
+        cache->insert(key, {!err, std::move(assignment)});
+    }
+    return err;
+}
+
+std::optional<std::string> verify(ProofNode* node){
+    std::optional<VerifyError> err = verifyNode(node);
+    return err ? std::make_optional(err->message()) : std::nullopt;
+}
+
+// Proof Graphs ================================================================
+
+/**
+ * The state of verifying a proof graph, indexed by the position of each node
+ * in order of id. Entries of a node are only written while verifying it.
+*/
+struct GraphVerification{
+    std::vector<ProofNode*> nodes;
+    std::unordered_map<const ProofNode*, uint32_t> index;
+    std::vector<NodeStatus> status;
+    std::vector<std::optional<VerifyError>> errors;
+    VerifyCache* cache = nullptr;
+};
+
+GraphVerification startVerification(ProofGraph& graph, VerifyCache* cache = nullptr){
+    GraphVerification v;
+    v.cache = cache;
+    v.nodes.reserve(graph.nodes.size());
+    for(const auto& [_, node] : graph.nodes){
+        v.nodes.push_back(node.get());
+    }
+    std::sort(v.nodes.begin(), v.nodes.end(), [](const ProofNode* a, const ProofNode* b){
+        return a->id < b->id;
+    });
+    v.index.reserve(v.nodes.size());
+    for(uint32_t i = 0; i < v.nodes.size(); i++){
+        v.index[v.nodes[i]] = i;
+    }
+    v.status.assign(v.nodes.size(), NodeStatus::UNREACHED);
+    v.errors.resize(v.nodes.size());
+    return v;
+}
+
+/**
+ * Verifies a node whose parents are all finished, a node with a parent that
+ * did not verify is not checked against its stale assumptions. The
+ * assumptions of a node that does not verify are cleared.
+ * @param verified whether a parent verified
+*/
+template<typename Verified>
+std::optional<VerifyError> verifyAfterParents(ProofNode* node, VerifyCache* cache, Verified verified){
+    std::optional<VerifyError> err;
+    for(const ProofNode* parent : node->parents){
+        if(!verified(parent)){
+            VerifyCondition condition{VerifyErrorCode::PARENT_FAILED};
+            condition.parent = parent->id;
+            err = VerifyError{node->justification, condition};
+            break;
+        }
+    }
+    if(!err){
+        err = verifyNode(node, cache);
+    }
+    if(err){
+        node->assumptions.clear();
+    }
+    return err;
+}
+
+void verifyReady(GraphVerification& v, uint32_t i){
+    std::optional<VerifyError> err = verifyAfterParents(v.nodes[i], v.cache, [&](const ProofNode* parent){
+        return v.status[v.index.at(parent)] == NodeStatus::VERIFIED;
+    });
+    if(err){
+        v.errors[i] = err;
+        v.status[i] = NodeStatus::FAILED;
     }else{
-        VerifyResult best = {false, 0, ""};
-        //iterates over all permutations of parents
-        do{
-            VerifyResult result = VERIFIERS.at(node->justification)(node);
-            if(result.verified){
-                return std::nullopt;
+        v.status[i] = NodeStatus::VERIFIED;
+    }
+}
+
+/** @brief Kahn's algorithm over children, verifying each node as it is ready */
+void verifySequential(GraphVerification& v){
+    std::vector<uint32_t> remaining(v.nodes.size());
+    std::vector<uint32_t> ready;
+    for(uint32_t i = 0; i < v.nodes.size(); i++){
+        remaining[i] = v.nodes[i]->parents.size();
+        if(remaining[i] == 0){
+            ready.push_back(i);
+        }
+    }
+    while(!ready.empty()){
+        uint32_t i = ready.back();
+        ready.pop_back();
+        verifyReady(v, i);
+        for(const ProofNode* child : v.nodes[i]->children){
+            uint32_t c = v.index.at(child);
+            if(--remaining[c] == 0){
+                ready.push_back(c);
             }
-            if(result.depth > best.depth){
-                best = result;
+        }
+    }
+}
+
+/**
+ * @brief Ready nodes of a worker, the owner pushes and pops at the back and
+ * other workers steal from the front, taking the work the owner would reach
+ * last.
+*/
+struct WorkQueue{
+    std::mutex mutex;
+    std::deque<uint32_t> nodes;
+};
+
+/**
+ * @brief Where idle workers sleep until nodes are released or the graph is done
+ * @details the epoch counts wakeups, a worker that read it before finding every
+ * queue empty only sleeps if nothing was released since.
+*/
+struct IdleWorkers{
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<uint64_t> epoch = 0;
+    std::atomic<size_t> sleeping = 0;
+
+    void notify(){
+        epoch.fetch_add(1);
+        if(sleeping.load() != 0){
+            std::lock_guard<std::mutex> lock(mutex);
+            wake.notify_all();
+        }
+    }
+
+    void wait(uint64_t seen){
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping.fetch_add(1);
+        wake.wait(lock, [&](){ return epoch.load() != seen; });
+        sleeping.fetch_sub(1);
+    }
+};
+
+/**
+ * @brief Kahn's algorithm as a wavefront over a pool of workers
+ * @details each node counts its unfinished links in, the worker finishing the
+ * last parent of a node releases it onto its own queue. Idle workers steal
+ * from the others, and sleep when there is nothing to steal until a node is
+ * released or none is queued or being verified.
+*/
+void verifyParallel(GraphVerification& v, size_t threads){
+    constexpr uint32_t NONE = UINT32_MAX;
+    std::vector<std::atomic<uint32_t>> remaining(v.nodes.size());
+    std::vector<WorkQueue> queues(threads);
+    std::atomic<size_t> pending = 0;    ///< queued or running nodes
+    IdleWorkers idle;
+    size_t next = 0;
+    for(uint32_t i = 0; i < v.nodes.size(); i++){
+        remaining[i].store(v.nodes[i]->parents.size(), std::memory_order_relaxed);
+        if(v.nodes[i]->parents.empty()){
+            queues[next++ % threads].nodes.push_back(i);
+            pending++;
+        }
+    }
+
+    auto worker = [&](size_t self){
+        std::vector<uint32_t> released;
+        while(true){
+            uint32_t i = NONE;
+            uint64_t seen = idle.epoch.load();
+            {
+                std::lock_guard<std::mutex> lock(queues[self].mutex);
+                if(!queues[self].nodes.empty()){
+                    i = queues[self].nodes.back();
+                    queues[self].nodes.pop_back();
+                }
+            }
+            for(size_t k = 1; i == NONE && k < threads; k++){
+                WorkQueue& victim = queues[(self + k) % threads];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if(!victim.nodes.empty()){
+                    i = victim.nodes.front();
+                    victim.nodes.pop_front();
+                }
+            }
+            if(i == NONE){
+                if(pending.load(std::memory_order_acquire) == 0){
+                    return;
+                }
+                idle.wait(seen);
+                continue;
+            }
+
+            verifyReady(v, i);
+            //Releasing orders this node's results before its children read them
+            released.clear();
+            for(const ProofNode* child : v.nodes[i]->children){
+                uint32_t c = v.index.at(child);
+                if(remaining[c].fetch_sub(1, std::memory_order_acq_rel) == 1){
+                    released.push_back(c);
+                }
+            }
+            if(!released.empty()){
+                pending.fetch_add(released.size(), std::memory_order_relaxed);
+                {
+                    std::lock_guard<std::mutex> lock(queues[self].mutex);
+                    queues[self].nodes.insert(queues[self].nodes.end(), released.begin(), released.end());
+                }
+                idle.notify();
+            }
+            if(pending.fetch_sub(1, std::memory_order_release) == 1){
+                idle.notify();
             }
-        }while(std::next_permutation(node->parents.begin(), node->parents.end()));
-        return std::make_optional(best.errMsg);
+        }
+    };
+    std::vector<std::thread> workers;
+    for(size_t t = 1; t < threads; t++){
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for(std::thread& t : workers){
+        t.join();
+    }
+}
+
+/** @brief Reports the nodes that were never ready as on or after a cycle */
+void finishUnreached(GraphVerification& v){
+    for(uint32_t i = 0; i < v.nodes.size(); i++){
+        if(v.status[i] == NodeStatus::UNREACHED){
+            v.nodes[i]->assumptions.clear();
+            v.errors[i] = cycleError(v.nodes[i]);
+        }
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @return the results as a json string conforming to res/VerifyResultsSchema.json
+ * @param message the message of the node at a position that did not verify
+*/
+template<typename Message>
+std::string writeResults(const GraphVerification& v, Message message){
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    std::vector<size_t> ids;
+    writer.StartObject();
+    writer.Key("assumptions");
+    writer.StartArray();
+    for(uint32_t i = 0; i < v.nodes.size(); i++){
+        if(v.status[i] != NodeStatus::VERIFIED){
+            continue;
+        }
+        ids.clear();
+        for(const ProofNode* assumption : v.nodes[i]->assumptions){
+            ids.push_back(assumption->id);
+        }
+        std::sort(ids.begin(), ids.end());
+        writer.StartObject();
+        writer.Key("id");
+        writer.Uint64(v.nodes[i]->id);
+        writer.Key("assumptions");
+        writer.StartArray();
+        for(size_t id : ids){
+            writer.Uint64(id);
+        }
+        writer.EndArray();
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.Key("errors");
+    writer.StartArray();
+    for(uint32_t i = 0; i < v.nodes.size(); i++){
+        if(v.status[i] == NodeStatus::VERIFIED){
+            continue;
+        }
+        writer.StartObject();
+        writer.Key("id");
+        writer.Uint64(v.nodes[i]->id);
+        writer.Key("message");
+        std::string text = message(i);
+        writer.String(text.c_str(), text.size());
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+std::string verifyProofGraph(ProofGraph& graph, size_t threads, VerifyCache* cache){
+    GraphVerification v = startVerification(graph, cache);
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if(threads == 1){
+        verifySequential(v);
+    }else{
+        verifyParallel(v, threads);
+    }
+    finishUnreached(v);
+    //Messages are only rendered here, while the formulae they mention still exist
+    return writeResults(v, [&](uint32_t i){
+        return v.errors[i]->message();
+    });
+}
+
+std::string verifyProofGraph(const std::string& jsonProofGraph, size_t threads, VerifyCache* cache){
+    std::unique_ptr<ProofGraph> graph(newProofGraph(jsonProofGraph));
+    return verifyProofGraph(*graph, threads, cache);
+}
+
+// Batches =====================================================================
+
+std::vector<BatchResult> verifyBatch(std::span<const std::string_view> jsonProofGraphs, size_t threads,
+                                     VerifyCache* cache){
+    std::vector<BatchResult> results(jsonProofGraphs.size());
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, jsonProofGraphs.size()));
+    //Graphs vary in size, so workers take the next one in turn rather than a share
+    std::atomic<size_t> next = 0;
+    auto worker = [&](){
+        std::unique_ptr<ProofGraphParser> parser;
+        for(size_t i = next++; i < jsonProofGraphs.size(); i = next++){
+            try{
+                if(!parser){
+                    parser.reset(new ProofGraphParser());
+                }
+                std::unique_ptr<ProofGraph> graph(parser->parse(jsonProofGraphs[i]));
+                results[i].results = verifyProofGraph(*graph, 1, cache);
+            }catch(const std::exception& e){
+                results[i].error = e.what();
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for(size_t t = 1; t < threads; t++){
+        workers.emplace_back(worker);
+    }
+    worker();
+    for(std::thread& t : workers){
+        t.join();
+    }
+    return results;
+}
+
+// Verification Sessions =======================================================
+
+/** @brief Nodes by increasing level, ties broken by id */
+using LevelQueue = std::priority_queue<
+    std::tuple<uint32_t, size_t, ProofNode*>,
+    std::vector<std::tuple<uint32_t, size_t, ProofNode*>>,
+    std::greater<std::tuple<uint32_t, size_t, ProofNode*>>
+>;
+
+VerificationSession::VerificationSession(ProofGraph& graph, VerifyCache* cache) : graph(graph), cache(cache){
+    //Kahn's algorithm, leveling and verifying each node as it is ready
+    std::unordered_map<const ProofNode*, size_t> remaining;
+    std::vector<ProofNode*> ready;
+    for(const auto& [_, node] : graph.nodes){
+        states[node.get()];
+        if(node->parents.empty()){
+            ready.push_back(node.get());
+        }else{
+            remaining[node.get()] = node->parents.size();
+        }
+    }
+    while(!ready.empty()){
+        ProofNode* node = ready.back();
+        ready.pop_back();
+        states.at(node).level = levelFromParents(node);
+        reverify(node);
+        for(ProofNode* child : node->children){
+            if(--remaining.at(child) == 0){
+                ready.push_back(child);
+            }
+        }
+    }
+    for(const auto& [_, node] : graph.nodes){
+        NodeState& state = states.at(node.get());
+        if(state.level == NO_LEVEL){
+            node->assumptions.clear();
+            state.error = cycleError(node.get()).message();
+            unreached.insert(node.get());
+        }
+    }
+    reverified = 0;
+}
+
+ProofNode* VerificationSession::nodeAt(size_t id) const{
+    auto itr = graph.nodes.find(id);
+    if(itr == graph.nodes.end()){
+        throw std::runtime_error("Verification Session Error: no proof node with id " + std::to_string(id));
+    }
+    return itr->second.get();
+}
+
+Justification justificationFromString(const std::string& justification){
+    auto itr = JUSTIFICATION_STRING_MAP.find(justification);
+    if(itr == JUSTIFICATION_STRING_MAP.end()){
+        throw std::runtime_error("Verification Session Error: unknown justification " + justification);
+    }
+    return itr->second;
+}
+
+void VerificationSession::setFormula(size_t id, const std::string& formula){
+    ProofNode* node = nodeAt(id);
+    node->setFormula(pFormula(fromSExpressionString(formula)));
+    dirty.insert(node);
+    //Children check the formulae of their parents
+    for(ProofNode* child : node->children){
+        dirty.insert(child);
+    }
+}
+
+void VerificationSession::setJustification(size_t id, const std::string& justification){
+    ProofNode* node = nodeAt(id);
+    node->justification = justificationFromString(justification);
+    dirty.insert(node);
+}
+
+void VerificationSession::addNode(size_t id, const std::string& formula, const std::string& justification){
+    if(graph.nodes.contains(id)){
+        throw std::runtime_error("Verification Session Error: proof node " + std::to_string(id) + " already exists");
+    }
+    justificationFromString(justification);
+    ProofNode* node = newProofNode(formula, justification, {}, graph.universe);
+    node->id = id;
+    graph.nodes[id] = pProofNode(node);
+    graph.assumptions.insert(node);
+    states[node].level = 0;
+    dirty.insert(node);
+}
+
+void VerificationSession::removeNode(size_t id){
+    ProofNode* node = nodeAt(id);
+    for(ProofNode* parent : node->parents){
+        parent->children.remove(node);
+    }
+    std::vector<ProofNode*> children(node->children.begin(), node->children.end());
+    std::sort(children.begin(), children.end());
+    children.erase(std::unique(children.begin(), children.end()), children.end());
+    for(ProofNode* child : children){
+        std::erase(child->parents, node);
+        if(child->parents.empty()){
+            graph.assumptions.insert(child);
+        }
+        dirty.insert(child);
+    }
+    states.erase(node);
+    unreached.erase(node);
+    dirty.erase(node);
+    graph.assumptions.erase(node);
+    graph.nodes.erase(id);
+
+    bool leveled = true;
+    for(ProofNode* child : children){
+        if(states.at(child).level == NO_LEVEL){
+            leveled = false;
+        }else{
+            relevel(child);
+        }
+    }
+    if(!leveled){
+        levelUnreached();
+    }
+}
+
+void VerificationSession::addLink(size_t from, size_t to){
+    ProofNode* parent = nodeAt(from);
+    ProofNode* child = nodeAt(to);
+    parent->children.push_back(child);
+    child->parents.push_back(parent);
+    graph.assumptions.erase(child);
+    dirty.insert(child);
+
+    uint32_t parentLevel = states.at(parent).level;
+    uint32_t childLevel = states.at(child).level;
+    if(childLevel == NO_LEVEL){
+        return;
+    }
+    //Levels increase along links, so a path back to the parent stays at or below its level
+    if(parentLevel == NO_LEVEL || (childLevel <= parentLevel && reaches(child, parent, parentLevel))){
+        markUnreached(child);
+    }else{
+        relevel(child);
+    }
+}
+
+void VerificationSession::removeLink(size_t from, size_t to){
+    ProofNode* parent = nodeAt(from);
+    ProofNode* child = nodeAt(to);
+    auto parentItr = std::find(child->parents.begin(), child->parents.end(), parent);
+    if(parentItr == child->parents.end()){
+        throw std::runtime_error("Verification Session Error: no link from " + std::to_string(from) +
+                                 " to " + std::to_string(to));
+    }
+    child->parents.erase(parentItr);
+    parent->children.erase(std::find(parent->children.begin(), parent->children.end(), child));
+    if(child->parents.empty()){
+        graph.assumptions.insert(child);
+    }
+    dirty.insert(child);
+    if(states.at(child).level == NO_LEVEL){
+        levelUnreached();
+    }else{
+        relevel(child);
+    }
+}
+
+std::vector<size_t> VerificationSession::update(){
+    LevelQueue ready;
+    std::unordered_set<const ProofNode*> queued;
+    std::vector<size_t> changed;
+    for(ProofNode* node : dirty){
+        NodeState& state = states.at(node);
+        if(state.level != NO_LEVEL){
+            ready.emplace(state.level, node->id, node);
+            queued.insert(node);
+        }else if(state.status != NodeStatus::UNREACHED){
+            node->assumptions.clear();
+            state.status = NodeStatus::UNREACHED;
+            state.error = cycleError(node).message();
+            changed.push_back(node->id);
+        }
+    }
+    dirty.clear();
+
+    //Parents have lower levels, so they are final before their children are verified
+    while(!ready.empty()){
+        ProofNode* node = std::get<2>(ready.top());
+        ready.pop();
+        if(!reverify(node)){
+            continue;
+        }
+        changed.push_back(node->id);
+        for(ProofNode* child : node->children){
+            if(states.at(child).level != NO_LEVEL && queued.insert(child).second){
+                ready.emplace(states.at(child).level, child->id, child);
+            }
+        }
+    }
+    std::sort(changed.begin(), changed.end());
+    return changed;
+}
+
+NodeStatus VerificationSession::status(size_t id) const{
+    return states.at(nodeAt(id)).status;
+}
+
+std::optional<std::string> VerificationSession::error(size_t id) const{
+    const NodeState& state = states.at(nodeAt(id));
+    if(state.status == NodeStatus::VERIFIED){
+        return std::nullopt;
+    }
+    return state.error;
+}
+
+std::string VerificationSession::results() const{
+    GraphVerification v = startVerification(graph);
+    for(uint32_t i = 0; i < v.nodes.size(); i++){
+        v.status[i] = states.at(v.nodes[i]).status;
+    }
+    return writeResults(v, [&](uint32_t i){
+        return states.at(v.nodes[i]).error;
+    });
+}
+
+uint32_t VerificationSession::levelFromParents(const ProofNode* node) const{
+    uint32_t level = 0;
+    for(const ProofNode* parent : node->parents){
+        uint32_t parentLevel = states.at(parent).level;
+        if(parentLevel == NO_LEVEL){
+            return NO_LEVEL;
+        }
+        level = std::max(level, parentLevel + 1);
+    }
+    return level;
+}
+
+/**
+ * Recomputes the level of a node with a level, and of its descendants while
+ * their levels change. Nodes are visited by their old levels, which still
+ * order the affected nodes after their parents, so each is leveled once.
+*/
+void VerificationSession::relevel(ProofNode* node){
+    LevelQueue queue;
+    std::unordered_set<const ProofNode*> queued = {node};
+    queue.emplace(states.at(node).level, node->id, node);
+    while(!queue.empty()){
+        ProofNode* n = std::get<2>(queue.top());
+        queue.pop();
+        NodeState& state = states.at(n);
+        uint32_t level = levelFromParents(n);
+        if(level == state.level){
+            continue;
+        }
+        state.level = level;
+        for(ProofNode* child : n->children){
+            uint32_t childLevel = states.at(child).level;
+            if(childLevel != NO_LEVEL && queued.insert(child).second){
+                queue.emplace(childLevel, child->id, child);
+            }
+        }
+    }
+}
+
+/** @brief Removes the levels of a node that is on or after a cycle and of its descendants */
+void VerificationSession::markUnreached(ProofNode* node){
+    std::vector<ProofNode*> stack = {node};
+    while(!stack.empty()){
+        ProofNode* n = stack.back();
+        stack.pop_back();
+        NodeState& state = states.at(n);
+        if(state.level == NO_LEVEL){
+            continue;
+        }
+        state.level = NO_LEVEL;
+        unreached.insert(n);
+        dirty.insert(n);
+        for(ProofNode* child : n->children){
+            stack.push_back(child);
+        }
+    }
+}
+
+/** @return whether a path leads from one node to another through nodes up to a level */
+bool VerificationSession::reaches(ProofNode* from, const ProofNode* to, uint32_t maxLevel) const{
+    std::unordered_set<const ProofNode*> visited = {from};
+    std::vector<ProofNode*> stack = {from};
+    while(!stack.empty()){
+        ProofNode* n = stack.back();
+        stack.pop_back();
+        if(n == to){
+            return true;
+        }
+        for(ProofNode* child : n->children){
+            if(states.at(child).level <= maxLevel && visited.insert(child).second){
+                stack.push_back(child);
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Kahn's algorithm over the nodes without levels after links into them are
+ * removed, levels the ones that are no longer on or after a cycle. Children
+ * of nodes without levels have none either, so only these nodes are visited.
+*/
+void VerificationSession::levelUnreached(){
+    std::unordered_map<const ProofNode*, size_t> remaining;
+    std::vector<ProofNode*> ready;
+    for(ProofNode* node : unreached){
+        size_t count = 0;
+        for(ProofNode* parent : node->parents){
+            count += unreached.contains(parent);
+        }
+        if(count == 0){
+            ready.push_back(node);
+        }else{
+            remaining[node] = count;
+        }
+    }
+    while(!ready.empty()){
+        ProofNode* node = ready.back();
+        ready.pop_back();
+        unreached.erase(node);
+        states.at(node).level = levelFromParents(node);
+        dirty.insert(node);
+        for(ProofNode* child : node->children){
+            if(--remaining.at(child) == 0){
+                ready.push_back(child);
+            }
+        }
+    }
+}
+
+/**
+ * Verifies a node whose parents are final
+ * @return whether its status, error or assumptions changed
+*/
+bool VerificationSession::reverify(ProofNode* node){
+    NodeState& state = states.at(node);
+    AssumptionSet assumptions = std::move(node->assumptions);
+    std::optional<VerifyError> err = verifyAfterParents(node, cache, [&](const ProofNode* parent){
+        return states.at(parent).status == NodeStatus::VERIFIED;
+    });
+    reverified++;
+    NodeStatus status = err ? NodeStatus::FAILED : NodeStatus::VERIFIED;
+    //Edits replace the formulae an error mentions, so the session keeps its text
+    std::string error = err ? err->message() : "";
+    bool changed = status != state.status || error != state.error || assumptions != node->assumptions;
+    state.status = status;
+    state.error = std::move(error);
+    return changed;
+}
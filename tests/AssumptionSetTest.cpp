@@ -0,0 +1,163 @@
+#include<set>
+#include<memory>
+#include<random>
+#include<vector>
+#include<cassert>
+#include<stdexcept>
+
+#include"ProofGraph.hpp"
+
+/** @return the members of a set, checking they come in order of number */
+std::set<ProofNode*> members(const AssumptionSet& set){
+    std::set<ProofNode*> rv;
+    uint32_t last = 0;
+    bool first = true;
+    for(auto itr = set.begin(); itr != set.end(); ++itr){
+        assert(first || itr.index > last);
+        first = false;
+        last = itr.index;
+        rv.insert(*itr);
+    }
+    return rv;
+}
+
+int main(){
+    //Enough nodes for tries of height 2
+    std::shared_ptr<AssumptionUniverse> universe = std::make_shared<AssumptionUniverse>();
+    std::vector<pProofNode> nodes;
+    for(size_t i = 0; i < 5000; i++){
+        nodes.emplace_back(new ProofNode(universe));
+        assert(nodes.back()->index == i);
+    }
+
+    std::mt19937 rng(1);
+    auto randomSet = [&](size_t size, std::set<ProofNode*>& model){
+        AssumptionSet rv;
+        for(size_t i = 0; i < size; i++){
+            ProofNode* node = nodes[rng() % (rng() % 2 ? 100 : nodes.size())].get();
+            rv = rv.unite(AssumptionSet::of(node));
+            model.insert(node);
+        }
+        return rv;
+    };
+
+    for(size_t round = 0; round < 200; round++){
+        std::set<ProofNode*> modelA, modelB;
+        AssumptionSet a = randomSet(rng() % 40, modelA);
+        AssumptionSet b = randomSet(rng() % 40, modelB);
+        assert(members(a) == modelA);
+        assert(a.size() == modelA.size());
+        assert(a.empty() == modelA.empty());
+
+        std::set<ProofNode*> modelUnion = modelA;
+        modelUnion.insert(modelB.begin(), modelB.end());
+        AssumptionSet u = a.unite(b);
+        assert(members(u) == modelUnion);
+        assert(u == b.unite(a));
+        assert(u.unite(a).root == u.root);
+
+        for(const pProofNode& node : nodes){
+            if(rng() % 16 == 0){
+                assert(u.contains(node.get()) == modelUnion.contains(node.get()));
+            }
+        }
+
+        //Filtering down to a set gives the same trie as building it
+        std::set<ProofNode*> modelKept;
+        AssumptionSet kept = u.filter([&](const ProofNode* node){
+            return node->index % 3 != 0;
+        });
+        AssumptionSet built;
+        for(ProofNode* node : modelUnion){
+            if(node->index % 3 != 0){
+                modelKept.insert(node);
+                built = built.unite(AssumptionSet::of(node));
+            }
+        }
+        assert(members(kept) == modelKept);
+        assert(kept == built);
+        assert(kept.height == built.height);
+        assert(u.filter([](const ProofNode*){ return true; }).root == u.root);
+        assert(u.filter([](const ProofNode*){ return false; }).empty());
+
+        //Intersections and differences give the same tries as building them
+        std::set<ProofNode*> modelCommon, modelOnlyA;
+        AssumptionSet builtCommon, builtOnlyA;
+        for(ProofNode* node : modelA){
+            if(modelB.contains(node)){
+                modelCommon.insert(node);
+                builtCommon = builtCommon.unite(AssumptionSet::of(node));
+            }else{
+                modelOnlyA.insert(node);
+                builtOnlyA = builtOnlyA.unite(AssumptionSet::of(node));
+            }
+        }
+        AssumptionSet common = a.intersect(b);
+        AssumptionSet onlyA = a.minus(b);
+        assert(members(common) == modelCommon);
+        assert(members(onlyA) == modelOnlyA);
+        assert(common == builtCommon && common.height == builtCommon.height);
+        assert(onlyA == builtOnlyA && onlyA.height == builtOnlyA.height);
+        assert(u.intersect(a).root == a.root);
+        assert(u.minus(AssumptionSet()).root == u.root);
+        assert(a.anyCommon(b, [](const ProofNode*){ return true; }) == !modelCommon.empty());
+        size_t visited = 0;
+        a.anyCommon(b, [&](const ProofNode* node){
+            assert(modelCommon.contains(const_cast<ProofNode*>(node)));
+            visited++;
+            return false;
+        });
+        assert(visited == modelCommon.size());
+    }
+
+    //A node inheriting its parent's assumptions shares them
+    {
+        AssumptionSet a = AssumptionSet::of(nodes[4999].get()).unite(AssumptionSet::of(nodes[3].get()));
+        AssumptionSet b = a.unite(AssumptionSet::of(nodes[3].get()));
+        assert(a.root == b.root);
+        assert(a.height == 2);
+        AssumptionSet low = a.filter([&](const ProofNode* node){ return node == nodes[3].get(); });
+        assert(low.height == 0);
+        assert(low == AssumptionSet::of(nodes[3].get()));
+        //Removing a higher set only looks at its numbers below this one
+        assert(low.minus(AssumptionSet::of(nodes[4999].get())).root == low.root);
+        assert(low.minus(a).empty());
+        assert(a.minus(low) == AssumptionSet::of(nodes[4999].get()));
+    }
+
+    //Sets of different universes can not be united
+    {
+        ProofNode other;
+        bool threw = false;
+        try{
+            AssumptionSet::of(&other).unite(AssumptionSet::of(nodes[0].get()));
+        }catch(const std::runtime_error&){
+            threw = true;
+        }
+        assert(threw);
+        assert(!AssumptionSet::of(nodes[0].get()).contains(&other));
+    }
+
+    //Nodes are indexed by the hash of their formula until they are freed
+    {
+        pProofNode p (new ProofNode(universe));
+        pProofNode q (new ProofNode(universe));
+        p->setFormula(pFormula(fromSExpressionString("(and A B)")));
+        q->setFormula(pFormula(fromSExpressionString("(and A B)")));
+        size_t hash = p->formulaHash;
+        assert(q->formulaHash == hash);
+        assert(members(universe->withFormulaHash(hash)) == std::set<ProofNode*>({p.get(), q.get()}));
+        q->setFormula(pFormula(fromSExpressionString("C")));
+        assert(members(universe->withFormulaHash(hash)) == std::set<ProofNode*>({p.get()}));
+        p.reset();
+        assert(universe->withFormulaHash(hash).empty());
+    }
+
+    //Freed numbers are not reused
+    size_t index = nodes.back()->index;
+    nodes.pop_back();
+    assert(universe->nodes[index] == nullptr);
+    pProofNode node (new ProofNode(universe));
+    assert(node->index == index + 3);
+    return 0;
+}
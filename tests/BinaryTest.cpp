@@ -0,0 +1,115 @@
+#include<cstdio>
+#include<string>
+#include<cassert>
+#include<stdexcept>
+
+#include "Binary.hpp"
+
+int main(){
+    //Round trips with and without sharing
+    pFormula f (fromSExpressionString(
+        "(forall x (if (and (P x (f x (g y))) (not (Q))) (exists y (and (P x (f x (g y))) (not (Q))))))"));
+    BinaryBuffer shared = serialize(f.get(), true);
+    BinaryBuffer unshared = serialize(f.get());
+    assert(shared.size() < unshared.size());
+    pFormula g (deserialize(shared));
+    pFormula h (deserialize(unshared));
+    assert(*f == *g);
+    assert(*f == *h);
+
+    //Several formulae share one symbol table and may reference each other
+    FormulaList formulae = {
+        fromSExpressionString("(and A (or B C))"),
+        fromSExpressionString("(not (or B C))"),
+        fromSExpressionString("D"),
+    };
+    BinaryBuffer image = serialize(formulae, true);
+    FormulaList loaded = deserializeAll(image);
+    assert(loaded.size() == 3);
+    for(auto a = formulae.begin(), b = loaded.begin(); a != formulae.end(); a++, b++){
+        assert(**a == **b);
+        delete *a;
+        delete *b;
+    }
+
+    //Arities past a byte take an extra word
+    std::string wide = "(P (f";
+    for(int i = 0; i < 300; i++){
+        wide += " c" + std::to_string(i % 7);
+    }
+    wide += "))";
+    pFormula w (fromSExpressionString(wide));
+    pFormula wLoaded (deserialize(serialize(w.get())));
+    assert(*w == *wLoaded);
+
+    //Malformed and mismatched images are rejected
+    bool threw = false;
+    try{
+        delete deserialize(image);
+    }catch(const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+    BinaryBuffer truncated(shared.begin(), shared.end() - 1);
+    threw = false;
+    try{
+        delete deserialize(truncated);
+    }catch(const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+    BinaryBuffer newer = shared;
+    newer[1] = BINARY_VERSION + 1;
+    threw = false;
+    try{
+        delete deserialize(newer);
+    }catch(const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+    //A reference to a shared record whose subtree is not yet decoded, here
+    //its own parent: a shared NOT (kind 1, flag 16) then a REF (kind 8) to it
+    pFormula notA (fromSExpressionString("(not A)"));
+    BinaryBuffer cyclic = serialize(notA.get());
+    cyclic.resize(cyclic.size() - 3);
+    cyclic.insert(cyclic.end(), {1 | 16, 8, 0});
+    threw = false;
+    try{
+        delete deserialize(cyclic);
+    }catch(const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+
+    //Proof graphs keep their ids, justifications and links
+    ProofGraph graph;
+    ProofNode* A = newProofNode("A", "Assumption", {});
+    ProofNode* B = newProofNode("B", "Assumption", {});
+    ProofNode* AB = newProofNode("(and A B)", "AndIntro", {A, B});
+    A->id = 7;
+    B->id = 3;
+    AB->id = 1;
+    for(ProofNode* node : {A, B, AB}){
+        graph.nodes[node->id] = pProofNode(node);
+    }
+    A->children.push_back(AB);
+    B->children.push_back(AB);
+
+    std::string path = "BinaryTest.slb";
+    writeBinaryFile(path, serialize(graph, true));
+    {
+        MappedBinaryFile file(path);
+        ProofGraph* copy = deserializeProofGraph(file.words());
+        assert(copy->nodes.size() == 3);
+        assert(copy->assumptions.size() == 2);
+        ProofNode* conclusion = copy->nodes.at(1).get();
+        assert(conclusion->justification == Justification::AndIntro);
+        assert(*conclusion->formula == *AB->formula);
+        assert(conclusion->parents.size() == 2);
+        assert(conclusion->parents[0] == copy->nodes.at(7).get());
+        assert(conclusion->parents[1] == copy->nodes.at(3).get());
+        assert(copy->nodes.at(3)->children.front() == conclusion);
+        delete copy;
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,112 @@
+#include<vector>
+#include<cassert>
+#include<stdexcept>
+
+#include "Congruence.hpp"
+
+/** @return f applied n times to a */
+Term* iterate(const std::string& f, size_t n, Term* a){
+    for(size_t i = 0; i < n; i++){
+        a = Func(f, {a});
+    }
+    return a;
+}
+
+int main(){
+    //f^3(a) = a and f^5(a) = a entail f(a) = a
+    {
+        CongruenceClosure closure;
+        pTerm a (Const("a"));
+        pTerm f3 (iterate("f", 3, Const("a")));
+        pTerm f5 (iterate("f", 5, Const("a")));
+        pTerm f1 (iterate("f", 1, Const("a")));
+        pTerm b (Const("b"));
+        assert(closure.addEquation(b.get(), b.get()) == 0);
+        assert(closure.addEquation(f3.get(), a.get()) == 1);
+        assert(!closure.equal(f1.get(), a.get()));
+        assert(closure.addEquation(f5.get(), a.get()) == 2);
+        assert(closure.equal(f1.get(), a.get()));
+        assert(closure.congruences > 0);
+        assert(closure.explain(f1.get(), a.get()) == std::vector<size_t>({1, 2}));
+        assert(closure.explain(a.get(), a.get()).empty());
+
+        //Terms interned after the merges join their congruent classes
+        pTerm f7 (iterate("f", 7, Const("a")));
+        pTerm g (Func("g", {iterate("f", 2, Const("a")), Const("a")}));
+        pTerm h (Func("g", {Const("a"), iterate("f", 4, Const("a"))}));
+        assert(closure.equal(f7.get(), a.get()));
+        assert(closure.equal(g.get(), h.get()));
+        assert(closure.explain(g.get(), h.get()) == std::vector<size_t>({1, 2}));
+
+        bool threw = false;
+        try{
+            closure.explain(a.get(), b.get());
+        }catch(const std::runtime_error&){
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    //Equations over formulae, as in eq(S(1), 2)
+    {
+        pFormula e1 (Pred("eq", {Func("S", {Const("1")}), Const("2")}));
+        pFormula e2 (Pred("eq", {Const("1"), Const("3")}));
+        pFormula e3 (Pred("eq", {Const("4"), Const("5")}));
+        pFormula query (Pred("eq", {Const("2"), Func("S", {Const("3")})}));
+        pFormula unrelated (Pred("eq", {Const("2"), Func("S", {Const("4")})}));
+        assert(entailsEquality({e1.get(), e2.get(), e3.get()}, query.get()));
+        assert(!entailsEquality({e1.get(), e3.get()}, query.get()));
+        assert(!entailsEquality({e1.get(), e2.get(), e3.get()}, unrelated.get()));
+
+        CongruenceClosure closure;
+        closure.addEquation(e3.get());
+        closure.addEquation(e1.get());
+        closure.addEquation(e2.get());
+        assert(closure.entails(query.get()));
+        //Only the equations used are in the explanation
+        assert(closure.explain(query->pred->args.front(), query->pred->args.back()) ==
+               std::vector<size_t>({1, 2}));
+
+        pFormula notEquality (Pred("lt", {Const("1"), Const("2")}));
+        bool threw = false;
+        try{
+            closure.addEquation(notEquality.get());
+        }catch(const std::runtime_error&){
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    //Functions of different arities are different symbols
+    {
+        CongruenceClosure closure;
+        pTerm fa (Func("f", {Const("a")}));
+        pTerm ga (Func("g", {Const("a")}));
+        pTerm fab (Func("f", {Const("a"), Const("b")}));
+        pTerm gab (Func("g", {Const("a"), Const("b")}));
+        pTerm f (Const("f"));
+        pTerm g (Const("g"));
+        closure.addEquation(fa.get(), ga.get());
+        assert(!closure.equal(fab.get(), gab.get()));
+        assert(!closure.equal(f.get(), g.get()));
+        closure.addEquation(f.get(), g.get());
+        assert(!closure.equal(fab.get(), gab.get()));
+    }
+
+    //Deep terms are interned and explained without recursion
+    {
+        CongruenceClosure closure;
+        pTerm a (Const("a"));
+        pTerm fa (Func("f", {Const("a")}));
+        pTerm deep (iterate("f", 100000, Const("a")));
+        pTerm deepB (iterate("f", 100000, Const("b")));
+        closure.addEquation(fa.get(), a.get());
+        assert(closure.equal(deep.get(), a.get()));
+        assert(!closure.equal(deepB.get(), a.get()));
+        pTerm b (Const("b"));
+        closure.addEquation(b.get(), a.get());
+        assert(closure.equal(deepB.get(), deep.get()));
+        assert(closure.explain(deepB.get(), deep.get()) == std::vector<size_t>({0, 1}));
+    }
+    return 0;
+}
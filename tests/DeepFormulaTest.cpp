@@ -0,0 +1,51 @@
+#include<cassert>
+#include<string>
+
+#include "Formula.hpp"
+#include "PersistentFormula.hpp"
+
+//Deep enough to overflow the call stack with recursive traversals
+const size_t DEPTH = 100000;
+
+int main(){
+    //(and P (and P ... (and P Q)))
+    std::string chain;
+    for(size_t i = 0; i < DEPTH; i++){
+        chain += "(and P ";
+    }
+    chain += "Q" + std::string(DEPTH, ')');
+
+    pFormula f (fromSExpressionString(chain));
+    assert(f->depth() == DEPTH + 1);
+    assert(f->allPredicates().size() == DEPTH + 1);
+    assert(f->isPropositional());
+    pFormula g (f->copy());
+    assert(*f == *g);
+    assert(toSExpression(g.get()) == chain);
+
+    PersistentFormula p (f.get());
+    pFormula h (p.toFormula());
+    assert(*h == *f);
+    assert(toSExpression(p) == chain);
+
+    //(forall x ... (forall x (P x (S ... (S 0)))))
+    std::string quantified;
+    for(size_t i = 0; i < DEPTH; i++){
+        quantified += "(forall x ";
+    }
+    quantified += "(P x ";
+    for(size_t i = 0; i < DEPTH; i++){
+        quantified += "(S ";
+    }
+    quantified += "0" + std::string(DEPTH, ')') + ")" + std::string(DEPTH, ')');
+
+    pFormula q (fromSExpressionString(quantified));
+    assert(q->depth() == DEPTH + 1);
+    assert(q->depthWithTerms() == 2 * DEPTH + 2);
+    assert(q->allFunctions().size() == DEPTH);
+    assert(q->allConstants().size() == 2);
+    assert(q->identifiers().size() == 4);
+    pFormula r (q->copy());
+    assert(*q == *r);
+    assert(toSExpression(r.get()) == quantified);
+}
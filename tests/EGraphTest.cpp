@@ -0,0 +1,127 @@
+#include<string>
+#include<cassert>
+#include<stdexcept>
+
+#include "EGraph.hpp"
+
+/** @return the S-Expression of the smallest term equal to term under rules */
+std::string smallest(const std::string& term, const std::vector<RewriteRuleSpec>& rules){
+    pTerm t (termFromSExpressionString(term));
+    pTerm rv (smallestEquivalent(t.get(), rules));
+    return toSExpression(rv.get());
+}
+
+int main(){
+    //Hash consing and congruence after a rebuild
+    {
+        EGraph graph;
+        pTerm fa (termFromSExpressionString("(f a)"));
+        pTerm fb (termFromSExpressionString("(f b)"));
+        pTerm gfa (termFromSExpressionString("(g (f a) (f a))"));
+        pTerm gfb (termFromSExpressionString("(g (f b) (f a))"));
+        pTerm a (Const("a"));
+        pTerm b (Const("b"));
+        uint32_t faId = graph.add(fa.get());
+        uint32_t fbId = graph.add(fb.get());
+        uint32_t gfaId = graph.add(gfa.get());
+        uint32_t gfbId = graph.add(gfb.get());
+        assert(graph.add(fa.get()) == faId);
+        assert(graph.nodeCount() == 6);
+        assert(graph.classCount == 6);
+
+        graph.merge(graph.add(a.get()), graph.add(b.get()));
+        assert(graph.find(faId) != graph.find(fbId));
+        graph.rebuild();
+        assert(graph.find(faId) == graph.find(fbId));
+        assert(graph.find(gfaId) == graph.find(gfbId));
+        assert(graph.classCount == 3);
+        assert(graph.nodeCount() == 4);
+        assert(graph.add(gfb.get()) == graph.find(gfaId));
+    }
+
+    //Peano arithmetic, commutativity and associativity are only usable in an e-graph
+    assert(smallest("(add (S 0) (S 0))", PEANO_RULES) == "(S (S 0))");
+    assert(smallest("(add 0 (S x))", PEANO_RULES) == "(S x)");
+    assert(smallest("(add (add x 0) (add 0 y))", PEANO_RULES) == "(add x y)");
+    assert(smallest("(mul (S (S 0)) (S (S 0)))", PEANO_RULES) == "(S (S (S (S 0))))");
+    assert(smallest("(mul 0 (add x y))", PEANO_RULES) == "0");
+    assert(smallest("(f (add x 0) (add x 0))", PEANO_RULES) == "(f x x)");
+
+    //Repeated pattern variables only match one e-class
+    {
+        std::vector<RewriteRuleSpec> rules = {{"SubSelf", "(sub ?x ?x)", "0"}};
+        assert(smallest("(sub (f a) (f a))", rules) == "0");
+        assert(smallest("(sub (f a) (f b))", rules) == "(sub (f a) (f b))");
+    }
+
+    //Costs steer extraction
+    {
+        EGraph graph;
+        pTerm term (termFromSExpressionString("(mul x (S (S 0)))"));
+        uint32_t id = graph.add(term.get());
+        graph.addRules(PEANO_RULES);
+        assert(graph.saturate() == SaturationStop::SATURATED);
+        pTerm small (graph.extract(id));
+        pTerm noAdd (graph.extract(id, {{"add", 100}}));
+        assert(toSExpression(small.get()) == "(add x x)");
+        std::string mul = toSExpression(noAdd.get());
+        assert(mul == "(mul x (S (S 0)))" || mul == "(mul (S (S 0)) x)");
+    }
+
+    //Budgets stop rules that grow the e-graph forever
+    {
+        EGraph graph;
+        pTerm term (Const("a"));
+        graph.add(term.get());
+        graph.addRule({"Grow", "a", "(f a)"});
+        SaturationLimits limits;
+        limits.nodes = 1000;
+        //Every iteration adds one e-node, f(a) = a collapses the e-graph
+        assert(graph.saturate(limits) == SaturationStop::SATURATED);
+        assert(graph.nodeCount() == 2);
+
+        EGraph growing;
+        pTerm x (Const("x"));
+        growing.add(x.get());
+        growing.addRule({"Grow", "(f ?x)", "(f (f ?x))"});
+        growing.addRule({"Start", "x", "(f x)"});
+        limits.iterations = 20;
+        assert(growing.saturate(limits) == SaturationStop::SATURATED);
+
+        EGraph wide;
+        pTerm y (termFromSExpressionString("(g x)"));
+        wide.add(y.get());
+        //g(x) = g(h(x)) = g(h(h(x))) = ... never saturates
+        wide.addRule({"Wrap", "(g ?x)", "(g (h ?x))"});
+        limits.nodes = 200;
+        limits.iterations = 1000;
+        assert(wide.saturate(limits) == SaturationStop::NODE_LIMIT);
+        assert(wide.nodeCount() >= 200);
+        limits.nodes = 1000000;
+        limits.iterations = 3;
+        assert(wide.saturate(limits) == SaturationStop::ITERATION_LIMIT);
+        limits.iterations = 1000;
+        limits.time = std::chrono::milliseconds(0);
+        assert(wide.saturate(limits) == SaturationStop::TIME_LIMIT);
+    }
+
+    //Malformed rules
+    {
+        EGraph graph;
+        bool threw = false;
+        try{
+            graph.addRule({"Any", "?x", "a"});
+        }catch(const std::runtime_error&){
+            threw = true;
+        }
+        assert(threw);
+        threw = false;
+        try{
+            graph.addRule({"Unbound", "(f ?x)", "(g ?y)"});
+        }catch(const std::runtime_error&){
+            threw = true;
+        }
+        assert(threw);
+    }
+    return 0;
+}
@@ -3,9 +3,7 @@
 #include<cassert>
 
 #include "Formula.hpp"
-
-//For the sake of testing
-using pFormula = std::unique_ptr<Formula>;
+#include "FormulaVisitor.hpp"
 
 int main(){
     pFormula f01 (Prop("A"));
@@ -93,6 +91,8 @@ int main(){
     assert(!f2->isZerothOrder());
     assert(!f2->isFirstOrder());
     assert(f2->isSecondOrder());
+    Formula::Classification c2 = f2->classify();
+    assert(!c2.propositional && !c2.zerothOrder && !c2.firstOrder && c2.secondOrder);
     assert(f2->allFunctions().size() == 1);
     assert(f2->allConstants().size() == 5);
     assert(f2->allPredicates().size() == 4);
@@ -110,6 +110,8 @@ int main(){
     assert(f3->allFunctions().size() == 0);
     assert(f3->allConstants().size() == 0);
     assert(f3->allPredicates().size() == 4);
+    assert(f3->allPropositions().size() == 4);
+    assert(f2->allPropositions().size() == 0);
     assert(!f3->isProposition());
 
     pFormula e1 (Prop("A"));
@@ -123,4 +125,45 @@ int main(){
     pFormula e5 (Exists("x", Forall("y", Pred("eq", {Var("x"), Var("y")}))));
     pFormula e6 (Exists("x", Forall("y", Pred("eq", {Var("x"), Var("y")}))));
     assert(*e5 == *e6);
-}
\ No newline at end of file
+
+    //Moves steal the subformulae, leaving an empty formula behind
+    pFormula m1 (And(Prop("A"), Pred("eq", {Func("S", {Const("1")}), Const("2")})));
+    Formula m2 (std::move(*m1));
+    assert(toSExpression(&m2) == "(and A (eq (S 1) 2))");
+    *m1 = std::move(m2);
+    assert(toSExpression(m1.get()) == "(and A (eq (S 1) 2))");
+    std::string tptpCopy = toFirstOrderTPTP("m1", "hypothesis", m1.get());
+    assert(toSExpression(m1.get()) == "(and A (eq (S 1) 2))");
+    assert(toFirstOrderTPTP("m1", "hypothesis", std::move(m1)) == tptpCopy);
+
+    //Visitors see connectives before their subformulae in pre-order and after them in post-order
+    struct OrderVisitor{
+        std::string order;
+        void onPred(const Formula* f){ order += f->pred->name; }
+        void onBinary(const Formula*){ order += '&'; }
+        void onUnary(const Formula*){ order += '~'; }
+    };
+    pFormula v1 (And(Not(Prop("A")), Prop("B")));
+    OrderVisitor pre, post;
+    assert(visit(v1.get(), pre) && pre.order == "&~AB");
+    assert(visitPostOrder(v1.get(), post) && post.order == "A~B&");
+
+    //Returning false from a hook stops the traversal
+    struct FindVisitor{
+        size_t seen = 0;
+        bool onPred(const Formula* f){ seen++; return f->pred->name != "A"; }
+    } finder;
+    assert(!visit((const Formula*)v1.get(), finder) && finder.seen == 1);
+
+    //The innermost quantifier binds a shadowed variable
+    pFormula s1 (Exists("x", And(Pred("P", {Var("x")}), Forall("x", Pred("Q", {Var("x"), Var("x")})))));
+    auto shadowed = s1->boundTermVariables();
+    assert(shadowed.size() == 3);
+    assert(shadowed.front().second == s1.get());
+    assert(shadowed.back().second == s1->quantifier->arg->binary->right);
+
+    //Free identifiers leave out names while a quantifier binds them
+    pFormula free1 (And(Forall("x", Pred("P", {Var("x"), Func("f", {Const("a")})})), Pred("Q", {Var("x")})));
+    assert(free1->freeIdentifiers() == std::unordered_set<std::string>({"P", "f", "a", "Q", "x"}));
+    assert(s1->freeIdentifiers() == std::unordered_set<std::string>({"P", "Q"}));
+}
@@ -0,0 +1,83 @@
+#include<cassert>
+#include<string>
+#include<cstdlib>
+#include<stdexcept>
+
+#include "NormalForm.hpp"
+
+/**
+ * @return true iff the assignment satisfies every clause, bit v - 1 of the
+ * assignment is the value of variable v
+*/
+bool cnfSatisfiable(const ClauseSet& cnf, unsigned assignment){
+    for(size_t i = 0; i < cnf.size(); i++){
+        bool satisfied = false;
+        for(int literal : cnf.clause(i)){
+            bool value = (assignment >> (std::abs(literal) - 1)) & 1;
+            if(value == (literal > 0)){
+                satisfied = true;
+                break;
+            }
+        }
+        if(!satisfied){
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(){
+    //Negations are pushed to the predicates
+    pFormula f1 (fromSExpressionString("(not (if A (or B (not C))))"));
+    pFormula n1 (toNNF(f1.get()));
+    assert(toSExpression(n1.get()) == "(and A (and (not B) C))");
+
+    pFormula f2 (fromSExpressionString("(not (forall x (iff (P x) Q)))"));
+    pFormula n2 (toNNF(f2.get()));
+    assert(toSExpression(n2.get()) == 
+           "(exists x (or (and (P x) (not Q)) (and (not (P x)) Q)))");
+
+    //Clashing and free variable names are renamed before quantifiers are pulled out
+    pFormula f3 (fromSExpressionString("(and (P x) (or (forall x (Q x)) (not (forall x (R x)))))"));
+    pFormula p3 (toPrenex(f3.get()));
+    assert(toSExpression(p3.get()) == 
+           "(forall x1 (exists x2 (and (P x) (or (Q x1) (not (R x2))))))");
+
+    //Tseitin CNF is equisatisfiable, check every assignment of the atoms
+    pFormula f4 (fromSExpressionString("(iff (and A B) (or (not A) (if B (and A B))))"));
+    ClauseSet cnf = toCNF(f4.get());
+    assert(cnf.atoms[0] && cnf.atoms[1]);
+    size_t atoms = 2;
+    for(unsigned a = 0; a < (1u << atoms); a++){
+        bool A = a & 1, B = a & 2;
+        bool truth = (A && B) == (!A || (!B || (A && B)));
+        bool satisfiable = false;
+        for(unsigned d = 0; d < (1u << (cnf.variables() - atoms)); d++){
+            satisfiable = satisfiable || cnfSatisfiable(cnf, a | (d << atoms));
+        }
+        assert(truth == satisfiable);
+    }
+
+    //Shared subformulae are defined once
+    pFormula f5 (fromSExpressionString("(or (and A B) (and B A))"));
+    ClauseSet shared = toCNF(f5.get());
+    assert(shared.variables() == 4);
+
+    //DNF drops contradictory cubes
+    pFormula f6 (fromSExpressionString("(and (or A B) (or A (not B)))"));
+    ClauseSet dnf = toDNF(f6.get());
+    assert(dnf.size() == 3);
+    assert(dnf.clause(0).size() == 1);
+
+    //DNF conversion is bounded
+    pFormula f7 (fromSExpressionString(
+        "(and (or A B) (and (or C D) (and (or E F) (or G H))))"));
+    bool threw = false;
+    try{
+        toDNF(f7.get(), 8);
+    }catch(std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+    assert(toDNF(f7.get(), 16).size() == 16);
+}
@@ -0,0 +1,44 @@
+#include<cassert>
+#include<queue>
+
+#include "PersistentFormula.hpp"
+
+int main(){
+    pFormula f (fromSExpressionString("(and (or A (P x)) (forall y (if (Q y) B)))"));
+    PersistentFormula p1 (f.get());
+    assert(toSExpression(p1) == toSExpression(f.get()));
+    
+    //Copies share the root
+    PersistentFormula p2 = p1.copy();
+    assert(p2.root == p1.root);
+    assert(p1 == p2);
+
+    //Positions index immediate subformulae, quantifier bodies are index 0
+    std::queue<size_t> pos({1, 0, 1});
+    assert(toSExpression(p1.atPosition(pos)) == "B");
+
+    //Edits rebuild only the spine and leave the original untouched
+    pFormula c (Prop("C"));
+    PersistentFormula p3 = p1.replaceAt(pos, PersistentFormula(c.get()));
+    assert(toSExpression(p3) == "(and (or A (P x)) (forall y (if (Q y) C)))");
+    assert(toSExpression(p1) == "(and (or A (P x)) (forall y (if (Q y) B)))");
+    assert(!(p1 == p3));
+    assert(p3.root != p1.root);
+    assert(p3.subformula(0).root == p1.subformula(0).root);
+    assert(p3.subformula(1).root != p1.subformula(1).root);
+    std::queue<size_t> qPos({1, 0, 0});
+    assert(p3.atPosition(qPos).root == p1.atPosition(qPos).root);
+
+    //Round trip back to a mutable formula
+    pFormula f3 (p3.toFormula());
+    assert(toSExpression(f3.get()) == toSExpression(p3));
+
+    //Invalid positions throw
+    bool threw = false;
+    try{
+        p1.replaceAt(std::queue<size_t>({0, 0, 0}), p1);
+    }catch(const std::out_of_range&){
+        threw = true;
+    }
+    assert(threw);
+}
@@ -0,0 +1,69 @@
+#include<string>
+#include<cassert>
+#include<stdexcept>
+
+#include "Rewrite.hpp"
+
+/** @return the S-Expression of the simplified formula */
+std::string simplified(const std::string& formula){
+    pFormula f (fromSExpressionString(formula));
+    pFormula rv (simplify(f.get()));
+    return toSExpression(rv.get());
+}
+
+int main(){
+    assert(simplified("(not (not (not (not A))))") == "A");
+    assert(simplified("(and A A)") == "A");
+
+    //Commutative patterns match with their operands swapped
+    assert(simplified("(and (or B A) A)") == "A");
+    assert(simplified("(or (and A B) A)") == "A");
+
+    //Constants fold through the whole formula
+    assert(simplified("(and (or P true) (not false))") == "true");
+    assert(simplified("(or (and P (not P)) (if Q false))") == "(not Q)");
+    assert(simplified("(iff (forall x (P x)) (forall x (P x)))") == "true");
+    assert(simplified("(exists x (and (P x) true))") == "(exists x (P x))");
+
+    //Repeated metavariables only match equal subformulae
+    assert(simplified("(and (P x) (P y))") == "(and (P x) (P y))");
+
+    Rewriter eliminate;
+    eliminate.addRules(CONDITIONAL_ELIMINATION_RULES);
+    pFormula iff (fromSExpressionString("(iff A B)"));
+    pFormula eliminated (eliminate.rewrite(iff.get()));
+    assert(toSExpression(eliminated.get()) == "(and (or (not A) B) (or A (not B)))");
+
+    //Shared subformulae are normalized once
+    Rewriter rewriter;
+    rewriter.addRules(DOUBLE_NEGATION_RULES);
+    std::string shared = "(not (not A))";
+    for(int i = 0; i < 12; i++){
+        shared = "(and " + shared + " " + shared + ")";
+    }
+    pFormula wide (fromSExpressionString(shared));
+    pFormula result (rewriter.rewrite(wide.get()));
+    assert(rewriter.rewrites == 1);
+    pFormula again (rewriter.rewrite(wide.get()));
+    assert(rewriter.rewrites == 1);
+    assert(*result == *again);
+
+    Rewriter cyclic;
+    cyclic.addRule({"Commute", "(and ?x ?y)", "(and ?y ?x)"});
+    pFormula conjunction (fromSExpressionString("(and A B)"));
+    bool threw = false;
+    try{
+        delete cyclic.rewrite(conjunction.get());
+    }catch(const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try{
+        cyclic.addRule({"Unbound", "(not ?x)", "?y"});
+    }catch(const std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+}
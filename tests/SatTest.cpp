@@ -0,0 +1,100 @@
+#include<random>
+#include<vector>
+#include<cassert>
+#include<cstdlib>
+
+#include "Sat.hpp"
+
+/** @return n + 1 pigeons in n holes, unsatisfiable */
+ClauseSet pigeonhole(int holes){
+    ClauseSet rv;
+    auto var = [holes](int pigeon, int hole){ return pigeon * holes + hole + 1; };
+    for(int p = 0; p <= holes; p++){
+        std::vector<int> clause;
+        for(int h = 0; h < holes; h++){
+            clause.push_back(var(p, h));
+        }
+        rv.addClause(clause);
+    }
+    for(int h = 0; h < holes; h++){
+        for(int p = 0; p <= holes; p++){
+            for(int q = p + 1; q <= holes; q++){
+                rv.addClause({-var(p, h), -var(q, h)});
+            }
+        }
+    }
+    return rv;
+}
+
+bool satisfies(const SatSolver& solver, const ClauseSet& cnf){
+    for(size_t i = 0; i < cnf.size(); i++){
+        bool satisfied = false;
+        for(int literal : cnf.clause(i)){
+            satisfied = satisfied || solver.value(std::abs(literal)) == (literal > 0);
+        }
+        if(!satisfied){
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(){
+    SatSolver php(pigeonhole(5));
+    assert(php.solve() == SatResult::UNSAT);
+
+    //Random 3-SAT near the threshold, check answers against brute force
+    std::mt19937 rng(42);
+    const int n = 12;
+    for(int instance = 0; instance < 50; instance++){
+        ClauseSet cnf;
+        std::uniform_int_distribution<int> variable(1, n);
+        for(int c = 0; c < 51; c++){
+            cnf.addClause({variable(rng) * (rng() % 2 ? 1 : -1),
+                           variable(rng) * (rng() % 2 ? 1 : -1),
+                           variable(rng) * (rng() % 2 ? 1 : -1)});
+        }
+        bool bruteForce = false;
+        for(unsigned a = 0; a < (1u << n) && !bruteForce; a++){
+            bool all = true;
+            for(size_t i = 0; i < cnf.size() && all; i++){
+                bool any = false;
+                for(int literal : cnf.clause(i)){
+                    any = any || (bool)((a >> (std::abs(literal) - 1)) & 1) == (literal > 0);
+                }
+                all = any;
+            }
+            bruteForce = all;
+        }
+        SatSolver solver(cnf);
+        SatResult result = solver.solve();
+        assert((result == SatResult::SAT) == bruteForce);
+        assert(result != SatResult::SAT || satisfies(solver, cnf));
+    }
+
+    //Clauses can be added after solving
+    SatSolver incremental;
+    incremental.addClause(std::vector<int>{1, 2});
+    assert(incremental.solve() == SatResult::SAT);
+    incremental.addClause(std::vector<int>{-1});
+    assert(incremental.solve() == SatResult::SAT && incremental.value(2));
+    incremental.addClause(std::vector<int>{-2});
+    assert(incremental.solve() == SatResult::UNSAT);
+
+    pFormula deMorgan (fromSExpressionString("(iff (not (and A B)) (or (not A) (not B)))"));
+    assert(isTautology(deMorgan.get()));
+    pFormula contingent (fromSExpressionString("(if A B)"));
+    assert(!isTautology(contingent.get()));
+
+    //Modus ponens, quantified subformulae are atoms
+    pFormula premise (fromSExpressionString("(and (forall x (P x)) (if (forall x (P x)) Q))"));
+    pFormula conclusion (Prop("Q"));
+    assert(entails(premise.get(), conclusion.get()));
+    assert(!entails(conclusion.get(), premise.get()));
+
+    pFormula a (fromSExpressionString("(if A B)"));
+    pFormula b (fromSExpressionString("(or (not A) B)"));
+    pFormula c (fromSExpressionString("(if B A)"));
+    assert(equivalent(a.get(), b.get()));
+    assert(!equivalent(a.get(), c.get()));
+}
@@ -0,0 +1,107 @@
+#include<string>
+#include<vector>
+#include<cassert>
+#include<sstream>
+#include<stdexcept>
+
+#include "TPTP.hpp"
+
+/** @return true iff reading the problem throws */
+bool rejects(const std::string& problem){
+    try{
+        parseTPTP(problem);
+    }catch(const std::runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+int main(){
+    //Output of the exporter reads back, with the quotes of constants removed
+    pFormula f (Forall("X", If(Pred("p", {Var("X"), Const("a")}), Exists("Y", Pred("q", {Func("f", {Var("Y")})})))));
+    std::vector<TPTPInput> inputs = parseTPTP(toFirstOrderTPTP("ax1", "axiom", f.get()));
+    assert(inputs.size() == 1);
+    assert(inputs[0].language == "fof" && inputs[0].name == "ax1" && inputs[0].role == "axiom");
+    assert(*inputs[0].formula == *f);
+
+    std::string problem =
+        "% A comment\n"
+        "fof(a, axiom, ! [X, Y] : (X = Y => (p(X) <= q))). /* block\n comment */\n"
+        "fof('quoted name', conjecture, (a & b & ~c) <~> (d ~| $true), file('x.p', [a, b])).\n"
+        "cnf(c1, negated_conjecture, (p(X, f(Y)) | ~ q(Y) | X != \"c\")).\n";
+    inputs = parseTPTP(problem);
+    assert(inputs.size() == 3);
+    assert(toSExpression(inputs[0].formula.get()) ==
+           "(forall X (forall Y (if (eq X Y) (if q (p X)))))");
+    assert(inputs[1].name == "quoted name" && inputs[1].role == "conjecture");
+    assert(toSExpression(inputs[1].formula.get()) ==
+           "(not (iff (and (and a b) (not c)) (not (or d true))))");
+    assert(inputs[2].language == "cnf");
+    assert(toSExpression(inputs[2].formula.get()) ==
+           "(forall X (forall Y (or (or (p X (f Y)) (not (q Y))) (not (eq X c)))))");
+
+    //Reading in tiny chunks splits tokens across refills
+    std::istringstream stream(problem);
+    TPTPReader reader(stream, 3);
+    TPTPInput input;
+    for(const TPTPInput& expected : inputs){
+        assert(reader.next(input));
+        assert(*input.formula == *expected.formula);
+    }
+    assert(!reader.next(input));
+    assert(reader.line == 6);
+
+    //Deep nesting does not recurse
+    std::string deep = "fof(deep, axiom, ";
+    for(int i = 0; i < 100000; i++){
+        deep += "~ (";
+    }
+    deep += "p(" + std::string(100000, 's') + ")";
+    for(int i = 0; i < 100000; i++){
+        deep += ")";
+    }
+    deep += ").";
+    assert(parseTPTP(deep)[0].formula->depth() == 100001);
+
+    //Identifiers are legalized as they are printed
+    const char* exported[][2] = {
+        {"(forall x (if (P x a) (exists y (Q (f x y) b))))",
+         "fof(n,axiom,(! [X] : (p(X, \"a\")=>(? [Y] : q(f(X, Y), \"b\"))))).\n"},
+        {"(exists 9v (iff (P 9v) (forall v (P v 9v))))",
+         "fof(n,axiom,(? [S9V] : (p(S9V)<=>(! [V] : p(V, S9V))))).\n"},
+        {"(and (P x) (forall x (P x)))",
+         "fof(n,axiom,(p(\"x\")&(! [X] : p(X)))).\n"},
+        {"(R c-1 (g_2 ?z))",
+         "fof(n,axiom,r(\"c-1\", g2(\"?z\"))).\n"},
+    };
+    std::ostringstream out;
+    {
+        TPTPWriter writer(out, 16);
+        for(auto [expr, _] : exported){
+            pFormula formula (fromSExpressionString(expr));
+            writer.write("n", "axiom", formula.get());
+        }
+        //Second order formulae are rejected without writing anything
+        pFormula secondOrder (fromSExpressionString("(and A (forall P (P a)))"));
+        bool threw = false;
+        try{
+            writer.write("n", "axiom", secondOrder.get());
+        }catch(const std::runtime_error&){
+            threw = true;
+        }
+        assert(threw);
+        assert(writer.formulae == 4);
+    }
+    std::string expected;
+    for(auto [_, tptp] : exported){
+        expected += tptp;
+    }
+    assert(out.str() == expected);
+
+    assert(rejects("include('Axioms/SET001.ax')."));
+    assert(rejects("tff(a, axiom, p)."));
+    assert(rejects("fof(a, axiom, a => b => c)."));
+    assert(rejects("fof(a, axiom, a & b | c)."));
+    assert(rejects("fof(a, axiom, p(X)"));
+    assert(rejects("fof(a, axiom, X)."));
+}
@@ -0,0 +1,53 @@
+#include<bit>
+#include<string>
+#include<cassert>
+#include<stdexcept>
+
+#include "TruthTable.hpp"
+
+int main(){
+    pFormula deMorgan (fromSExpressionString("(iff (not (and A B)) (or (not A) (not B)))"));
+    TruthTable t1 = truthTable(deMorgan.get());
+    assert(t1.atoms.size() == 2);
+    assert(t1.isTautology());
+
+    pFormula contradiction (fromSExpressionString("(and A (not A))"));
+    assert(!truthTable(contradiction.get()).isSatisfiable());
+
+    //Atom i is bit i of the assignment
+    pFormula disjunction (fromSExpressionString("(or A (and B (not A)))"));
+    TruthTable t2 = truthTable(disjunction.get());
+    assert(t2.models() == 3);
+    assert(!t2.value(0) && t2.value(1) && t2.value(2) && t2.value(3));
+
+    //Parity over 10 atoms spans several words and blocks
+    std::string parity = "P0";
+    for(int i = 1; i < 10; i++){
+        parity = "(iff P" + std::to_string(i) + " (not " + parity + "))";
+    }
+    pFormula xorChain (fromSExpressionString(parity));
+    TruthTable t3 = truthTable(xorChain.get());
+    assert(t3.assignments() == 1024);
+    assert(t3.models() == 512);
+    for(size_t a = 0; a < t3.assignments(); a++){
+        assert(t3.value(a) == (std::popcount(a) % 2 == 1));
+    }
+
+    //Equivalence is checked over the union of the atoms
+    pFormula a (fromSExpressionString("(if A B)"));
+    pFormula b (fromSExpressionString("(or (not A) B)"));
+    pFormula c (fromSExpressionString("(or (not A) (and B (or C (not C))))"));
+    pFormula d (fromSExpressionString("(if B A)"));
+    assert(truthTableEquivalent(a.get(), b.get()));
+    assert(truthTableEquivalent(a.get(), c.get()));
+    assert(!truthTableEquivalent(a.get(), d.get()));
+
+    pFormula firstOrder (fromSExpressionString("(forall x (P x))"));
+    bool threw = false;
+    try{
+        truthTable(firstOrder.get());
+    }catch(std::runtime_error&){
+        threw = true;
+    }
+    assert(threw);
+}
@@ -1,11 +1,59 @@
 
 #include<cassert>
+#include<algorithm>
+#include<memory>
+#include<random>
+#include<string>
+#include<vector>
 #include<optional>
+#include<string_view>
+#include<stdexcept>
+
+#include<rapidjson/document.h>
 
 #include"verify.hpp"
 
 
 
+/**
+ * @return the json of a random proof graph of conjunctions of assumptions and
+ * their eliminations, some eliminations are wrong and fail along with their
+ * descendants
+*/
+std::string randomProofGraph(size_t size, unsigned seed){
+    std::mt19937 rng(seed);
+    std::string nodes, links;
+    std::vector<std::string> formulas;
+    auto addNode = [&](const std::string& formula, const std::string& justification){
+        if(!formulas.empty()){
+            nodes += ",";
+        }
+        nodes += "{\"id\": " + std::to_string(formulas.size()) + ", \"formula\": \"" + formula +
+                 "\", \"justification\": \"" + justification + "\"}";
+        formulas.push_back(formula);
+        return formulas.size() - 1;
+    };
+    auto addLink = [&](size_t from, size_t to){
+        links += std::string(links.empty() ? "" : ",") + "{\"from\": " + std::to_string(from) +
+                 ", \"to\": " + std::to_string(to) + "}";
+    };
+    std::vector<size_t> atoms;
+    for(size_t i = 0; i < size / 4 + 2; i++){
+        atoms.push_back(addNode("P" + std::to_string(i), "Assumption"));
+    }
+    while(formulas.size() < size){
+        size_t left = atoms[rng() % atoms.size()];
+        size_t right = atoms[rng() % atoms.size()];
+        size_t conjunction = addNode("(and " + formulas[left] + " " + formulas[right] + ")", "AndIntro");
+        addLink(left, conjunction);
+        addLink(right, conjunction);
+        size_t elim = addNode(rng() % 8 == 0 ? "Q" : formulas[left], "AndElim");
+        addLink(conjunction, elim);
+        atoms.push_back(elim);
+    }
+    return "{\"nodes\": [" + nodes + "], \"links\": [" + links + "]}";
+}
+
 int main(){
     //Assumptions, and intro, or intro
     ProofNode* A = newProofNode("A", "Assumption", {});
@@ -25,4 +73,404 @@ int main(){
     assert(verify(A2) == std::nullopt);
     assert(verify(AQ) == std::nullopt);
     assert(verify(ifAAQ) == std::nullopt);
-}
\ No newline at end of file
+
+    //Parents are matched to premises in any order
+    ProofNode* BA = newProofNode("(and B A)", "AndIntro", {A, B});
+    assert(verify(BA) == std::nullopt);
+    assert(BA->parents[0] == A);
+
+    //OrElim with its disjunction between the cases
+    ProofNode* P = newProofNode("P", "Assumption", {});
+    ProofNode* Q = newProofNode("Q", "Assumption", {});
+    ProofNode* PQ = newProofNode("(or P Q)", "Assumption", {});
+    ProofNode* QP1 = newProofNode("(or Q P)", "OrIntro", {P});
+    ProofNode* QP2 = newProofNode("(or Q P)", "OrIntro", {Q});
+    ProofNode* QP = newProofNode("(or Q P)", "OrElim", {QP2, PQ, QP1});
+    assert(verify(P) == std::nullopt);
+    assert(verify(Q) == std::nullopt);
+    assert(verify(PQ) == std::nullopt);
+    assert(verify(QP1) == std::nullopt);
+    assert(verify(QP2) == std::nullopt);
+    assert(verify(QP) == std::nullopt);
+    //Both case assumptions are discharged, only the disjunction remains
+    assert(QP->assumptions.size() == 1 && QP->assumptions.contains(PQ));
+
+    //Rejections still report the assignment failing deepest into the rule
+    ProofNode* AA = newProofNode("(and A B)", "AndIntro", {A, A});
+    std::optional<std::string> err = verify(AA);
+    assert(err && *err == "expected B to equal A.");
+    ProofNode* wrongCount = newProofNode("(and A B)", "AndIntro", {A});
+    err = verify(wrongCount);
+    assert(err && err->find("to have 2 parents but it has 1 parents") != std::string::npos);
+
+    //Errors are structured, their messages are built on demand
+    std::optional<VerifyError> error = verifyNode(AA);
+    assert(error && error->rule == Justification::AndIntro && !error->alternative);
+    assert(error->condition.code == VerifyErrorCode::NOT_EQUAL);
+    assert(error->condition.roles[0] == VerifyCondition::CONCLUSION && error->condition.roles[1] == 1);
+    assert(error->condition.formulas[1] == A->formula.get());
+    assert(error->message() == "expected B to equal A.");
+    error = verifyNode(wrongCount);
+    assert(error && error->condition.code == VerifyErrorCode::PARENT_COUNT);
+    assert(error->condition.expected == 2 && error->condition.actual == 1);
+    ProofNode* wrongElim = newProofNode("C", "AndElim", {AB});
+    error = verifyNode(wrongElim);
+    assert(error && error->alternative && error->alternative->code == VerifyErrorCode::NOT_EQUAL);
+    assert(error->message() == "Either expected C to equal A or expected C to equal B.");
+
+    //Quantifier eliminations and existential introductions match instances
+    {
+        ProofNode* all = newProofNode("(forall x (and (P x) (forall x (Q x))))", "Assumption", {});
+        ProofNode* inst = newProofNode("(and (P (f a)) (forall x (Q x)))", "ForallElim", {all});
+        ProofNode* mixed = newProofNode("(and (P a) (forall x (Q a)))", "ForallElim", {all});
+        assert(verify(all) == std::nullopt);
+        assert(verify(inst) == std::nullopt);
+        error = verifyNode(mixed);
+        assert(error && error->condition.code == VerifyErrorCode::NOT_INSTANCE);
+        ProofNode* some = newProofNode("(forall x (exists y (R x y)))", "Assumption", {});
+        ProofNode* captured = newProofNode("(exists y (R y y))", "ForallElim", {some});
+        assert(verify(some) == std::nullopt);
+        assert(verify(captured) == "expected (exists y (R y y)) to be an instance of (forall x (exists y (R x y))).");
+        ProofNode* Raa = newProofNode("(R a a)", "Assumption", {});
+        ProofNode* partial = newProofNode("(exists z (R z a))", "ExistsIntro", {Raa});
+        ProofNode* inconsistent = newProofNode("(exists z (R z b))", "ExistsIntro", {Raa});
+        assert(verify(Raa) == std::nullopt);
+        assert(verify(partial) == std::nullopt);
+        assert(verify(inconsistent) != std::nullopt);
+    }
+
+    //Universal introductions need a fresh eigenvariable
+    {
+        ProofNode* all = newProofNode("(forall x (P x))", "Assumption", {});
+        ProofNode* Px = newProofNode("(P x)", "ForallElim", {all});
+        ProofNode* again = newProofNode("(forall y (P y))", "ForallIntro", {Px});
+        assert(verify(all) == std::nullopt);
+        assert(verify(Px) == std::nullopt);
+        assert(verify(again) == std::nullopt);
+        assert(again->assumptions.size() == 1 && again->assumptions.contains(all));
+
+        ProofNode* Pc = newProofNode("(P c)", "Assumption", {});
+        ProofNode* hasty = newProofNode("(forall x (P x))", "ForallIntro", {Pc});
+        assert(verify(Pc) == std::nullopt);
+        error = verifyNode(hasty);
+        assert(error && error->condition.code == VerifyErrorCode::EIGENVARIABLE);
+        assert(error->condition.roles[1] == VerifyCondition::ASSUMPTION);
+        assert(error->message() == "expected eigenvariable c of (P c) to not occur in (P c).");
+
+        ProofNode* Rxx = newProofNode("(R x x)", "ForallElim", {newProofNode("(forall x (R x x))", "Assumption", {})});
+        verify(Rxx->parents[0]);
+        assert(verify(Rxx) == std::nullopt);
+        ProofNode* leaked = newProofNode("(forall y (R y x))", "ForallIntro", {Rxx});
+        error = verifyNode(leaked);
+        assert(error && error->condition.code == VerifyErrorCode::EIGENVARIABLE);
+        ProofNode* Pf = newProofNode("(P (f x))", "ForallElim", {all});
+        ProofNode* function = newProofNode("(forall x (P x))", "ForallIntro", {Pf});
+        assert(verify(Pf) == std::nullopt);
+        error = verifyNode(function);
+        assert(error && error->condition.code == VerifyErrorCode::NOT_CONSTANT);
+    }
+
+    //Existential eliminations discharge an instance with a fresh eigenvariable
+    {
+        ProofNode* some = newProofNode("(exists x (P x))", "Assumption", {});
+        ProofNode* Pa = newProofNode("(P a)", "Assumption", {});
+        ProofNode* Q = newProofNode("Q", "Assumption", {});
+        ProofNode* PaQ = newProofNode("(and (P a) Q)", "AndIntro", {Pa, Q});
+        ProofNode* back = newProofNode("(exists y (and (P y) Q))", "ExistsIntro", {PaQ});
+        ProofNode* elim = newProofNode("(exists y (and (P y) Q))", "ExistsElim", {back, some});
+        for(ProofNode* node : {some, Pa, Q, PaQ, back, elim}){
+            assert(verify(node) == std::nullopt);
+        }
+        assert(elim->assumptions.size() == 2);
+        assert(elim->assumptions.contains(some) && elim->assumptions.contains(Q) && !elim->assumptions.contains(Pa));
+
+        ProofNode* escaped = newProofNode("(and (P a) Q)", "ExistsElim", {some, PaQ});
+        error = verifyNode(escaped);
+        assert(error && error->condition.code == VerifyErrorCode::EIGENVARIABLE);
+        assert(error->message() == "expected eigenvariable a of (P a) to not occur in (and (P a) Q).");
+        ProofNode* Qa = newProofNode("(Q a)", "Assumption", {});
+        ProofNode* QaQ = newProofNode("(or (Q a) Q)", "OrIntro", {Qa});
+        ProofNode* unrelated = newProofNode("(or (Q a) Q)", "ExistsElim", {some, QaQ});
+        assert(verify(Qa) == std::nullopt && verify(QaQ) == std::nullopt);
+        error = verifyNode(unrelated);
+        assert(error && error->condition.code == VerifyErrorCode::MISSING_INSTANCE);
+    }
+
+    //Whole graphs are verified in topological order, links are listed out of order
+    {
+        std::string json = R"json({
+            "nodes": [
+                {"id": 3, "formula": "(and A B)", "justification": "AndIntro"},
+                {"id": 1, "formula": "A", "justification": "Assumption"},
+                {"id": 2, "formula": "B", "justification": "Assumption"},
+                {"id": 4, "formula": "(or (and A B) C)", "justification": "OrIntro"},
+                {"id": 5, "formula": "(and B B)", "justification": "AndIntro"},
+                {"id": 6, "formula": "(or (and B B) C)", "justification": "OrIntro"}
+            ],
+            "links": [
+                {"from": 3, "to": 4}, {"from": 2, "to": 3}, {"from": 1, "to": 3},
+                {"from": 1, "to": 5}, {"from": 2, "to": 5}, {"from": 5, "to": 6}
+            ]
+        })json";
+        rapidjson::Document results;
+        results.Parse(verifyProofGraph(json).c_str());
+        assert(!results.HasParseError());
+        assert(results["assumptions"].Size() == 4);
+        assert(results["errors"].Size() == 2);
+        rapidjson::Value::ConstValueIterator assumptions = results["assumptions"].Begin();
+        rapidjson::Value::ConstValueIterator errors = results["errors"].Begin();
+        assert(assumptions[0]["id"].GetUint() == 1);
+        assert(assumptions[1]["id"].GetUint() == 2);
+        assert(assumptions[2]["id"].GetUint() == 3);
+        assert(assumptions[3]["id"].GetUint() == 4);
+        assert(assumptions[3]["assumptions"].Size() == 2);
+        assert(assumptions[3]["assumptions"].Begin()[0].GetUint() == 1);
+        assert(assumptions[3]["assumptions"].Begin()[1].GetUint() == 2);
+        assert(errors[0]["id"].GetUint() == 5);
+        assert(errors[1]["id"].GetUint() == 6);
+        assert(std::string(errors[1]["message"].GetString()) == "parent 5 did not verify");
+    }
+
+    //Cycles are detected rather than verified
+    {
+        std::string json = R"json({
+            "nodes": [
+                {"id": 0, "formula": "A", "justification": "Assumption"},
+                {"id": 1, "formula": "(and A A)", "justification": "AndIntro"},
+                {"id": 2, "formula": "A", "justification": "AndElim"},
+                {"id": 3, "formula": "(or A B)", "justification": "OrIntro"}
+            ],
+            "links": [
+                {"from": 0, "to": 1}, {"from": 2, "to": 1},
+                {"from": 1, "to": 2}, {"from": 2, "to": 3}
+            ]
+        })json";
+        rapidjson::Document results;
+        results.Parse(verifyProofGraph(json).c_str());
+        assert(!results.HasParseError());
+        assert(results["assumptions"].Size() == 1);
+        assert(results["errors"].Size() == 3);
+        rapidjson::Value::ConstValueIterator errors = results["errors"].Begin();
+        for(size_t i = 0; i < 3; i++){
+            assert(errors[i]["id"].GetUint() == i + 1);
+            assert(std::string(errors[i]["message"].GetString()) == "node is on or depends on a cycle");
+        }
+    }
+
+    //Graphs with quantifier rules load and verify
+    {
+        std::string json = R"json({
+            "nodes": [
+                {"id": 0, "formula": "(forall x (P x))", "justification": "Assumption"},
+                {"id": 1, "formula": "(P k)", "justification": "ForallElim"},
+                {"id": 2, "formula": "(exists x (P x))", "justification": "ExistsIntro"},
+                {"id": 3, "formula": "(forall z (P z))", "justification": "ForallIntro"},
+                {"id": 4, "formula": "(exists x (P x))", "justification": "ExistsElim"}
+            ],
+            "links": [
+                {"from": 0, "to": 1}, {"from": 1, "to": 2}, {"from": 1, "to": 3},
+                {"from": 2, "to": 4}, {"from": 2, "to": 4}
+            ]
+        })json";
+        rapidjson::Document results;
+        results.Parse(verifyProofGraph(json).c_str());
+        assert(!results.HasParseError());
+        assert(results["assumptions"].Size() == 4);
+        assert(results["errors"].Size() == 1);
+        assert(results["errors"].Begin()[0]["id"].GetUint() == 4);
+    }
+
+    //Any number of threads gives the same results
+    for(unsigned seed = 1; seed <= 4; seed++){
+        std::string json = randomProofGraph(2000, seed);
+        std::string sequential = verifyProofGraph(json);
+        assert(sequential.find("did not verify") != std::string::npos);
+        for(size_t threads : {2, 4, 7}){
+            assert(verifyProofGraph(json, threads) == sequential);
+        }
+    }
+
+    //Incremental verification agrees with verifying the whole edited graph
+    const char* justifications[] = {"Assumption", "AndIntro", "AndElim", "OrIntro"};
+    for(unsigned seed = 1; seed <= 3; seed++){
+        std::unique_ptr<ProofGraph> graph(newProofGraph(randomProofGraph(300, seed)));
+        VerificationSession session(*graph);
+        assert(session.results() == verifyProofGraph(*graph));
+        std::mt19937 rng(seed);
+        size_t nextId = graph->nodes.size();
+        for(size_t edit = 0; edit < 400; edit++){
+            std::vector<size_t> ids;
+            for(const auto& [id, _] : graph->nodes){
+                ids.push_back(id);
+            }
+            std::sort(ids.begin(), ids.end());
+            size_t id = ids[rng() % ids.size()];
+            size_t other = ids[rng() % ids.size()];
+            ProofNode* node = graph->nodes.at(id).get();
+            switch(rng() % 7){
+                case 0:
+                    session.setFormula(id, toSExpression(graph->nodes.at(other)->formula.get()));
+                    break;
+                case 1:
+                    session.setJustification(id, justifications[rng() % 4]);
+                    break;
+                case 2:
+                    //Mostly forward links, some close cycles from a descendant
+                    if(rng() % 16 == 0){
+                        ProofNode* descendant = node;
+                        for(size_t step = 0; step < 3 && !descendant->children.empty(); step++){
+                            descendant = descendant->children.front();
+                        }
+                        session.addLink(descendant->id, id);
+                    }else if(other < id){
+                        session.addLink(other, id);
+                    }
+                    break;
+                case 3:
+                case 4:
+                    if(!node->parents.empty()){
+                        session.removeLink(node->parents[rng() % node->parents.size()]->id, id);
+                    }
+                    break;
+                case 5:
+                    session.addNode(nextId++, "P" + std::to_string(rng() % 8), "Assumption");
+                    break;
+                default:
+                    if(ids.size() > 50){
+                        session.removeNode(id);
+                    }
+            }
+            session.update();
+            assert(session.results() == verifyProofGraph(*graph));
+        }
+    }
+
+    //An edit that changes nothing stops at the edited node, cycles come and go
+    {
+        std::unique_ptr<ProofGraph> graph(newProofGraph(randomProofGraph(1000, 5)));
+        VerificationSession session(*graph);
+        session.setJustification(4, "Assumption");
+        assert(session.update().empty());
+        assert(session.reverified == 1);
+
+        session.addNode(5000, "P0", "Assumption");
+        session.addNode(5001, "(and P0 P0)", "AndIntro");
+        session.addNode(5002, "P0", "AndElim");
+        session.addLink(5000, 5001);
+        session.addLink(5000, 5001);
+        session.addLink(5001, 5002);
+        assert(session.update() == std::vector<size_t>({5000, 5001, 5002}));
+        assert(session.status(5002) == NodeStatus::VERIFIED);
+
+        session.addLink(5002, 5001);
+        assert(session.update() == std::vector<size_t>({5001, 5002}));
+        assert(session.status(5001) == NodeStatus::UNREACHED);
+        assert(session.error(5002) == "node is on or depends on a cycle");
+        session.removeLink(5002, 5001);
+        assert(session.update() == std::vector<size_t>({5001, 5002}));
+        assert(session.status(5002) == NodeStatus::VERIFIED);
+
+        session.setFormula(5000, "P1");
+        assert(session.update() == std::vector<size_t>({5001, 5002}));
+        assert(session.error(5002) == "parent 5001 did not verify");
+        assert(session.results() == verifyProofGraph(*graph));
+
+        bool threw = false;
+        try{
+            session.removeLink(5002, 5000);
+        }catch(const std::runtime_error&){
+            threw = true;
+        }
+        assert(threw);
+        threw = false;
+        try{
+            session.addNode(5000, "P0", "Assumption");
+        }catch(const std::runtime_error&){
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    //A cache of rule verdicts gives the same results across proofs and threads
+    {
+        std::string json = randomProofGraph(2000, 7);
+        std::string uncached = verifyProofGraph(json);
+        VerifyCache cache;
+        assert(verifyProofGraph(json, 1, &cache) == uncached);
+        VerifyCache::Stats first = cache.stats();
+        assert(first.misses > 0 && first.entries > 0 && first.evictions == 0);
+        for(size_t threads : {1, 2, 4}){
+            assert(verifyProofGraph(json, threads, &cache) == uncached);
+        }
+        VerifyCache::Stats later = cache.stats();
+        assert(later.hits >= 3 * (first.hits + first.misses));
+        assert(later.entries == first.entries);
+
+        std::unique_ptr<ProofGraph> graph(newProofGraph(json));
+        VerificationSession session(*graph, &cache);
+        assert(session.results() == uncached);
+
+        //A full cache evicts its least recently used entries
+        VerifyCache small(4, 1);
+        assert(verifyProofGraph(json, 2, &small) == uncached);
+        assert(small.stats().evictions > 0 && small.stats().entries == 4);
+        small.clear();
+        assert(small.stats().entries == 0 && small.stats().evictions == 0);
+    }
+
+    //Cached verdicts of rules reading assumptions are checked against the node's own
+    {
+        VerifyCache cache;
+        ProofNode* a = newProofNode("A", "Assumption", {});
+        ProofNode* discharged = newProofNode("(if A A)", "IfIntro", {a});
+        assert(!verifyNode(a, &cache) && !verifyNode(discharged, &cache));
+
+        ProofNode* both = newProofNode("(and A A)", "Assumption", {});
+        ProofNode* left = newProofNode("A", "AndElim", {both});
+        ProofNode* undischarged = newProofNode("(if A A)", "IfIntro", {left});
+        assert(!verifyNode(both, &cache) && !verifyNode(left, &cache));
+        std::optional<VerifyError> err = verifyNode(undischarged, &cache);
+        assert(err && err->condition.code == VerifyErrorCode::MISSING_ASSUMPTION);
+        assert(!verifyNode(discharged, &cache));
+        VerifyCache::Stats stats = cache.stats();
+        assert(stats.hits == 1 && stats.misses == 3);
+
+        //Failures of other rules are cached with the assignment they are reported for
+        ProofNode* wrong = newProofNode("(or B C)", "OrIntro", {a});
+        std::string message = verifyNode(wrong, &cache)->message();
+        assert(verifyNode(wrong, &cache)->message() == message);
+        assert(cache.stats().hits == 2);
+    }
+
+    //Batches give each graph's results in input order, rejecting bad json alone
+    {
+        std::vector<std::string> jsons;
+        for(unsigned seed = 0; seed < 12; seed++){
+            jsons.push_back(randomProofGraph(50 + 40 * seed, seed));
+        }
+        jsons[3] = "{\"nodes\": [";
+        jsons[8] = "{\"nodes\": [{\"id\": 0, \"formula\": \"A\", \"justification\": \"Guess\"}], \"links\": []}";
+        std::vector<std::string_view> views(jsons.begin(), jsons.end());
+        VerifyCache cache;
+        for(size_t threads : {1, 3, 0}){
+            std::vector<BatchResult> results = verifyBatch(views, threads, threads == 3 ? &cache : nullptr);
+            assert(results.size() == jsons.size());
+            for(size_t i = 0; i < jsons.size(); i++){
+                if(i == 3 || i == 8){
+                    assert(results[i].results.empty() && !results[i].error.empty());
+                }else{
+                    assert(results[i].error.empty());
+                    assert(results[i].results == verifyProofGraph(jsons[i]));
+                }
+            }
+        }
+        assert(verifyBatch(std::span<const std::string_view>()).empty());
+
+        //A parser reads graph after graph into the same arena
+        ProofGraphParser parser;
+        for(size_t i : {0, 1, 0}){
+            std::unique_ptr<ProofGraph> graph(parser.parse(jsons[i]));
+            assert(verifyProofGraph(*graph) == verifyProofGraph(jsons[i]));
+        }
+    }
+}